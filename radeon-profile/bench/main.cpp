@@ -0,0 +1,1486 @@
+// rp-bench, runs the sampling cycle of radeon-profile without the ui
+// and reports latency of every sub-step, read/write syscalls and allocations per cycle
+
+#include "gpu.h"
+#include "dxorg.h"
+#include "globalStuff.h"
+#include "ioctlBackend.h"
+#include "samplerThread.h"
+#include "sysfsAttribute.h"
+#include "daemonSharedMem.h"
+#include "pmInfoParser.h"
+#include "daemonCommand.h"
+#include "daemonComm.h"
+#include "timeSeriesStore.h"
+#include "seriesDecimator.h"
+#include "historyFile.h"
+#include "mockDaemon.h"
+#include "components/rpplot.h"
+
+#include <QApplication>
+#include <QVBoxLayout>
+#include <QCommandLineParser>
+#include <QProcessEnvironment>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QFile>
+#include <QDir>
+#include <QTemporaryDir>
+#include <QMap>
+#include <QRegExp>
+#include <QRegularExpression>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <unistd.h> // geteuid()
+#include <time.h> // clock_gettime()
+#include <cstring>
+
+static std::atomic<unsigned long> allocationCount(0);
+
+#ifdef __GLIBC__
+// count every allocation in the process (Qt containers use malloc directly, not operator new)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) noexcept {
+    ++allocationCount;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+    ++allocationCount;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept {
+    ++allocationCount;
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+enum Step {
+    STEP_POWER_LEVEL,
+    STEP_SENSORS,
+    STEP_CLOCKS,
+    STEP_TEMPERATURE,
+    STEP_USAGE,
+    STEP_FAN,
+    STEP_POWER_CAP,
+    STEP_COUNT
+};
+
+static const char *stepNames[STEP_COUNT] = {
+    "power level",
+    "ioctl sensors",
+    "clocks",
+    "temperature",
+    "usage",
+    "fan",
+    "power cap"
+};
+
+// read and write syscalls of this process, from task io accounting, -1 if not available
+static long long readSyscallCount() {
+    QFile f("/proc/self/io");
+    if (!f.open(QIODevice::ReadOnly))
+        return -1;
+
+    long long count = 0;
+    for (const QByteArray &line : f.readAll().split('\n')) {
+        if (line.startsWith("syscr:") || line.startsWith("syscw:"))
+            count += line.mid(6).trimmed().toLongLong();
+    }
+
+    return count;
+}
+
+static qint64 percentile(std::vector<qint64> &samples, double p) {
+    if (samples.empty())
+        return 0;
+
+    const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+static void printRow(QTextStream &out, const QString &name, std::vector<qint64> &samples) {
+    const qint64 max = *std::max_element(samples.begin(), samples.end());
+
+    out << qSetFieldWidth(14) << left << name
+        << QString::number(percentile(samples, 0.50) / 1000.0, 'f', 1)
+        << QString::number(percentile(samples, 0.99) / 1000.0, 'f', 1)
+        << QString::number(max / 1000.0, 'f', 1) << qSetFieldWidth(0) << endl;
+}
+
+// one attribute read as the sampler does it (fd kept open, pread) and as it was done before (open, read, close)
+static void measureSysfsRead(int cycles, std::vector<qint64> *preadTimes, std::vector<qint64> *qfileTimes) {
+    const QString path = QDir::tempPath() + "/rp-bench-attribute";
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    f.write("1150000\n");
+    f.close();
+
+    SysfsAttribute attribute(path);
+    QElapsedTimer timer;
+    long long value;
+    qint64 sum = 0;
+
+    preadTimes->reserve(cycles);
+    qfileTimes->reserve(cycles);
+
+    for (int i = 0; i < cycles; ++i) {
+        timer.start();
+        if (attribute.readInt(&value))
+            sum += value;
+        preadTimes->push_back(timer.nsecsElapsed());
+
+        timer.start();
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            sum += QString(file.readAll()).trimmed().toLongLong();
+        file.close();
+        qfileTimes->push_back(timer.nsecsElapsed());
+    }
+
+    QFile::remove(path);
+
+    // keeps the reads from being optimized out
+    static volatile qint64 sink;
+    sink = sum;
+}
+
+// radeon pm_info as the daemon copies it
+static const char pmInfoSample[] =
+        "uvd    vclk: 0 dclk: 0\n"
+        "power level 2    sclk: 105000 mclk: 125000 vddc: 1150 vddci: 1000\n";
+
+// client side of one tick with daemon data, shared memory block written by the bench instead of the daemon
+static void measureDaemonPayload(int cycles, std::vector<qint64> *textTimes, std::vector<qint64> *recordTimes) {
+    std::vector<qint64> block(SHARED_MEM_SIZE / sizeof(qint64));
+    char buffer[SHARED_MEM_SIZE];
+    qint64 timestamp;
+    DaemonSharedMem::PayloadFormat format;
+    QElapsedTimer timer;
+
+    DaemonSharedMem::write(block.data(), SHARED_MEM_SIZE, pmInfoSample, sizeof(pmInfoSample) - 1, 0);
+    const PmInfoParser::Layout layout = PmInfoParser::detectLayout(DriverModule::RADEON, pmInfoSample, sizeof(pmInfoSample) - 1);
+
+    for (int i = 0; i < cycles; ++i) {
+        timer.start();
+        const int length = DaemonSharedMem::read(block.data(), SHARED_MEM_SIZE, buffer, sizeof(buffer), &timestamp, &format);
+        PmInfoParser::parse(layout, buffer, length);
+        textTimes->push_back(timer.nsecsElapsed());
+    }
+
+    const DaemonClocksRecord record = { 1050, 1250, -1, -1, 1150, 1000, 2, 0, 0 };
+    DaemonSharedMem::write(block.data(), SHARED_MEM_SIZE, reinterpret_cast<const char*>(&record), sizeof(record), 0,
+                           DaemonSharedMem::PAYLOAD_CLOCKS_RECORD);
+
+    for (int i = 0; i < cycles; ++i) {
+        timer.start();
+        const int length = DaemonSharedMem::read(block.data(), SHARED_MEM_SIZE, buffer, sizeof(buffer), &timestamp, &format);
+        PmInfoParser::parseRecord(buffer, length);
+        recordTimes->push_back(timer.nsecsElapsed());
+    }
+}
+
+// synthetic machine of the startup bench, cards have no hwmon dir of their own,
+// so the temperature is looked up among chips of every other device in /sys/class/hwmon
+#define STARTUP_BENCH_CARDS 8
+#define STARTUP_BENCH_HWMON_CHIPS 40
+
+static bool writeBenchFile(const QString &path, const QByteArray &content) {
+    QFile f(path);
+    if (!QDir().mkpath(QFileInfo(path).path()) || !f.open(QIODevice::WriteOnly))
+        return false;
+
+    return f.write(content) == content.size();
+}
+
+// tree as the kernel lays it out, class dirs link to devices, one amdgpu chip per card after chips of other drivers
+static bool createSyntheticSysfs(const QString &root) {
+    static const char *otherChips[] = { "k10temp", "nct6775", "nvme", "acpitz", "iwlwifi_1" };
+    bool success = true;
+
+    for (int card = 0; card < STARTUP_BENCH_CARDS; ++card) {
+        const QString device = QString("%1/sys/devices/pci0000:00/0000:00:%2.0/0000:%2:00.0").arg(root).arg(card + 1, 2, 10, QChar('0'));
+        const QString cardName = "card" + QString::number(card);
+
+        success &= writeBenchFile(device + "/uevent", "DRIVER=amdgpu\nPCI_CLASS=30000\n");
+        success &= writeBenchFile(device + "/power_dpm_state", "performance\n");
+        success &= writeBenchFile(device + "/power_dpm_force_performance_level", "auto\n");
+        success &= writeBenchFile(device + "/gpu_busy_percent", "0\n");
+        success &= QDir().mkpath(root + "/sys/class/drm/" + cardName);
+        success &= QFile::link(device, root + "/sys/class/drm/" + cardName + "/device");
+
+        // connectors and render nodes are in the same dir
+        success &= QDir().mkpath(root + "/sys/class/drm/" + cardName + "-DP-1");
+        success &= QDir().mkpath(root + "/sys/class/drm/renderD" + QString::number(128 + card));
+    }
+
+    const int firstCardChip = STARTUP_BENCH_HWMON_CHIPS - STARTUP_BENCH_CARDS;
+
+    for (int chip = 0; chip < STARTUP_BENCH_HWMON_CHIPS; ++chip) {
+        const QString hwmon = root + "/sys/class/hwmon/hwmon" + QString::number(chip);
+        const bool cardChip = chip >= firstCardChip;
+        const QString device = cardChip
+                ? QString("%1/sys/devices/pci0000:00/0000:00:%2.0/0000:%2:00.0").arg(root).arg(chip - firstCardChip + 1, 2, 10, QChar('0'))
+                : root + "/sys/devices/platform/chip." + QString::number(chip);
+
+        success &= writeBenchFile(hwmon + "/name", QByteArray(cardChip ? "amdgpu" : otherChips[chip % 5]) + "\n");
+        success &= QDir().mkpath(device);
+        success &= QFile::link(device, hwmon + "/device");
+
+        for (int input = 1; input <= (cardChip ? 1 : 3); ++input) {
+            const QString prefix = hwmon + "/temp" + QString::number(input);
+            success &= writeBenchFile(prefix + "_input", QByteArray::number(40000 + chip * 100 + input) + "\n");
+            success &= writeBenchFile(prefix + "_label", cardChip ? "edge\n" : "Tctl\n");
+        }
+    }
+
+    return success;
+}
+
+enum StartupPart {
+    STARTUP_DETECT,
+    STARTUP_PATHS,
+    STARTUP_HANDLERS,
+    STARTUP_TOTAL,
+    STARTUP_PART_COUNT
+};
+
+static const char *startupPartNames[STARTUP_PART_COUNT] = {
+    "detect cards",
+    "data paths",
+    "handlers",
+    "startup"
+};
+
+/**
+ * @brief Time card detection and handler setup on the synthetic tree, as gpu::initialize() does it.
+ * Handlers are made as without root and daemon, their setup includes the data paths and the temperature lookup.
+ * @return Number of cards whose temperature input was found, -1 if the tree could not be made.
+ */
+static int measureStartup(int runs, std::vector<qint64> times[STARTUP_PART_COUNT]) {
+    QTemporaryDir root;
+    if (!root.isValid() || !createSyntheticSysfs(root.path()))
+        return -1;
+
+    const QString previousRoot = globalStuff::systemRoot();
+    globalStuff::setSystemRoot(root.path());
+
+    const dXorg::InitializationConfig config(false, false, false);
+    QElapsedTimer timer;
+    int temperatureFound = 0;
+
+    for (int part = 0; part < STARTUP_PART_COUNT; ++part)
+        times[part].reserve(runs);
+
+    for (int run = 0; run < runs; ++run) {
+        gpu device;
+
+        timer.start();
+        device.detectCards();
+        const qint64 detected = timer.nsecsElapsed();
+
+        std::vector<std::unique_ptr<dXorg>> handlers;
+        for (const GPUSysInfo &info : device.gpuList)
+            handlers.emplace_back(new dXorg(info, config));
+
+        const qint64 done = timer.nsecsElapsed();
+
+        // paths alone, the handlers have them already
+        timer.start();
+        for (const std::unique_ptr<dXorg> &handler : handlers)
+            handler->figureOutGpuDataFilePaths(handler->features.sysInfo.sysName);
+
+        times[STARTUP_PATHS].push_back(timer.nsecsElapsed());
+        times[STARTUP_DETECT].push_back(detected);
+        times[STARTUP_HANDLERS].push_back(done - detected);
+        times[STARTUP_TOTAL].push_back(done);
+
+        temperatureFound = 0;
+        for (const std::unique_ptr<dXorg> &handler : handlers)
+            temperatureFound += handler->features.currentTemperatureSensor == TemperatureSensor::PCI_SENSOR;
+    }
+
+    globalStuff::setSystemRoot(previousRoot);
+    return temperatureFound;
+}
+
+// GPUDataContainer as it was before the array layout, for the refresh cycle comparison
+typedef QMap<ValueID, RPValue> MapDataContainer;
+
+// plots and topbar of the default layout, 6 plots with 2 clocks and 2 percents
+#define CYCLE_BENCH_PLOTS 6
+
+enum CyclePart {
+    PART_REFRESH,
+    PART_PLOT,
+    PART_TOPBAR,
+    PART_CYCLE,
+    PART_COUNT
+};
+
+static const char *cyclePartNames[PART_COUNT] = {
+    "refresh",
+    "plot",
+    "topbar",
+    "cycle"
+};
+
+template <typename Container>
+static void fillAllValues(Container *data) {
+    for (int id = 0; id < ValueID::VALUE_ID_COUNT; ++id)
+        data->insert(static_cast<ValueID>(id), RPValue(globalStuff::getUnitFomValueId(static_cast<ValueID>(id)), 0));
+}
+
+// values written as SamplerThread does it, every field checked with contains() first
+template <typename Container>
+static void refreshValues(Container &data, int tick) {
+    static const ValueID clocks[] = { ValueID::CLK_CORE, ValueID::VOLT_CORE, ValueID::CLK_MEM, ValueID::VOLT_MEM,
+                                      ValueID::CLK_UVD, ValueID::DCLK_UVD, ValueID::POWER_LEVEL };
+
+    for (ValueID id : clocks)
+        if (data.contains(id))
+            data[id].setValue(300 + (tick * 7) % 1200);
+
+    if (data.contains(ValueID::TEMPERATURE_CURRENT)) {
+        const float current = 40 + tick % 50;
+        data[ValueID::TEMPERATURE_BEFORE_CURRENT].setValue(data.value(ValueID::TEMPERATURE_CURRENT).value);
+        data[ValueID::TEMPERATURE_CURRENT].setValue(current);
+
+        if (data.value(ValueID::TEMPERATURE_MIN).value > current)
+            data[ValueID::TEMPERATURE_MIN].setValue(current);
+        else if (data.value(ValueID::TEMPERATURE_MAX).value < current)
+            data[ValueID::TEMPERATURE_MAX].setValue(current);
+    }
+
+    static const ValueID others[] = { ValueID::GPU_USAGE_PERCENT, ValueID::GPU_VRAM_USAGE_MB, ValueID::GPU_VRAM_USAGE_PERCENT,
+                                      ValueID::FAN_SPEED_PERCENT, ValueID::FAN_SPEED_RPM,
+                                      ValueID::POWER_CAP_SELECTED, ValueID::POWER_CAP_AVERAGE };
+
+    for (ValueID id : others)
+        if (data.contains(id))
+            data[id].setValue((tick * 3) % 100);
+}
+
+// per series value lookup and axis fit of a plot refresh, without the widgets
+template <typename Container>
+static float plotValues(const Container &data) {
+    static const ValueID series[] = { ValueID::CLK_CORE, ValueID::CLK_MEM, ValueID::GPU_USAGE_PERCENT, ValueID::GPU_VRAM_USAGE_PERCENT };
+    float axisRange = 0;
+
+    for (int plot = 0; plot < CYCLE_BENCH_PLOTS; ++plot) {
+        float min = 0, max = 0;
+
+        for (ValueID id : series) {
+            if (!data.contains(id) || globalStuff::getUnitFomValueId(id) == ValueUnit::PERCENT)
+                continue;
+
+            const float value = data.value(id).value;
+            min = qMin(min, value - 100);
+            max = qMax(max, value + 150);
+        }
+
+        axisRange += max - min;
+    }
+
+    return axisRange;
+}
+
+// text of the default topbar: clocks label pair, temperature label and fan, usage and vram pies
+template <typename Container>
+static float topbarValues(const Container &data) {
+    static const ValueID labels[] = { ValueID::CLK_CORE, ValueID::CLK_MEM, ValueID::TEMPERATURE_CURRENT };
+    static const ValueID pies[] = { ValueID::FAN_SPEED_PERCENT, ValueID::GPU_USAGE_PERCENT, ValueID::GPU_VRAM_USAGE_PERCENT };
+    float sum = 0;
+
+    for (ValueID id : labels)
+        sum += data.value(id).strValue().length();
+
+    // pie reads the value for both slices and the label, as PieProgressBar::updateValue()
+    for (ValueID id : pies) {
+        sum += data.value(id).value;
+        sum += 100 - data.value(id).value;
+        sum += data.value(id).strValue().length();
+    }
+
+    return sum;
+}
+
+template <typename Container>
+static void measureRefreshCycle(int cycles, std::vector<qint64> times[PART_COUNT]) {
+    Container data;
+    fillAllValues(&data);
+
+    QElapsedTimer timer;
+    double sum = 0;
+
+    for (int part = 0; part < PART_COUNT; ++part)
+        times[part].reserve(cycles);
+
+    for (int i = 0; i < cycles; ++i) {
+        timer.start();
+        refreshValues(data, i);
+        const qint64 refreshed = timer.nsecsElapsed();
+
+        sum += plotValues(data);
+        const qint64 plotted = timer.nsecsElapsed();
+
+        sum += topbarValues(data);
+        const qint64 done = timer.nsecsElapsed();
+
+        times[PART_REFRESH].push_back(refreshed);
+        times[PART_PLOT].push_back(plotted - refreshed);
+        times[PART_TOPBAR].push_back(done - plotted);
+        times[PART_CYCLE].push_back(done);
+    }
+
+    // keeps the reads from being optimized out
+    static volatile double sink;
+    sink = sum;
+}
+
+// pm_info patterns as dXorg::setupRegex() had them before PmInfoParser, an empty pattern never matches
+struct LegacyPmInfoPatterns {
+    QString powerLevel, sclk, mclk, vclk, dclk, vddc, vddci;
+    int matchIndex = 1, valueDivider = 100;
+};
+
+static LegacyPmInfoPatterns legacySetupRegex(DriverModule module, const QString &data) {
+    LegacyPmInfoPatterns patterns;
+    QRegExp rx;
+
+    if (module == DriverModule::AMDGPU) {
+        rx.setPattern("\\[\\s+sclk\\s+\\]:\\s\\d+");
+        rx.indexIn(data);
+        if (!rx.cap(0).isEmpty()) {
+            patterns.sclk = "\\[\\s+sclk\\s+\\]:\\s\\d+";
+            patterns.mclk = "\\[\\s+mclk\\s+\\]:\\s\\d+";
+            patterns.matchIndex = 3;
+            patterns.valueDivider = 1;
+            return patterns;
+        }
+
+        rx.setPattern("\\d+\\s\\w+\\s\\(SCLK\\)");
+        rx.indexIn(data);
+        if (!rx.cap(0).isEmpty()) {
+            patterns.sclk = "\\d+\\s\\w+\\s\\(SCLK\\)";
+            patterns.mclk = "\\d+\\s\\w+\\s\\(MCLK\\)";
+            patterns.matchIndex = 0;
+            patterns.valueDivider = 1;
+            return patterns;
+        }
+    }
+
+    rx.setPattern("sclk:\\s\\d+");
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty()) {
+        patterns.powerLevel = "power\\slevel\\s\\d";
+        patterns.sclk = "sclk:\\s\\d+";
+        patterns.mclk = "mclk:\\s\\d+";
+        patterns.vclk = "vclk:\\s\\d+";
+        patterns.dclk = "dclk:\\s\\d+";
+        patterns.vddc = "vddc:\\s\\d+";
+        patterns.vddci = "vddci:\\s\\d+";
+    }
+
+    return patterns;
+}
+
+// pm_info parsed as dXorg::getClocks() did it before PmInfoParser, seven scans of the whole text
+static GPUClocks legacyParse(const LegacyPmInfoPatterns &patterns, const char *buffer, int length) {
+    const QString data = QString::fromLatin1(buffer, length);
+    GPUClocks clocksData;
+    QRegExp rx;
+
+    rx.setPattern(patterns.powerLevel);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty())
+        clocksData.powerLevel = rx.cap(0).split(' ')[2].toShort();
+
+    rx.setPattern(patterns.sclk);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty())
+        clocksData.coreClk = rx.cap(0).split(' ', QString::SkipEmptyParts)[patterns.matchIndex].toFloat() / patterns.valueDivider;
+
+    rx.setPattern(patterns.mclk);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty())
+        clocksData.memClk = rx.cap(0).split(' ', QString::SkipEmptyParts)[patterns.matchIndex].toFloat() / patterns.valueDivider;
+
+    rx.setPattern(patterns.vclk);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty()) {
+        clocksData.uvdCClk = rx.cap(0).split(' ', QString::SkipEmptyParts)[patterns.matchIndex].toFloat() / patterns.valueDivider;
+        clocksData.uvdCClk = (clocksData.uvdCClk == 0) ? -1 : clocksData.uvdCClk;
+    }
+
+    rx.setPattern(patterns.dclk);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty()) {
+        clocksData.uvdDClk = rx.cap(0).split(' ', QString::SkipEmptyParts)[patterns.matchIndex].toFloat() / patterns.valueDivider;
+        clocksData.uvdDClk = (clocksData.uvdDClk == 0) ? -1 : clocksData.uvdDClk;
+    }
+
+    rx.setPattern(patterns.vddc);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty())
+        clocksData.coreVolt = rx.cap(0).split(' ', QString::SkipEmptyParts)[patterns.matchIndex].toInt();
+
+    rx.setPattern(patterns.vddci);
+    rx.indexIn(data);
+    if (!rx.cap(0).isEmpty())
+        clocksData.memVolt = rx.cap(0).split(' ', QString::SkipEmptyParts)[patterns.matchIndex].toInt();
+
+    return clocksData;
+}
+
+// the stopgap asked for before PmInfoParser: patterns compiled once, values taken from a capture group
+struct CompiledPmInfoPatterns {
+    QRegularExpression powerLevel, sclk, mclk, vclk, dclk, vddc, vddci;
+    int valueDivider = 100;
+};
+
+static CompiledPmInfoPatterns compilePmInfoPatterns(const LegacyPmInfoPatterns &legacy) {
+    CompiledPmInfoPatterns patterns;
+    patterns.valueDivider = legacy.valueDivider;
+
+    if (legacy.matchIndex == 3) {
+        patterns.sclk.setPattern("\\[\\s+sclk\\s+\\]:\\s(\\d+)");
+        patterns.mclk.setPattern("\\[\\s+mclk\\s+\\]:\\s(\\d+)");
+    } else if (legacy.matchIndex == 0) {
+        patterns.sclk.setPattern("(\\d+)\\s\\w+\\s\\(SCLK\\)");
+        patterns.mclk.setPattern("(\\d+)\\s\\w+\\s\\(MCLK\\)");
+    } else if (!legacy.sclk.isEmpty()) {
+        patterns.powerLevel.setPattern("power\\slevel\\s(\\d+)");
+        patterns.sclk.setPattern("sclk:\\s(\\d+)");
+        patterns.mclk.setPattern("mclk:\\s(\\d+)");
+        patterns.vclk.setPattern("vclk:\\s(\\d+)");
+        patterns.dclk.setPattern("dclk:\\s(\\d+)");
+        patterns.vddc.setPattern("vddc:\\s(\\d+)");
+        patterns.vddci.setPattern("vddci:\\s(\\d+)");
+    }
+
+    return patterns;
+}
+
+// first capture of the pattern as a number, -1 if the layout has no such value or it isn't found
+static int capturedValue(const QRegularExpression &rx, const QString &data) {
+    if (rx.pattern().isEmpty())
+        return -1;
+
+    const QRegularExpressionMatch match = rx.match(data);
+    return match.hasMatch() ? match.captured(1).toInt() : -1;
+}
+
+static GPUClocks compiledParse(const CompiledPmInfoPatterns &patterns, const char *buffer, int length) {
+    const QString data = QString::fromLatin1(buffer, length);
+    GPUClocks clocksData;
+
+    clocksData.powerLevel = capturedValue(patterns.powerLevel, data);
+    clocksData.coreVolt = capturedValue(patterns.vddc, data);
+    clocksData.memVolt = capturedValue(patterns.vddci, data);
+
+    int *clocks[4] = { &clocksData.coreClk, &clocksData.memClk, &clocksData.uvdCClk, &clocksData.uvdDClk };
+    const QRegularExpression *clockPatterns[4] = { &patterns.sclk, &patterns.mclk, &patterns.vclk, &patterns.dclk };
+
+    for (int i = 0; i < 4; ++i) {
+        const int value = capturedValue(*clockPatterns[i], data);
+        if (value != -1)
+            *clocks[i] = value / patterns.valueDivider;
+    }
+
+    // uvd clocks are 0 when uvd is off
+    clocksData.uvdCClk = (clocksData.uvdCClk == 0) ? -1 : clocksData.uvdCClk;
+    clocksData.uvdDClk = (clocksData.uvdDClk == 0) ? -1 : clocksData.uvdDClk;
+
+    return clocksData;
+}
+
+static bool sameClocks(const GPUClocks &a, const GPUClocks &b) {
+    return a.powerLevel == b.powerLevel && a.coreClk == b.coreClk && a.memClk == b.memClk && a.uvdCClk == b.uvdCClk
+            && a.uvdDClk == b.uvdDClk && a.coreVolt == b.coreVolt && a.memVolt == b.memVolt;
+}
+
+// captured pm_info with the clocks it has to give, golden files of tests/tst_pmInfoParser
+struct PmInfoSample {
+    QString name;
+    DriverModule module;
+    QByteArray data;
+    GPUClocks expected;
+};
+
+static QVector<PmInfoSample> loadPmInfoSamples(const QString &path) {
+    QVector<PmInfoSample> samples;
+    const QDir dir(path);
+
+    for (const QString &file : dir.entryList(QStringList() << "*.pm_info", QDir::Files, QDir::Name)) {
+        PmInfoSample sample;
+        sample.name = file.left(file.length() - int(strlen(".pm_info")));
+
+        QFile data(dir.filePath(file)), expected(dir.filePath(sample.name + ".expected"));
+        if (!data.open(QIODevice::ReadOnly) || !expected.open(QIODevice::ReadOnly | QIODevice::Text))
+            continue;
+
+        sample.data = data.readAll();
+
+        QMap<QString, QString> values;
+        for (const QString &line : QString(expected.readAll()).split('\n', QString::SkipEmptyParts)) {
+            const int eq = line.indexOf('=');
+            if (eq > 0)
+                values.insert(line.left(eq), line.mid(eq + 1));
+        }
+
+        sample.module = values.value("module") == "radeon" ? DriverModule::RADEON : DriverModule::AMDGPU;
+        sample.expected.powerLevel = values.value("powerLevel").toInt();
+        sample.expected.coreClk = values.value("coreClk").toInt();
+        sample.expected.memClk = values.value("memClk").toInt();
+        sample.expected.uvdCClk = values.value("uvdCClk").toInt();
+        sample.expected.uvdDClk = values.value("uvdDClk").toInt();
+        sample.expected.coreVolt = values.value("coreVolt").toInt();
+        sample.expected.memVolt = values.value("memVolt").toInt();
+
+        samples.append(sample);
+    }
+
+    return samples;
+}
+
+// parses of every capture in the --pm-info-parse mode
+#define PM_INFO_BENCH_ITERATIONS 100000
+
+struct PmInfoResult {
+    std::vector<qint64> legacyTimes, compiledTimes, parserTimes;
+    bool legacyCorrect = true, compiledCorrect = true, parserCorrect = true;
+};
+
+// one sample parsed with the seven QRegExp scans, with precompiled QRegularExpressions and with PmInfoParser,
+// patterns and layout found once as on start
+static void measurePmInfoParse(int iterations, const PmInfoSample &sample, PmInfoResult *result) {
+    const char *data = sample.data.constData();
+    const int length = sample.data.size();
+    const LegacyPmInfoPatterns patterns = legacySetupRegex(sample.module, QString::fromLatin1(data, length));
+    const CompiledPmInfoPatterns compiledPatterns = compilePmInfoPatterns(patterns);
+    const PmInfoParser::Layout layout = PmInfoParser::detectLayout(sample.module, data, length);
+    QElapsedTimer timer;
+
+    result->legacyTimes.reserve(iterations);
+    result->compiledTimes.reserve(iterations);
+    result->parserTimes.reserve(iterations);
+
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        const GPUClocks legacy = legacyParse(patterns, data, length);
+        result->legacyTimes.push_back(timer.nsecsElapsed());
+
+        timer.start();
+        const GPUClocks compiled = compiledParse(compiledPatterns, data, length);
+        result->compiledTimes.push_back(timer.nsecsElapsed());
+
+        timer.start();
+        const GPUClocks parsed = PmInfoParser::parse(layout, data, length);
+        result->parserTimes.push_back(timer.nsecsElapsed());
+
+        result->legacyCorrect &= sameClocks(legacy, sample.expected);
+        result->compiledCorrect &= sameClocks(compiled, sample.expected);
+        result->parserCorrect &= sameClocks(parsed, sample.expected);
+    }
+}
+
+static qint64 totalTime(const std::vector<qint64> &samples) {
+    qint64 sum = 0;
+    for (qint64 sample : samples)
+        sum += sample;
+
+    return sum;
+}
+
+static void printPmInfoResults(QTextStream &out, const QVector<PmInfoSample> &samples, QVector<PmInfoResult> &results) {
+    out << "pm_info parse (seven QRegExp scans as before / precompiled QRegularExpression / PmInfoParser)" << endl;
+    out << qSetFieldWidth(14) << left << "parse" << "p50 [us]" << "p99 [us]" << "max [us]" << qSetFieldWidth(0) << endl;
+
+    for (int i = 0; i < samples.count(); ++i) {
+        PmInfoResult &r = results[i];
+        out << samples.at(i).name << ", " << samples.at(i).data.size() << " B, all parses [ms]: "
+            << QString::number(totalTime(r.legacyTimes) / 1000000.0, 'f', 1) << " / "
+            << QString::number(totalTime(r.compiledTimes) / 1000000.0, 'f', 1) << " / "
+            << QString::number(totalTime(r.parserTimes) / 1000000.0, 'f', 1) << endl;
+
+        printRow(out, "QRegExp", r.legacyTimes);
+        printRow(out, "compiled", r.compiledTimes);
+        printRow(out, "parser", r.parserTimes);
+
+        if (!r.legacyCorrect || !r.compiledCorrect || !r.parserCorrect)
+            out << "result differs from .expected:" << (r.legacyCorrect ? "" : " QRegExp")
+                << (r.compiledCorrect ? "" : " compiled") << (r.parserCorrect ? "" : " parser") << endl;
+    }
+}
+
+struct EncodingResult {
+    std::vector<qint64> times;
+    int bytes = 0;
+};
+
+static DaemonCommand fanCommand(int speed) {
+    return DaemonCommand().setValue("/sys/class/drm/card0/device/hwmon/hwmon0/pwm1", QString::number(speed % 256));
+}
+
+// 8 state overclock table written as one batch, as dXorg::setOcTable() does it
+static DaemonCommand ocTableCommand() {
+    DaemonCommand ocTable;
+    for (int state = 0; state < 8; ++state)
+        ocTable.setValue("/sys/class/drm/card0/device/pp_od_clk_voltage",
+                         "s " + QString::number(state) + " " + QString::number(300 + state * 150) + " " + QString::number(800 + state * 50));
+
+    return ocTable;
+}
+
+// client side of daemon writes, a fan speed write and an overclock table
+static void measureCommandEncoding(int cycles, EncodingResult results[4]) {
+    QElapsedTimer timer;
+
+    for (int i = 0; i < 4; ++i)
+        results[i].times.reserve(cycles);
+
+    for (int i = 0; i < cycles; ++i) {
+        const DaemonCommand fan = fanCommand(i), ocTable = ocTableCommand();
+
+        timer.start();
+        results[0].bytes = fan.toLegacy().size();
+        results[0].times.push_back(timer.nsecsElapsed());
+
+        timer.start();
+        results[1].bytes = fan.toFrame(i).size();
+        results[1].times.push_back(timer.nsecsElapsed());
+
+        timer.start();
+        results[2].bytes = ocTable.toLegacy().size();
+        results[2].times.push_back(timer.nsecsElapsed());
+
+        timer.start();
+        results[3].bytes = ocTable.toFrame(i).size();
+        results[3].times.push_back(timer.nsecsElapsed());
+    }
+}
+
+// longest wait for the mock daemon, in ms
+#define ROUND_TRIP_TIMEOUT 1000
+
+// runs the event loop until the condition is met, false on timeout
+template <typename Condition>
+static bool waitFor(Condition done) {
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!done()) {
+        if (timer.elapsed() > ROUND_TRIP_TIMEOUT)
+            return false;
+
+        QCoreApplication::processEvents();
+    }
+
+    return true;
+}
+
+enum RoundTrip {
+    TRIP_FAN,
+    TRIP_FAN_STATUS,
+    TRIP_OC_TABLE,
+    TRIP_OC_TABLE_STATUS,
+    TRIP_COUNT
+};
+
+static const char *roundTripNames[TRIP_COUNT] = {
+    "fan",
+    "fan status",
+    "oc table",
+    "oc status"
+};
+
+struct RoundTripResult {
+    std::vector<qint64> times[TRIP_COUNT];  // status only with frames
+    int timeouts = 0;
+    bool connected = false;
+};
+
+/**
+ * @brief Send fan writes and overclock tables through DaemonComm to the mock daemon of tests, one at a time.
+ * Timed until the daemon decoded every instruction of the command and, with frames, until its status came back.
+ */
+static void measureDaemonRoundTrip(int cycles, MockDaemon::Protocol protocol, RoundTripResult *result) {
+    MockDaemon daemon(protocol);
+    DaemonComm comm;
+    quint32 finishedId = 0;
+
+    QObject::connect(&comm, &DaemonComm::commandFinished, [&finishedId](quint32 requestId, int status) {
+        Q_UNUSED(status);
+        finishedId = requestId;
+    });
+
+    if (!daemon.listen())
+        return;
+
+    // a legacy daemon ignores the hello, so the client never switches to frames
+    const bool framed = protocol == MockDaemon::FRAMED;
+    comm.connectToDaemon(daemon.serverName());
+    result->connected = waitFor([&daemon, &comm, framed]() { return daemon.isClientConnected() && comm.isFramed() == framed; });
+
+    if (!result->connected)
+        return;
+
+    for (auto &times : result->times)
+        times.reserve(cycles);
+
+    QElapsedTimer timer;
+
+    for (int i = 0; i < cycles; ++i) {
+        const DaemonCommand commands[2] = { fanCommand(i), ocTableCommand() };
+
+        for (int c = 0; c < 2; ++c) {
+            const int instructions = commands[c].count();
+            daemon.clearReceived();
+
+            timer.start();
+            const quint32 requestId = comm.sendCommand(commands[c]);
+
+            if (!waitFor([&daemon, instructions]() { return daemon.received().count() >= instructions; })) {
+                ++result->timeouts;
+                continue;
+            }
+
+            result->times[c * 2].push_back(timer.nsecsElapsed());
+
+            if (!framed)
+                continue;
+
+            if (!waitFor([&finishedId, requestId]() { return finishedId == requestId; })) {
+                ++result->timeouts;
+                continue;
+            }
+
+            result->times[c * 2 + 1].push_back(timer.nsecsElapsed());
+        }
+    }
+
+    comm.disconnectDaemon();
+}
+
+// 24 hours of history at 100 ms sampling, with every value
+#define HISTORY_BENCH_SAMPLES (24 * 3600 * 10)
+#define HISTORY_BENCH_INTERVAL 100
+
+// width of the plot for views of the history
+#define HISTORY_BENCH_COLUMNS 800
+
+struct HistoryResult {
+    std::vector<qint64> appendTimes, windowTimes, tieredAppendTimes, fileAppendTimes;
+    std::vector<qint64> viewTimes[3];  // 1 hour and 24 hours from tiers, 24 hours from raw samples
+    qint64 fullReadTime = 0, fileLoadTime = 0;
+    int fileLoaded = 0;
+    size_t memory = 0, tieredMemory = 0;
+};
+
+static const char *historyViewNames[3] = { "1h tiers", "24h tiers", "24h raw" };
+
+static void measureHistoryStore(HistoryResult *result) {
+    TimeSeriesStore store(HISTORY_BENCH_SAMPLES);
+    GPUDataContainer data;
+    QElapsedTimer timer;
+
+    for (int id = 0; id < ValueID::VALUE_ID_COUNT; ++id)
+        data.insert(static_cast<ValueID>(id), RPValue(ValueUnit::NONE, 0));
+
+    result->appendTimes.reserve(HISTORY_BENCH_SAMPLES);
+
+    for (int i = 0; i < HISTORY_BENCH_SAMPLES; ++i) {
+        data[ValueID::CLK_CORE].setValue(300 + i % 1500);
+        data[ValueID::TEMPERATURE_CURRENT].setValue(40 + i % 50);
+
+        timer.start();
+        store.append(static_cast<qint64>(i) * HISTORY_BENCH_INTERVAL, data);
+        result->appendTimes.push_back(timer.nsecsElapsed());
+    }
+
+    // full store from now on, appends overwrite the oldest samples
+    const int window = 1800;
+    double sum = 0;
+    result->windowTimes.reserve(1000);
+
+    for (int i = 0; i < 1000; ++i) {
+        store.append(static_cast<qint64>(HISTORY_BENCH_SAMPLES + i) * HISTORY_BENCH_INTERVAL, data);
+
+        timer.start();
+        for (int s = store.indexAfter(store.lastTimestamp() - window * HISTORY_BENCH_INTERVAL); s < store.count(); ++s)
+            sum += store.value(ValueID::CLK_CORE, s);
+
+        result->windowTimes.push_back(timer.nsecsElapsed());
+    }
+
+    timer.start();
+    for (int s = 0; s < store.count(); ++s)
+        sum += store.value(ValueID::TEMPERATURE_CURRENT, s);
+
+    result->fullReadTime = timer.nsecsElapsed();
+    result->memory = store.memoryUsage();
+
+    // the same day in tiers, raw samples only for the recent minutes
+    TimeSeriesHistory history;
+    result->tieredAppendTimes.reserve(HISTORY_BENCH_SAMPLES);
+
+    for (int i = 0; i < HISTORY_BENCH_SAMPLES; ++i) {
+        data[ValueID::CLK_CORE].setValue(300 + i % 1500);
+        data[ValueID::TEMPERATURE_CURRENT].setValue(40 + i % 50);
+
+        timer.start();
+        history.append(static_cast<qint64>(i) * HISTORY_BENCH_INTERVAL, data);
+        result->tieredAppendTimes.push_back(timer.nsecsElapsed());
+    }
+
+    result->tieredMemory = history.memoryUsage();
+
+    // points of a plot as PlotManager makes them
+    QVector<QPointF> points;
+    const qint64 last = history.lastTimestamp(), day = 24 * 3600 * 1000LL;
+    const qint64 viewStarts[3] = { last - 3600 * 1000, last - day, last - day };
+
+    for (int v = 0; v < 3; ++v) {
+        const TimeSeriesStore &source = (v == 2) ? store : history.tierFor(viewStarts[v]);
+        result->viewTimes[v].reserve(100);
+
+        for (int i = 0; i < 100; ++i) {
+            timer.start();
+            SeriesDecimator::minMax(source, ValueID::TEMPERATURE_CURRENT, source.indexAfter(viewStarts[v]) - 1,
+                                    viewStarts[v], last, HISTORY_BENCH_COLUMNS, 0, &points);
+            result->viewTimes[v].push_back(timer.nsecsElapsed());
+        }
+    }
+
+    // the same day written to a history file of the default size, then loaded as on start
+    QTemporaryDir dir;
+    const QString path = dir.filePath("history");
+    HistoryFile file;
+
+    if (dir.isValid() && file.open(path, HISTORY_FILE_DEFAULT_SIZE)) {
+        result->fileAppendTimes.reserve(HISTORY_BENCH_SAMPLES);
+
+        for (int i = 0; i < HISTORY_BENCH_SAMPLES; ++i) {
+            data[ValueID::CLK_CORE].setValue(300 + i % 1500);
+
+            timer.start();
+            file.append(static_cast<qint64>(i + 1) * HISTORY_BENCH_INTERVAL, data);
+            result->fileAppendTimes.push_back(timer.nsecsElapsed());
+        }
+
+        file.close();
+
+        TimeSeriesHistory loaded;
+        timer.start();
+        if (file.open(path, HISTORY_FILE_DEFAULT_SIZE))
+            result->fileLoaded = file.load(&loaded);
+
+        result->fileLoadTime = timer.nsecsElapsed();
+        file.close();
+    }
+
+    // keeps the reads from being optimized out
+    static volatile double sink;
+    sink = sum;
+}
+
+// plots with 2 clocks on the left and 2 percents on the right, refreshed at 100 ms
+#define PLOT_BENCH_PLOTS 6
+#define PLOT_BENCH_INTERVAL 100
+#define PLOT_BENCH_RANGE 1800  // in samples
+
+enum PlotBenchMode {
+    PLOTS_DECIMATED,
+    PLOTS_FULL,  // every sample of the time range is a point
+    PLOTS_LEGACY
+};
+
+struct PlotResult {
+    std::vector<qint64> frameTimes;
+    qint64 cpuTime = 0;
+};
+
+static qint64 processCpuTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+    return static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+static void sampleFakeData(GPUDataContainer *data, int tick) {
+    (*data)[ValueID::CLK_CORE].setValue(300 + (tick * 7) % 1200);
+    (*data)[ValueID::CLK_MEM].setValue(tick % 50 < 25 ? 500 : 1750);
+    (*data)[ValueID::GPU_USAGE_PERCENT].setValue((tick * 3) % 100);
+    (*data)[ValueID::GPU_VRAM_USAGE_PERCENT].setValue(20 + tick % 10);
+}
+
+// how plots were refreshed before the history store: append and rescale per point, one point removed every 60 ticks
+static void legacyPlotUpdate(RPPlot *plot, int tick, const GPUDataContainer &data) {
+    plot->timeAxis.setRange(tick - PLOT_BENCH_RANGE, tick + 10);
+
+    for (DataSeries *ds : plot->series) {
+        const float value = data.value(ds->id).value;
+        ds->append(tick, value);
+
+        for (YAxis *axis : { plot->axisLeft, plot->axisRight }) {
+            if (axis == nullptr || axis->unit != globalStuff::getUnitFomValueId(ds->id) || axis->unit == ValueUnit::PERCENT)
+                continue;
+
+            if (axis->max() < value)
+                axis->setMax(value + 150);
+            else if (axis->min() > value)
+                axis->setMin(value - 100);
+        }
+
+        if (tick % 60 == 0 && ds->count() > PLOT_BENCH_RANGE)
+            ds->remove(0);
+    }
+}
+
+// frame is the plot update and the repaint it causes
+static void measurePlots(int cycles, PlotBenchMode mode, PlotResult *result) {
+    const bool legacy = mode == PLOTS_LEGACY;
+
+    PlotManager manager;
+    manager.setSamplingInterval(PLOT_BENCH_INTERVAL);
+    manager.setTimeRange(PLOT_BENCH_RANGE * PLOT_BENCH_INTERVAL / 1000);
+    manager.setDecimation(mode == PLOTS_DECIMATED);
+
+    GPUDataContainer data;
+    data.insert(ValueID::CLK_CORE, RPValue(ValueUnit::MEGAHERTZ, 300));
+    data.insert(ValueID::CLK_MEM, RPValue(ValueUnit::MEGAHERTZ, 500));
+    data.insert(ValueID::GPU_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, 0));
+    data.insert(ValueID::GPU_VRAM_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, 20));
+
+    for (int i = 0; i < PLOT_BENCH_PLOTS; ++i) {
+        PlotDefinitionSchema pds;
+        pds.name = QString("plot %1").arg(i);
+        pds.enabled = true;
+        pds.background = Qt::black;
+
+        pds.left.enabled = pds.right.enabled = true;
+        pds.left.unit = ValueUnit::MEGAHERTZ;
+        pds.right.unit = ValueUnit::PERCENT;
+        pds.left.ticks = pds.right.ticks = 5;
+        pds.left.penGrid = pds.right.penGrid = QPen(Qt::gray);
+        pds.left.dataList.insert(ValueID::CLK_CORE, Qt::red);
+        pds.left.dataList.insert(ValueID::CLK_MEM, Qt::yellow);
+        pds.right.dataList.insert(ValueID::GPU_USAGE_PERCENT, Qt::green);
+        pds.right.dataList.insert(ValueID::GPU_VRAM_USAGE_PERCENT, Qt::cyan);
+
+        manager.addSchema(pds);
+    }
+
+    manager.createPlotsFromSchemas(data);
+
+    QWidget window;
+    QVBoxLayout *layout = new QVBoxLayout(&window);
+    for (RPPlot *plot : manager.plots)
+        layout->addWidget(plot);
+
+    // narrower than the time range, so there are more samples than pixel columns
+    window.resize(600, 1200);
+    window.show();
+
+    QVector<TimeSeriesHistory> history(1);
+
+    // plots start with full history
+    for (int tick = 0; tick < PLOT_BENCH_RANGE; ++tick) {
+        sampleFakeData(&data, tick);
+        history[0].append(static_cast<qint64>(tick) * PLOT_BENCH_INTERVAL, data);
+
+        if (legacy)
+            for (RPPlot *plot : manager.plots)
+                legacyPlotUpdate(plot, tick, data);
+    }
+
+    if (!legacy)
+        manager.updateSeries(history, 0);
+
+    QApplication::processEvents();
+
+    QElapsedTimer timer;
+    result->frameTimes.reserve(cycles);
+    const qint64 cpuStart = processCpuTime();
+
+    for (int i = 0; i < cycles; ++i) {
+        const int tick = PLOT_BENCH_RANGE + i;
+        sampleFakeData(&data, tick);
+        history[0].append(static_cast<qint64>(tick) * PLOT_BENCH_INTERVAL, data);
+
+        timer.start();
+
+        if (legacy) {
+            for (RPPlot *plot : manager.plots)
+                legacyPlotUpdate(plot, tick, data);
+        } else
+            manager.updateSeries(history, 0);
+
+        QApplication::processEvents();
+        result->frameTimes.push_back(timer.nsecsElapsed());
+    }
+
+    result->cpuTime = processCpuTime() - cpuStart;
+}
+
+static bool hasArgument(int argc, char *argv[], const char *name) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    // plots need widgets, everything else runs without a display
+    std::unique_ptr<QCoreApplication> app(hasArgument(argc, argv, "--plots") ? new QApplication(argc, argv)
+                                                                             : new QCoreApplication(argc, argv));
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures one refresh of radeon-profile sampling path.");
+    parser.addHelpOption();
+
+    QCommandLineOption rootOption("root", "Directory used as root for /sys, /sys/kernel/debug and /dev/dri.", "directory"),
+            cyclesOption("cycles", "Number of sampling cycles (default 1000).", "count", "1000"),
+            cardOption("card", "Index of detected card (default 0).", "index", "0"),
+            replayOption("ioctl-replay", "Answer ioctls with results recorded in file, no /dev/dri needed.", "file"),
+            recordOption("ioctl-record", "Save results of real ioctls to file.", "file"),
+            readDelayOption("read-delay", "Add delay to every sysfs read, to simulate slow attributes.", "usec", "0"),
+            pmInfoOption("pm-info", "Directory with captured pm_info files and the clocks they give (default: golden files of tests).",
+                         "directory", PM_INFO_SAMPLES_DIR),
+            pmInfoParseOption("pm-info-parse", "Only parse every pm_info capture, "
+                              + QString::number(PM_INFO_BENCH_ITERATIONS) + " times unless --cycles is given."),
+            startupOption("startup", "Measure card detection and handler setup on a synthetic tree of "
+                          + QString::number(STARTUP_BENCH_CARDS) + " cards and " + QString::number(STARTUP_BENCH_HWMON_CHIPS)
+                          + " hwmon chips instead of sampling."),
+            historyOption("history", "Measure the history store, its tiers and the history file with a day of samples instead of sampling."),
+            plotsOption("plots", "Measure plot refresh instead of sampling, needs a display (or QT_QPA_PLATFORM=offscreen).");
+
+    parser.addOption(rootOption);
+    parser.addOption(cyclesOption);
+    parser.addOption(cardOption);
+    parser.addOption(replayOption);
+    parser.addOption(recordOption);
+    parser.addOption(readDelayOption);
+    parser.addOption(pmInfoOption);
+    parser.addOption(pmInfoParseOption);
+    parser.addOption(startupOption);
+    parser.addOption(historyOption);
+    parser.addOption(plotsOption);
+    parser.process(*app);
+
+    const int cycles = qMax(1, parser.value(cyclesOption).toInt());
+
+    if (parser.isSet(plotsOption)) {
+        PlotResult decimated, full, legacy;
+        measurePlots(cycles, PLOTS_DECIMATED, &decimated);
+        measurePlots(cycles, PLOTS_FULL, &full);
+        measurePlots(cycles, PLOTS_LEGACY, &legacy);
+
+        out << PLOT_BENCH_PLOTS << " plots x 4 series, " << PLOT_BENCH_RANGE << " samples visible, " << cycles << " frames" << endl;
+        out << qSetFieldWidth(14) << left << "frame" << "p50 [us]" << "p99 [us]" << "max [us]" << qSetFieldWidth(0) << endl;
+        printRow(out, "decimated", decimated.frameTimes);
+        printRow(out, "replace", full.frameTimes);
+        printRow(out, "append", legacy.frameTimes);
+
+        // share of the 100 ms refresh interval spent on plots
+        out << "cpu per frame [us] (% of " << PLOT_BENCH_INTERVAL << " ms)";
+        for (const PlotResult *r : { &decimated, &full, &legacy })
+            out << ", " << QString::number(r->cpuTime / 1000.0 / cycles, 'f', 1)
+                << " (" << QString::number(r->cpuTime * 100.0 / cycles / (PLOT_BENCH_INTERVAL * 1000000.0), 'f', 1) << "%)";
+
+        out << endl;
+
+        return 0;
+    }
+
+    if (parser.isSet(pmInfoParseOption)) {
+        const QVector<PmInfoSample> samples = loadPmInfoSamples(parser.value(pmInfoOption));
+        if (samples.isEmpty()) {
+            out << "No pm_info captures in " << parser.value(pmInfoOption) << endl;
+            return 1;
+        }
+
+        const int iterations = parser.isSet(cyclesOption) ? cycles : PM_INFO_BENCH_ITERATIONS;
+        QVector<PmInfoResult> results(samples.count());
+        for (int i = 0; i < samples.count(); ++i)
+            measurePmInfoParse(iterations, samples.at(i), &results[i]);
+
+        out << samples.count() << " pm_info captures, " << iterations << " parses of each" << endl;
+        printPmInfoResults(out, samples, results);
+
+        return 0;
+    }
+
+    if (parser.isSet(historyOption)) {
+        HistoryResult history;
+        measureHistoryStore(&history);
+
+        out << "history store, 24h at " << HISTORY_BENCH_INTERVAL << " ms (" << HISTORY_BENCH_SAMPLES << " samples, "
+            << ValueID::VALUE_ID_COUNT << " values): " << QString::number(history.memory / 1048576.0, 'f', 1) << " MiB" << endl;
+        printRow(out, "append", history.appendTimes);
+        printRow(out, "window 1800", history.windowTimes);
+        out << "read of one value, whole day: " << QString::number(history.fullReadTime / 1000.0, 'f', 1) << " us" << endl;
+
+        out << "history tiers, the same day: " << QString::number(history.tieredMemory / 1048576.0, 'f', 1) << " MiB" << endl;
+        printRow(out, "append", history.tieredAppendTimes);
+
+        out << "plot view of " << HISTORY_BENCH_COLUMNS << " columns" << endl;
+        for (int v = 0; v < 3; ++v)
+            printRow(out, historyViewNames[v], history.viewTimes[v]);
+
+        if (!history.fileAppendTimes.empty()) {
+            out << "history file, " << HISTORY_FILE_DEFAULT_SIZE << " MiB, " << sizeof(HistoryRecord) << " B per record" << endl;
+            printRow(out, "append", history.fileAppendTimes);
+            out << "open and load of " << history.fileLoaded << " records: "
+                << QString::number(history.fileLoadTime / 1000000.0, 'f', 1) << " ms" << endl;
+        }
+
+        return 0;
+    }
+
+    std::unique_ptr<IoctlBackend> ioctlBackend;
+    if (parser.isSet(replayOption))
+        ioctlBackend.reset(new ReplayIoctlBackend(parser.value(replayOption)));
+    else if (parser.isSet(recordOption))
+        ioctlBackend.reset(new RecordingIoctlBackend(parser.value(recordOption)));
+
+    IoctlBackend::setDefaultBackend(ioctlBackend.get());
+
+    globalStuff::setSystemRoot(parser.isSet(rootOption) ? parser.value(rootOption)
+                                                       : QProcessEnvironment::systemEnvironment().value("RADEON_PROFILE_ROOT"));
+
+    if (parser.isSet(startupOption)) {
+        std::vector<qint64> startupTimes[STARTUP_PART_COUNT];
+        const int temperatureFound = measureStartup(cycles, startupTimes);
+
+        if (temperatureFound == -1) {
+            out << "Unable to create the synthetic sysfs tree in " << QDir::tempPath() << endl;
+            return 1;
+        }
+
+        out << STARTUP_BENCH_CARDS << " cards, " << STARTUP_BENCH_HWMON_CHIPS << " hwmon chips, " << cycles << " runs"
+            << ", temperature found for " << temperatureFound << " cards" << endl;
+        out << qSetFieldWidth(14) << left << "part" << "p50 [us]" << "p99 [us]" << "max [us]" << qSetFieldWidth(0) << endl;
+
+        for (int part = 0; part < STARTUP_PART_COUNT; ++part)
+            printRow(out, startupPartNames[part], startupTimes[part]);
+
+        return 0;
+    }
+
+    const int card = parser.value(cardOption).toInt();
+
+    SysfsAttribute::setArtificialLatency(parser.value(readDelayOption).toInt());
+
+    gpu device;
+    device.detectCards();
+
+    if (card < 0 || card >= device.gpuList.count()) {
+        out << "No card with index " << card << " (" << device.gpuList.count() << " detected)" << endl;
+        return 1;
+    }
+
+    // no daemon here, so data is read only if running as root or from a captured tree
+    const dXorg::InitializationConfig config(geteuid() == 0, false, false);
+    dXorg handler(device.gpuList.at(card), config);
+
+    // as gpu::startSampling() does, radeon usage comes from the busy sampler thread
+    handler.startBackgroundSampling();
+
+    std::vector<qint64> stepTimes[STEP_COUNT], cycleTimes;
+    for (auto &v : stepTimes)
+        v.reserve(cycles);
+
+    cycleTimes.reserve(cycles);
+
+    QElapsedTimer timer;
+    const long long syscallsStart = readSyscallCount();
+    const unsigned long allocationsStart = allocationCount;
+    const IoctlBackend::Statistics ioctlStart = IoctlBackend::defaultBackend()->statistics();
+
+    for (int i = 0; i < cycles; ++i) {
+        qint64 cycleStart = 0;
+        timer.start();
+
+        handler.getCurrentPowerLevel();
+        handler.getCurrentPowerProfile();
+        stepTimes[STEP_POWER_LEVEL].push_back(timer.nsecsElapsed() - cycleStart);
+        cycleStart = timer.nsecsElapsed();
+
+        const SensorSnapshot sensors = handler.sampleSensors();
+        stepTimes[STEP_SENSORS].push_back(timer.nsecsElapsed() - cycleStart);
+        cycleStart = timer.nsecsElapsed();
+
+        handler.getClocks(sensors);
+        stepTimes[STEP_CLOCKS].push_back(timer.nsecsElapsed() - cycleStart);
+        cycleStart = timer.nsecsElapsed();
+
+        handler.getTemperature();
+        stepTimes[STEP_TEMPERATURE].push_back(timer.nsecsElapsed() - cycleStart);
+        cycleStart = timer.nsecsElapsed();
+
+        handler.getGPUUsage(sensors);
+        stepTimes[STEP_USAGE].push_back(timer.nsecsElapsed() - cycleStart);
+        cycleStart = timer.nsecsElapsed();
+
+        handler.getFanSpeed();
+        stepTimes[STEP_FAN].push_back(timer.nsecsElapsed() - cycleStart);
+        cycleStart = timer.nsecsElapsed();
+
+        if (handler.features.isPowerCapAvailable) {
+            handler.getPowerCapSelected();
+            handler.getPowerCapAverage();
+        }
+        stepTimes[STEP_POWER_CAP].push_back(timer.nsecsElapsed() - cycleStart);
+
+        cycleTimes.push_back(timer.nsecsElapsed());
+    }
+
+    const unsigned long allocations = allocationCount - allocationsStart;
+    const long long syscallsEnd = readSyscallCount();
+    const IoctlBackend::Statistics ioctlEnd = IoctlBackend::defaultBackend()->statistics();
+
+    // whole sampler tick of all cards, reads run in parallel on the sampler pool
+    std::vector<std::unique_ptr<dXorg>> allHandlers;
+    QVector<dXorg*> handlers;
+    QVector<GPUDataContainer> initialData;
+
+    for (const GPUSysInfo &info : device.gpuList) {
+        allHandlers.emplace_back(new dXorg(info, config));
+        allHandlers.back()->startBackgroundSampling();
+        handlers.append(allHandlers.back().get());
+        initialData.append(gpu::defineAvailableDataContainer(handlers.last()));
+    }
+
+    SamplerThread sampler;
+    sampler.setDriverHandlers(handlers, initialData);
+
+    std::vector<qint64> tickTimes;
+    tickTimes.reserve(cycles);
+
+    for (int i = 0; i < cycles; ++i) {
+        timer.start();
+        sampler.sampleOnce();
+        tickTimes.push_back(timer.nsecsElapsed());
+    }
+
+    // value container of one card, layout before (QMap) and now (array with presence mask)
+    std::vector<qint64> mapCycleTimes[PART_COUNT], arrayCycleTimes[PART_COUNT];
+    measureRefreshCycle<MapDataContainer>(cycles, mapCycleTimes);
+    measureRefreshCycle<GPUDataContainer>(cycles, arrayCycleTimes);
+
+    std::vector<qint64> daemonTextTimes, daemonRecordTimes;
+    daemonTextTimes.reserve(cycles);
+    daemonRecordTimes.reserve(cycles);
+    measureDaemonPayload(cycles, &daemonTextTimes, &daemonRecordTimes);
+
+    const QVector<PmInfoSample> pmInfoSamples = loadPmInfoSamples(parser.value(pmInfoOption));
+    QVector<PmInfoResult> pmInfoResults(pmInfoSamples.count());
+    for (int i = 0; i < pmInfoSamples.count(); ++i)
+        measurePmInfoParse(cycles, pmInfoSamples.at(i), &pmInfoResults[i]);
+
+    EncodingResult encodings[4];
+    measureCommandEncoding(cycles, encodings);
+
+    RoundTripResult legacyTrips, framedTrips;
+    measureDaemonRoundTrip(cycles, MockDaemon::LEGACY, &legacyTrips);
+    measureDaemonRoundTrip(cycles, MockDaemon::FRAMED, &framedTrips);
+
+    // the file read alone, without the simulated latency
+    SysfsAttribute::setArtificialLatency(0);
+    std::vector<qint64> preadTimes, qfileTimes;
+    measureSysfsRead(cycles, &preadTimes, &qfileTimes);
+
+    out << "card: " << device.gpuList.at(card).sysName << " (" << device.gpuList.at(card).driverModuleString << ")"
+        << ", cycles: " << cycles << endl;
+
+    out << qSetFieldWidth(14) << left << "step" << "p50 [us]" << "p99 [us]" << "max [us]" << qSetFieldWidth(0) << endl;
+
+    for (int s = 0; s < STEP_COUNT; ++s)
+        printRow(out, stepNames[s], stepTimes[s]);
+
+    printRow(out, "cycle", cycleTimes);
+
+    out << "all cards (" << handlers.count() << "), sampler pool threads: " << sampler.poolThreadCount()
+        << " + sampler thread" << endl;
+    printRow(out, "tick", tickTimes);
+
+    out << "refresh, plot and topbar values of one card (QMap / array container)" << endl;
+    for (int part = 0; part < PART_COUNT; ++part) {
+        printRow(out, QString("%1 QMap").arg(cyclePartNames[part]), mapCycleTimes[part]);
+        printRow(out, QString("%1 array").arg(cyclePartNames[part]), arrayCycleTimes[part]);
+    }
+
+    if (!preadTimes.empty()) {
+        out << "sysfs attribute read (kept open / open, read, close)" << endl;
+        printRow(out, "pread", preadTimes);
+        printRow(out, "QFile", qfileTimes);
+    }
+
+    out << "daemon shared memory, read and parse on client side" << endl;
+    printRow(out, "text", daemonTextTimes);
+    printRow(out, "record", daemonRecordTimes);
+
+    printPmInfoResults(out, pmInfoSamples, pmInfoResults);
+
+    out << "daemon command encoding (legacy text / frame)" << endl;
+
+    static const char *encodingNames[4] = { "fan legacy", "fan frame", "oc legacy", "oc frame" };
+    for (int i = 0; i < 4; ++i)
+        printRow(out, QString("%1 %2B").arg(encodingNames[i]).arg(encodings[i].bytes), encodings[i].times);
+
+    out << "daemon round trip through DaemonComm to the mock daemon (decoded by the daemon / status back)" << endl;
+
+    for (RoundTripResult *trips : { &legacyTrips, &framedTrips }) {
+        const QString protocol = (trips == &legacyTrips) ? "legacy" : "framed";
+
+        if (!trips->connected) {
+            out << protocol << ": no connection to the mock daemon" << endl;
+            continue;
+        }
+
+        for (int t = 0; t < TRIP_COUNT; ++t)
+            if (!trips->times[t].empty())
+                printRow(out, QString("%1 %2").arg(roundTripNames[t]).arg(protocol), trips->times[t]);
+
+        if (trips->timeouts > 0)
+            out << protocol << ": " << trips->timeouts << " commands timed out" << endl;
+    }
+
+#ifdef __GLIBC__
+    out << "allocations per cycle: " << QString::number(static_cast<double>(allocations) / cycles, 'f', 1) << endl;
+#else
+    Q_UNUSED(allocations);
+    out << "allocations per cycle: n/a" << endl;
+#endif
+
+    if (syscallsStart != -1 && syscallsEnd != -1)
+        out << "read/write syscalls per cycle: " << QString::number(static_cast<double>(syscallsEnd - syscallsStart) / cycles, 'f', 1) << endl;
+    else
+        out << "read/write syscalls per cycle: n/a (no task io accounting)" << endl;
+
+    // includes the calls of the radeon busy sampler thread
+    const quint64 ioctlCalls = ioctlEnd.calls - ioctlStart.calls;
+    out << "ioctls per cycle: " << QString::number(static_cast<double>(ioctlCalls) / cycles, 'f', 1)
+        << ", failed: " << (ioctlEnd.failures - ioctlStart.failures)
+        << ", avg [us]: " << QString::number(ioctlCalls ? (ioctlEnd.totalNs - ioctlStart.totalNs) / 1000.0 / ioctlCalls : 0, 'f', 2)
+        << ", max [us]: " << QString::number(ioctlEnd.maxNs / 1000.0, 'f', 1) << endl;
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#-------------------------------------------------
+#
+# rp-bench, measures the sampling path (gpu/dXorg/ioctl) without the ui
+# run: rp-bench [--root <captured tree>] [--cycles N] [--card N] [--read-delay usec] [--pm-info <dir>] [--pm-info-parse] [--startup] [--history] [--plots]
+#
+#-------------------------------------------------
+
+QT       += core gui network widgets concurrent charts
+
+TARGET = rp-bench
+TEMPLATE = app
+CONFIG += console
+
+QMAKE_CXXFLAGS += -std=c++11
+
+CONFIG(release, debug|release){
+    DEFINES += QT_NO_DEBUG_OUTPUT
+}
+
+INCLUDEPATH += ..
+
+# captured pm_info of every layout, parsed with the old regular expressions and PmInfoParser
+DEFINES += PM_INFO_SAMPLES_DIR=\\\"$$PWD/../tests/tst_pmInfoParser/data\\\"
+
+SOURCES += main.cpp \
+    ../gpu.cpp \
+    ../dxorg.cpp \
+    ../daemonComm.cpp \
+    ../daemonCommand.cpp \
+    ../daemonSharedMem.cpp \
+    ../ioctlHandler.cpp \
+    ../ioctlBackend.cpp \
+    ../busySampler.cpp \
+    ../ioctl_radeon.cpp \
+    ../ioctl_amdgpu.cpp \
+    ../sysfsAttribute.cpp \
+    ../sysfsEnumerator.cpp \
+    ../pmInfoParser.cpp \
+    ../samplerThread.cpp \
+    ../workStealingPool.cpp \
+    ../timeSeriesStore.cpp \
+    ../seriesDecimator.cpp \
+    ../historyFile.cpp
+
+HEADERS  += ../gpu.h \
+    ../dxorg.h \
+    ../globalStuff.h \
+    ../daemonComm.h \
+    ../daemonCommand.h \
+    ../daemonSharedMem.h \
+    ../ioctlHandler.h \
+    ../ioctlBackend.h \
+    ../busySampler.h \
+    ../sysfsAttribute.h \
+    ../sysfsEnumerator.h \
+    ../pmInfoParser.h \
+    ../samplerThread.h \
+    ../workStealingPool.h \
+    ../timeSeriesStore.h \
+    ../seriesDecimator.h \
+    ../historyFile.h \
+    ../components/rpplot.h
+
+# daemon on a local socket for the round trip of daemon commands
+include(../tests/mockDaemon/mockDaemon.pri)
+
+# gpu.cpp reads connectors with Xrandr
+LIBS += -lXrandr -lX11
+
+DESTDIR = target
@@ -0,0 +1,93 @@
+#include "busySampler.h"
+
+#include <QDebug>
+#include <time.h> // clock_gettime(), clock_nanosleep()
+
+#define ONE_SECOND_NS 1000000000L
+
+BusySampler::BusySampler(const Probe &probe, int frequency, int window) :
+    probe(probe),
+    periodNs(ONE_SECOND_NS / qMax(frequency, 1)),
+    ring(qMax(1, window * qMax(frequency, 1) / 1000), false),
+    ringPosition(0),
+    filled(0),
+    activeCount(0),
+    window(0),
+    stopRequested(false),
+    failed(false) { }
+
+BusySampler::~BusySampler() {
+    stop();
+}
+
+bool BusySampler::getUsage(float *data) const {
+    if (failed)
+        return false;
+
+    const quint64 w = window.load(std::memory_order_acquire);
+    const unsigned samples = w & 0xffffffff, active = w >> 32;
+
+    if (samples == 0)
+        return false;
+
+    *data = (100.0f * active) / samples;
+    return true;
+}
+
+void BusySampler::stop() {
+    stopRequested = true;
+    wait();
+
+    // the thread is done, next start() begins with an empty window
+    stopRequested = false;
+    failed = false;
+    ringPosition = filled = activeCount = 0;
+    window.store(0, std::memory_order_release);
+}
+
+static inline void addNs(struct timespec *t, long ns) {
+    t->tv_nsec += ns;
+    while (t->tv_nsec >= ONE_SECOND_NS) {
+        t->tv_nsec -= ONE_SECOND_NS;
+        ++t->tv_sec;
+    }
+}
+
+static inline bool isBefore(const struct timespec &a, const struct timespec &b) {
+    return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+
+void BusySampler::run() {
+    struct timespec next, now;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!stopRequested) {
+        bool active;
+        if (!probe(&active)) {
+            qWarning() << "Reading GPU busy state failed, busy sampling stopped";
+            failed = true;
+            return;
+        }
+
+        if (filled == ring.size())
+            activeCount -= ring[ringPosition];
+        else
+            ++filled;
+
+        ring[ringPosition] = active;
+        activeCount += active;
+        ringPosition = (ringPosition + 1) % ring.size();
+
+        window.store((static_cast<quint64>(activeCount) << 32) | filled, std::memory_order_release);
+
+        // absolute deadlines, so time spent in probe doesn't lower the frequency
+        addNs(&next, periodNs);
+
+        // fell behind (suspend, heavy load), don't try to catch up with a burst of samples
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (isBefore(next, now))
+            next = now;
+
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+}
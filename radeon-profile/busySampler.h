@@ -0,0 +1,62 @@
+#ifndef BUSYSAMPLER_H
+#define BUSYSAMPLER_H
+
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief The BusySampler class polls the GPU status register on its own thread, at a fixed frequency,
+ * and keeps the last samples in a ring buffer.
+ * Usage over the window is kept up to date after every sample, so reading it costs one atomic load
+ * instead of blocking the caller for the whole window.
+ */
+class BusySampler : public QThread
+{
+public:
+    /**
+     * @brief Function reading the busy bit of the card.
+     * @param active On success is filled with the value (true=active, false=idle).
+     * @return Success.
+     */
+    typedef std::function<bool(bool *active)> Probe;
+
+    /**
+     * @brief Create the sampler, polling starts with start().
+     * @param probe Function reading the busy bit.
+     * @param frequency How frequently to poll, in Hz.
+     * @param window Time span the usage is calculated over, in mS.
+     */
+    BusySampler(const Probe &probe, int frequency, int window);
+    ~BusySampler();
+
+    /**
+     * @brief Get how busy the GPU was in the last window.
+     * @param data On success is filled with the value, as percentage of time (0%=idle, 100%=full).
+     * @return Success, false if there are no samples yet or the probe failed.
+     */
+    bool getUsage(float *data) const;
+
+    /**
+     * @brief Stop polling and drop the samples, usage is unknown until start() takes new ones.
+     */
+    void stop();
+
+protected:
+    void run();
+
+private:
+    Probe probe;
+    const long periodNs;
+
+    // touched only by the sampling thread
+    std::vector<bool> ring;
+    unsigned ringPosition, filled, activeCount;
+
+    // active samples in upper 32 bits, all samples in lower, published together after every sample
+    std::atomic<quint64> window;
+    std::atomic<bool> stopRequested, failed;
+};
+
+#endif // BUSYSAMPLER_H
@@ -43,10 +43,10 @@ public:
     void updateValue(const GPUDataContainer &gpuData) {
         data.slices().at(1)->setValue(gpuData.value(dataId).value);
         data.slices().at(2)->setValue(maxValue - gpuData.value(dataId).value);
-        primaryLabel.setText(gpuData.value(dataId).strValue);
+        primaryLabel.setText(gpuData.value(dataId).strValue());
 
         if (secondaryDataIdEnabled)
-            secondaryLabel.setText(gpuData.value(secondaryDataId).strValue);
+            secondaryLabel.setText(gpuData.value(secondaryDataId).strValue());
     }
 
     void setFillColor(const QColor &c) {
@@ -7,7 +7,11 @@
 #include <QObject>
 #include <QtCharts>
 #include "globalStuff.h"
+#include "timeSeriesStore.h"
+#include "seriesDecimator.h"
 #include <QDebug>
+#include <QVector>
+#include <limits>
 
 using namespace QtCharts;
 
@@ -31,10 +35,25 @@ struct PlotDefinitionSchema {
     QString name;
     bool enabled;
     QColor background;
+    int cardIndex = -1;  // -1 means the selected card
 
     PlotAxisSchema left, right;
 };
 
+struct ValueRange {
+    float min = std::numeric_limits<float>::max(),
+        max = std::numeric_limits<float>::lowest();
+
+    void include(float value) {
+        min = qMin(min, value);
+        max = qMax(max, value);
+    }
+
+    bool isEmpty() const {
+        return min > max;
+    }
+};
+
 class YAxis : public QValueAxis {
 
     Q_OBJECT
@@ -68,12 +87,19 @@ class RPPlot : public QChartView
 
 public:
     QString name;
+    int cardIndex = -1;
     QChart plotArea;
     YAxis *axisLeft = nullptr,  *axisRight = nullptr;
     QValueAxis timeAxis;
 
     QMap<ValueID, DataSeries*> series;
 
+    // card and window of its history the series show, -1 is nothing yet
+    int shownCard = -1;
+    qint64 lastTimestamp = -1, windowStart = -1;
+
+    // reused by every update
+    QVector<QPointF> points;
 
     explicit RPPlot() : QChartView() {
         plotArea.setMargins(QMargins(-5,-8,-5,-10));
@@ -114,50 +140,57 @@ public:
         plotArea.addAxis(tmpax, a);
     }
 
-    void updatePlot(int timestamp, const GPUDataContainer &data) {
-        for (const ValueID &dsk : series.keys()) {
-            series[dsk]->append(timestamp, data.value(dsk).value);
-            rescale(axisLeft, data.value(dsk).value, globalStuff::getUnitFomValueId(series[dsk]->id));
-            rescale(axisRight, data.value(dsk).value, globalStuff::getUnitFomValueId(series[dsk]->id));
+    /**
+     * @brief Replace points of every series with the visible window of the store and fit the axes to it,
+     * so a frame is one geometry update per series instead of one per appended point.
+     * @param store History of the card the plot shows.
+     * @param from Index of the first sample of the window, or of the one before it (see SeriesDecimator::minMax()).
+     * @param start Timestamp at the left edge of the plot.
+     * @param end Timestamp at the right edge of the plot.
+     * @param timeOrigin Timestamp at x = 0, x is in seconds.
+     * @param decimate Reduce points to two per pixel column, keeping minimum and maximum of each.
+     */
+    void updatePlot(const TimeSeriesStore &store, int from, qint64 start, qint64 end, qint64 timeOrigin, bool decimate) {
+        ValueRange left, right;
+        const int columns = decimate ? qMax(1, qRound(plotArea.plotArea().width())) : std::numeric_limits<int>::max() / 2;
+
+        for (DataSeries *ds : series) {
+            ValueRange &range = (axisLeft != nullptr && axisLeft->unit == globalStuff::getUnitFomValueId(ds->id)) ? left : right;
+
+            // extremes are kept, so the axes fit the samples even from decimated points
+            const int entryPoints = SeriesDecimator::minMax(store, ds->id, from, start, end, columns, timeOrigin, &points);
+
+            // the point before the window is off the plot, only its line comes in
+            for (int i = entryPoints; i < points.count(); ++i)
+                range.include(points.at(i).y());
+
+            ds->replace(points);
         }
+
+        fitAxis(axisLeft, left);
+        fitAxis(axisRight, right);
     }
 
-    void rescale(YAxis *axis,  float value,  ValueUnit unit) {
+    void fitAxis(YAxis *axis, const ValueRange &range) {
         // percent has const scale 0-100
-        if (unit == ValueUnit::PERCENT)
-            return;
-
-        if (axis == nullptr)
+        if (axis == nullptr || range.isEmpty() || axis->unit == ValueUnit::PERCENT)
             return;
 
-        if (unit == axis->unit && axis->max() < value) {
-            switch (axis->unit) {
-                case ValueUnit::CELSIUS:
-                    axis->setMax(value + 5);
-                    return;
-                case ValueUnit::MEGABYTE:
-                    axis->setMax(value + 50);
-                    return;
-                default:
-                    axis->setMax(value + 150);
-                    return;
-            }
-        }
-
-        if (axis->unit == unit && axis->min() > value) {
-            switch (unit) {
-                case ValueUnit::CELSIUS:
-                    axis->setMin(value - 5);
-                    return;
-                case ValueUnit::MEGAHERTZ:
-                case ValueUnit::MEGABYTE:
-                case ValueUnit::RPM:
-                case ValueUnit::MILIVOLT:
-                    axis->setMin(value - 100);
-                    return;
-                default:
-                    return;
-            }
+        switch (axis->unit) {
+            case ValueUnit::CELSIUS:
+                axis->setRange(range.min - 5, range.max + 5);
+                return;
+            case ValueUnit::MEGABYTE:
+                axis->setRange(range.min - 100, range.max + 50);
+                return;
+            case ValueUnit::MEGAHERTZ:
+            case ValueUnit::RPM:
+            case ValueUnit::MILIVOLT:
+                axis->setRange(range.min - 100, range.max + 150);
+                return;
+            default:
+                axis->setRange(range.min, range.max + 150);
+                return;
         }
     }
 
@@ -168,10 +201,13 @@ public:
 
 class PlotManager {
 private:
-    int timeRange = 150,
-        rightGap = 10;
+    int timeRange = 150;
+    bool rightGap = true;
+
+    // timestamp at x = 0, keeps x small enough for float coordinates of OpenGL series
+    qint64 timeOrigin = -1;
 
-    constexpr static int maxRange = 1800;
+    bool decimation = true;
 
 public:
     QMap<QString, RPPlot*> plots;
@@ -179,14 +215,21 @@ public:
 
     PlotManager() { }
 
+    // empty space after the last sample, 1/60 of the time range
     void setRightGap(bool enabled) {
-        rightGap = (enabled) ? 10 : 0;
+        rightGap = enabled;
     }
 
+    // in seconds
     void setTimeRange(int range) {
         timeRange = range;
     }
 
+    // more samples in the time range than pixels are reduced to minimum and maximum per pixel column
+    void setDecimation(bool enabled) {
+        decimation = enabled;
+    }
+
     void setInitialYRange(YAxis *axis, const int &intialValue) {
         switch (axis->unit) {
             case ValueUnit::PERCENT:
@@ -241,6 +284,7 @@ public:
 
         RPPlot *rpp = new  RPPlot();
         rpp->name = pds.name;
+        rpp->cardIndex = pds.cardIndex;
         plots.insert(rpp->name, rpp);
 
         setPlotBackground(rpp->name, pds.background);
@@ -323,24 +367,43 @@ public:
         return true;
     }
 
-    void cleanupSeries() {
-        for (const QString &rppk : plots.keys()) {
-            for (ValueID &sk : plots.value(rppk)->series.keys()) {
-                if (plots[rppk]->series[sk]->count() > maxRange)
-                    plots[rppk]->series[sk]->remove(0);
-            }
-        }
-    }
+    /**
+     * @brief Redraw plots with the visible window of the history of cards, plots without new samples are skipped.
+     * The window is read from the finest tier of the history which reaches back to its start,
+     * so a long time range costs about as much as a short one.
+     * @param cardsHistory History of every card, in order of gpuList.
+     * @param selectedCard Index of the card shown by plots without cardIndex.
+     */
+    void updateSeries(const QVector<TimeSeriesHistory> &cardsHistory, int selectedCard) {
+        for (RPPlot *plot : plots) {
+            const int card = (plot->cardIndex >= 0 && plot->cardIndex < cardsHistory.count()) ? plot->cardIndex : selectedCard;
+
+            if (card < 0 || card >= cardsHistory.count() || cardsHistory.at(card).isEmpty())
+                continue;
 
-    void updateSeries(int timestamp, const GPUDataContainer &data) {
-        for (const QString &rppk : plots.keys()) {
-            plots[rppk]->timeAxis.setRange(timestamp - timeRange, timestamp + rightGap);
-            plots[rppk]->updatePlot(timestamp, data);
-        }
+            const TimeSeriesHistory &history = cardsHistory.at(card);
+            const qint64 last = history.lastTimestamp(),
+                    start = last - static_cast<qint64>(timeRange) * 1000;
+
+            if (timeOrigin == -1)
+                timeOrigin = last;
+
+            // nothing new since the last frame
+            if (plot->shownCard == card && plot->lastTimestamp == last && plot->windowStart == start)
+                continue;
 
-        // cleaunp every 60 refreshes
-        if (timestamp % 60 == 0)
-            cleanupSeries();
+            const qint64 end = last + (rightGap ? static_cast<qint64>(timeRange) * 1000 / 60 : 0);
+            const TimeSeriesStore &store = history.tierFor(start);
+
+            // one sample before the window, so lines start at the left edge
+            plot->updatePlot(store, store.indexAfter(start) - 1, start, end, timeOrigin, decimation);
+
+            plot->shownCard = card;
+            plot->lastTimestamp = last;
+            plot->windowStart = start;
+
+            plot->timeAxis.setRange((start - timeOrigin) / 1000.0, (end - timeOrigin) / 1000.0);
+        }
     }
 };
 
@@ -7,6 +7,7 @@
 #include "globalStuff.h"
 #include "pieprogressbar.h"
 #include <QWidget>
+#include <QVector>
 
 enum TopbarItemType {
     LABEL_PAIR,
@@ -30,6 +31,9 @@ public:
         return itemWidget;
     }
 
+    // card the values are taken from, -1 for the selected one
+    int cardIndex = -1;
+
 protected:
     QWidget *itemWidget;
     TopbarItemType itemType;
@@ -65,10 +69,10 @@ public:
     }
 
     void updateItemValue(const GPUDataContainer &data) override {
-        labelTop.setText(data.value(primaryValueId).strValue);
+        labelTop.setText(data.value(primaryValueId).strValue());
 
         if (secondaryValueIdEnabled)
-            labelBottom.setText(data.value(secondaryValueId).strValue);
+            labelBottom.setText(data.value(secondaryValueId).strValue());
     }
 
     void setPrimaryColor(const QColor &c) override {
@@ -112,7 +116,7 @@ public:
     }
 
     void updateItemValue(const GPUDataContainer &data) override {
-        this->setText(data.value(primaryValueId).strValue);
+        this->setText(data.value(primaryValueId).strValue());
     }
 
     void setPrimaryColor(const QColor &c) override {
@@ -156,6 +160,7 @@ struct TopbarItemDefinitionSchema {
     QString name;
     bool secondaryValueIdEnabled = false;
     int pieMaxValue = 100;
+    int cardIndex = -1;  // -1 means the selected card
 
     TopbarItemDefinitionSchema() { }
 
@@ -192,6 +197,13 @@ struct TopbarItemDefinitionSchema {
     void setSecondaryColor(const QColor &c) {
         secondaryColor = c;
     }
+
+    void setCardIndex(int index) {
+        cardIndex = index;
+
+        if (cardIndex >= 0)
+            name.append("\n[Card " + QString::number(cardIndex) + "]");
+    }
 };
 
 class TopbarManager {
@@ -246,13 +258,15 @@ public:
             item->setSecondaryColor(tis.secondaryColor);
         }
 
+        item->cardIndex = tis.cardIndex;
+
         items.append(item);
         layout->addWidget(item->getItemWidget(), 0, Qt::AlignLeft);
     }
 
-    void updateItems(const GPUDataContainer &data) {
+    void updateItems(const GPUDataContainer &data, const QVector<GPUDataContainer> &cardsData) {
         for (TopbarItem *ti : items)
-            ti->updateItemValue(data);
+            ti->updateItemValue((ti->cardIndex >= 0 && ti->cardIndex < cardsData.count()) ? cardsData.at(ti->cardIndex) : data);
     }
 
     void createDefaultTopbarSchema(const QList<ValueID> &availableData) {
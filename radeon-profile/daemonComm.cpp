@@ -7,17 +7,28 @@
 const QString confirmationString("7#1#");
 
 DaemonComm::DaemonComm() : signalSender(new QLocalSocket(this)),
-    confirmationTimer(nullptr) {
+    confirmationTimer(nullptr),
+    framed(false),
+    lastRequestId(0) {
 
     feedback.setDevice(signalSender);
     feedback.setVersion(QDataStream::Qt_5_7);
     connect(signalSender,SIGNAL(readyRead()), this, SLOT(receiveFromDaemon()));
+
+    // connected before anyone else, so the hello is the first thing the daemon gets
+    connect(signalSender, SIGNAL(connected()), this, SLOT(sendHello()));
+    connect(signalSender, SIGNAL(disconnected()), this, SLOT(resetProtocol()));
 }
 
 DaemonComm::~DaemonComm() {
     delete signalSender;
 }
 
+DaemonComm& DaemonComm::instance() {
+    static DaemonComm dcomm;
+    return dcomm;
+}
+
 void DaemonComm::setConnectionConfirmationMethod(const ConfirmationMehtod method) {
     if (method == ConfirmationMehtod::PERIODICALLY) {
         confirmationTimer = new QTimer(this);
@@ -28,13 +39,27 @@ void DaemonComm::setConnectionConfirmationMethod(const ConfirmationMehtod method
 }
 
 void DaemonComm::sendConnectionConfirmation() {
-    sendCommand(confirmationString);
+    sendCommand(DaemonCommand().alive(true));
+}
+
+void DaemonComm::requestClocksRead() {
+    sendCommand(DaemonCommand().readClocks());
 }
 
-void DaemonComm::connectToDaemon() {
+void DaemonComm::sendHello() {
+    resetProtocol();
+    write(QByteArray(DAEMON_PROTOCOL_HELLO));
+}
+
+void DaemonComm::resetProtocol() {
+    framed = false;
+    frameBuffer.clear();
+}
+
+void DaemonComm::connectToDaemon(const QString &serverName) {
     qDebug() << "Connecting to daemon...";
     signalSender->abort();
-    signalSender->connectToServer("/run/radeon-profile-daemon-server");
+    signalSender->connectToServer(serverName);
 }
 
 void DaemonComm::disconnectDaemon() {
@@ -42,9 +67,9 @@ void DaemonComm::disconnectDaemon() {
         signalSender->close();
 }
 
-void DaemonComm::sendCommand(const QString command) {
-    if (signalSender->write(command.toLatin1(),command.length()) == -1) {// If sending signal fails
-        qWarning() << "Failed sending signal: " << command;
+void DaemonComm::write(const QByteArray &data) {
+    if (signalSender->write(data) == -1) {// If sending signal fails
+        qWarning() << "Failed sending signal: " << data;
         return;
     }
 
@@ -54,17 +79,105 @@ void DaemonComm::sendCommand(const QString command) {
         confirmationTimer->start();
 }
 
+quint32 DaemonComm::sendCommand(const DaemonCommand &command) {
+    if (command.isEmpty())
+        return 0;
+
+    if (!framed) {
+        const QByteArray legacy = command.toLegacy();
+        qDebug() << "Daemon command: " << legacy;
+
+        write(legacy);
+        return 0;
+    }
+
+    // 0 is for legacy commands
+    if (++lastRequestId == 0)
+        ++lastRequestId;
+
+    const QByteArray frame = command.toFrame(lastRequestId);
+    if (frame.isEmpty()) {
+        qWarning() << "Daemon command too long, not sent";
+        return 0;
+    }
+
+    write(frame);
+    return lastRequestId;
+}
+
 void DaemonComm::receiveFromDaemon() {
-    feedback.startTransaction();
+    if (!framed)
+        receiveLegacy();
 
-    QString confirmMsg;
-    feedback >> confirmMsg;
+    // the hello answer can come in one read with the first frames
+    if (framed)
+        receiveFrames();
+}
 
-    if (!feedback.commitTransaction())
-        return;
+void DaemonComm::receiveLegacy() {
+    // one readyRead() can carry more messages
+    forever {
+        feedback.startTransaction();
+
+        QString daemonMsg;
+        feedback >> daemonMsg;
+
+        if (!feedback.commitTransaction())
+            return;
+
+        qDebug() << daemonMsg.toLatin1();
+
+        if (daemonMsg.toLatin1() == confirmationString)
+            sendConnectionConfirmation();
+        else if (daemonMsg.startsWith(DAEMON_DATA_READY))
+            emit dataReady();
+        else if (daemonMsg == DAEMON_PROTOCOL_HELLO) {
+            qDebug() << "Daemon supports framed protocol version" << DAEMON_PROTOCOL_VERSION;
+
+            // daemon sends only frames after the answer
+            framed = true;
+            return;
+        }
+    }
+}
+
+void DaemonComm::receiveFrames() {
+    frameBuffer.append(signalSender->readAll());
 
-    if (confirmMsg.toLatin1() == confirmationString)
-        sendConnectionConfirmation();
+    quint8 type;
+    quint32 requestId;
+    QByteArray payload;
 
-    qDebug() << confirmMsg.toLatin1();
+    while (DaemonCommand::takeFrame(&frameBuffer, &type, &requestId, &payload))
+        handleFrame(type, requestId, payload);
+}
+
+void DaemonComm::handleFrame(quint8 type, quint32 requestId, const QByteArray &payload) {
+    switch (type) {
+        case DaemonCommand::STATUS: {
+            QDataStream stream(payload);
+            stream.setVersion(QDataStream::Qt_5_7);
+
+            qint32 status, failedIndex;
+            stream >> status >> failedIndex;
+
+            if (status != 0)
+                qWarning() << "Daemon command" << requestId << "failed at instruction" << failedIndex << ":" << qt_error_string(status);
+
+            emit commandFinished(requestId, status);
+            break;
+        }
+
+        case DaemonCommand::DATA_READY:
+            emit dataReady();
+            break;
+
+        case DaemonCommand::ALIVE:
+            sendConnectionConfirmation();
+            break;
+
+        default:
+            qDebug() << "Unknown frame from daemon, type" << type;
+            break;
+    }
 }
@@ -6,10 +6,14 @@
 #ifndef DAEMONCOMM_H
 #define DAEMONCOMM_H
 
+#include "daemonCommand.h"
+
 #include <QLocalSocket>
 #include <QDataStream>
 #include <QTimer>
 
+#define DAEMON_SERVER_NAME "/run/radeon-profile-daemon-server"
+
 #define SEPARATOR '#'
 #define DAEMON_SIGNAL_CONFIG '0'
 #define DAEMON_SIGNAL_READ_CLOCKS '1'
@@ -18,6 +22,14 @@
 #define DAEMON_SIGNAL_TIMER_OFF '5'
 #define DAEMON_SHAREDMEM_KEY '6'
 #define DAEMON_ALIVE '7'
+#define DAEMON_DATA_READY '8'
+#define DAEMON_SHAREDMEM_FORMAT '9'
+
+#define DAEMON_FORMAT_CLOCKS_RECORD "record"
+
+// sent in legacy text on connect, a daemon with the framed protocol answers with the same string
+// and both sides use frames from then on, old daemons ignore it (unknown instruction)
+#define DAEMON_PROTOCOL_HELLO "rp-protocol#v1#"
 
 class DaemonComm : public QObject
 {
@@ -33,9 +45,13 @@ public:
 
     DaemonComm();
     ~DaemonComm();
-    void connectToDaemon();
+
+    // connection shared by the ui and the driver layer
+    static DaemonComm& instance();
+
+    // serverName is for tests, which run a mock daemon
+    void connectToDaemon(const QString &serverName = DAEMON_SERVER_NAME);
     void disconnectDaemon();
-    void sendCommand(const QString command);
     void setConnectionConfirmationMethod(const ConfirmationMehtod method);
 
     inline bool isConnected() {
@@ -46,15 +62,48 @@ public:
         return signalSender;
     }
 
+    // daemon answered the hello, commands are sent as frames
+    inline bool isFramed() const {
+        return framed;
+    }
+
+    /**
+     * @brief Send the command, as one frame or as legacy text if the daemon doesn't know frames.
+     * @return Request id the daemon answers in commandFinished(), 0 for legacy (no answer).
+     */
+    quint32 sendCommand(const DaemonCommand &command);
+
+signals:
+    // daemon wrote pm_info to the shared memory for the first time after a config command
+    void dataReady();
+
+    // status of a framed command, 0 or errno of the failed instruction
+    void commandFinished(quint32 requestId, int status);
 
 public slots:
     void receiveFromDaemon();
     void sendConnectionConfirmation();
 
+    // for threads other than the one of the socket, through QMetaObject::invokeMethod()
+    void requestClocksRead();
+
+private slots:
+    void sendHello();
+    void resetProtocol();
+
 private:
     QDataStream feedback;
     QLocalSocket *signalSender;
     QTimer *confirmationTimer;
+
+    bool framed;
+    quint32 lastRequestId;
+    QByteArray frameBuffer;
+
+    void write(const QByteArray &data);
+    void receiveLegacy();
+    void receiveFrames();
+    void handleFrame(quint8 type, quint32 requestId, const QByteArray &payload);
 };
 
 #endif // DAEMONCOMM_H
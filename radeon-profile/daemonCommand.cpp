@@ -0,0 +1,169 @@
+#include "daemonCommand.h"
+#include "daemonComm.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+DaemonCommand& DaemonCommand::append(MessageType type, const QString &first, const QString &second, quint32 number) {
+    Instruction instruction;
+    instruction.type = type;
+    instruction.first = first;
+    instruction.second = second;
+    instruction.number = number;
+
+    instructions.append(instruction);
+    return *this;
+}
+
+DaemonCommand& DaemonCommand::config(const QString &name, const QString &path) {
+    return append(CONFIG, name, path);
+}
+
+DaemonCommand& DaemonCommand::readClocks() {
+    return append(READ_CLOCKS);
+}
+
+DaemonCommand& DaemonCommand::setValue(const QString &file, const QString &value) {
+    return append(SET_VALUE, file, value);
+}
+
+DaemonCommand& DaemonCommand::timerOn(int msec) {
+    return append(TIMER_ON, QString(), QString(), qMax(0, msec));
+}
+
+DaemonCommand& DaemonCommand::timerOff() {
+    return append(TIMER_OFF);
+}
+
+DaemonCommand& DaemonCommand::sharedMemKey(const QString &key, DaemonSharedMem::PayloadFormat format) {
+    return append(SHAREDMEM_KEY, key, QString(), format);
+}
+
+DaemonCommand& DaemonCommand::alive(bool confirmationRequired) {
+    return append(ALIVE, QString(), QString(), confirmationRequired);
+}
+
+static void writePayload(QDataStream &stream, quint8 type, const QString &first, const QString &second, quint32 number) {
+    switch (type) {
+        case DaemonCommand::CONFIG:
+        case DaemonCommand::SET_VALUE:
+            stream << first << second;
+            break;
+        case DaemonCommand::TIMER_ON:
+            stream << number;
+            break;
+        case DaemonCommand::SHAREDMEM_KEY:
+            stream << first << static_cast<quint8>(number);
+            break;
+        case DaemonCommand::ALIVE:
+            stream << (number != 0);
+            break;
+        default:
+            break;
+    }
+}
+
+QByteArray DaemonCommand::toFrame(quint32 requestId) const {
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_7);
+
+    // length is filled when the rest is written
+    stream << quint32(0) << quint8(DAEMON_PROTOCOL_VERSION);
+
+    if (instructions.count() == 1) {
+        const Instruction &i = instructions.first();
+        stream << quint8(i.type) << requestId;
+        writePayload(stream, i.type, i.first, i.second, i.number);
+    } else {
+        stream << quint8(BATCH) << requestId << quint32(instructions.count());
+
+        for (const Instruction &i : instructions) {
+            stream << quint8(i.type);
+            writePayload(stream, i.type, i.first, i.second, i.number);
+        }
+    }
+
+    const quint32 length = frame.size() - sizeof(quint32);
+    if (length > DAEMON_FRAME_MAX_LENGTH)
+        return QByteArray();
+
+    stream.device()->seek(0);
+    stream << length;
+
+    return frame;
+}
+
+QByteArray DaemonCommand::toLegacy() const {
+    QString command;
+
+    for (const Instruction &i : instructions) {
+        switch (i.type) {
+            case CONFIG:
+                command.append(DAEMON_SIGNAL_CONFIG).append(SEPARATOR).append(i.first).append(SEPARATOR).append(i.second).append(SEPARATOR);
+                break;
+            case READ_CLOCKS:
+                command.append(DAEMON_SIGNAL_READ_CLOCKS).append(SEPARATOR);
+                break;
+            case SET_VALUE:
+                command.append(DAEMON_SIGNAL_SET_VALUE).append(SEPARATOR).append(i.second).append(SEPARATOR).append(i.first).append(SEPARATOR);
+                break;
+            case TIMER_ON:
+                command.append(DAEMON_SIGNAL_TIMER_ON).append(SEPARATOR).append(QString::number(i.number / 1000.0)).append(SEPARATOR);
+                break;
+            case TIMER_OFF:
+                command.append(DAEMON_SIGNAL_TIMER_OFF).append(SEPARATOR);
+                break;
+            case SHAREDMEM_KEY:
+                command.append(DAEMON_SHAREDMEM_KEY).append(SEPARATOR).append(i.first).append(SEPARATOR);
+
+                // daemons which can parse pm_info write a record instead of the text, the others ignore it
+                // and the format of what is in the shared memory tells which one was used
+                if (i.number == DaemonSharedMem::PAYLOAD_CLOCKS_RECORD)
+                    command.append(DAEMON_SHAREDMEM_FORMAT).append(SEPARATOR).append(DAEMON_FORMAT_CLOCKS_RECORD).append(SEPARATOR);
+                break;
+            case ALIVE:
+                command.append(DAEMON_ALIVE).append(SEPARATOR).append(i.number ? '1' : '0').append(SEPARATOR);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return command.toLatin1();
+}
+
+bool DaemonCommand::takeFrame(QByteArray *buffer, quint8 *type, quint32 *requestId, QByteArray *payload) {
+    // length, version, type, request id
+    const int headerSize = sizeof(quint32) + 2 * sizeof(quint8) + sizeof(quint32);
+
+    while (buffer->size() >= headerSize) {
+        QDataStream stream(*buffer);
+        stream.setVersion(QDataStream::Qt_5_7);
+
+        quint32 length;
+        quint8 version;
+        stream >> length >> version >> *type >> *requestId;
+
+        // stream is out of sync, nothing after this can be trusted
+        if (length > DAEMON_FRAME_MAX_LENGTH || length < headerSize - sizeof(quint32)) {
+            qWarning() << "Invalid frame from daemon, dropping received data";
+            buffer->clear();
+            return false;
+        }
+
+        const int frameSize = sizeof(quint32) + length;
+        if (buffer->size() < frameSize)
+            return false;
+
+        *payload = buffer->mid(headerSize, frameSize - headerSize);
+        buffer->remove(0, frameSize);
+
+        if (version == DAEMON_PROTOCOL_VERSION)
+            return true;
+
+        qWarning() << "Skipping frame of unknown protocol version" << version;
+    }
+
+    return false;
+}
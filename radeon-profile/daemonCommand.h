@@ -0,0 +1,92 @@
+#ifndef DAEMONCOMMAND_H
+#define DAEMONCOMMAND_H
+
+#include "daemonSharedMem.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+#define DAEMON_PROTOCOL_VERSION 1
+
+// frame length is big endian and below 16 MiB, so a frame always starts with 0,
+// which never shows up in the legacy text and lets the daemon tell them apart
+#define DAEMON_FRAME_MAX_LENGTH 0xffffff
+
+/**
+ * @brief The DaemonCommand class is a list of typed instructions sent to the daemon in one write.
+ * It is encoded as a frame of the versioned protocol, or as the legacy '#' separated text for old daemons.
+ *
+ * Frame: quint32 length (of what follows), quint8 protocol version, quint8 MessageType, quint32 request id, payload.
+ * Payload of every type is written with QDataStream (Qt_5_7), a BATCH holds quint32 count
+ * and then quint8 type and payload of every instruction.
+ */
+class DaemonCommand
+{
+public:
+    enum MessageType {
+        // client to daemon
+        CONFIG = 1,  // QString name, QString path
+        READ_CLOCKS,
+        SET_VALUE,  // QString file, QString value
+        TIMER_ON,  // quint32 interval in ms
+        TIMER_OFF,
+        SHAREDMEM_KEY,  // QString key, quint8 DaemonSharedMem::PayloadFormat requested
+        ALIVE,  // bool connection confirmation required
+        BATCH,
+
+        // daemon to client
+        STATUS = 64,  // qint32 status (0 or errno), qint32 index of failed instruction (-1)
+        DATA_READY
+    };
+
+    DaemonCommand& config(const QString &name, const QString &path);
+    DaemonCommand& readClocks();
+    DaemonCommand& setValue(const QString &file, const QString &value);
+    DaemonCommand& timerOn(int msec);
+    DaemonCommand& timerOff();
+    DaemonCommand& sharedMemKey(const QString &key, DaemonSharedMem::PayloadFormat format);
+    DaemonCommand& alive(bool confirmationRequired);
+
+    bool isEmpty() const {
+        return instructions.isEmpty();
+    }
+
+    int count() const {
+        return instructions.count();
+    }
+
+    /**
+     * @brief Encode as one frame, a BATCH if there is more than one instruction.
+     * @param requestId Id the daemon puts in its STATUS reply.
+     */
+    QByteArray toFrame(quint32 requestId) const;
+
+    /**
+     * @brief Encode as '#' separated text understood by daemons without the framed protocol.
+     */
+    QByteArray toLegacy() const;
+
+    /**
+     * @brief Split frames from the beginning of buffer, parsed frames are removed from it.
+     * @param buffer Received data, an incomplete frame at the end is left for the next call.
+     * @param type On success is filled with MessageType of the frame.
+     * @param requestId On success is filled with request id of the frame.
+     * @param payload On success is filled with payload of the frame.
+     * @return True if a complete frame was taken from buffer, frames of other protocol versions are skipped.
+     */
+    static bool takeFrame(QByteArray *buffer, quint8 *type, quint32 *requestId, QByteArray *payload);
+
+private:
+    struct Instruction {
+        MessageType type;
+        QString first, second;
+        quint32 number;
+    };
+
+    QVector<Instruction> instructions;
+
+    DaemonCommand& append(MessageType type, const QString &first = QString(), const QString &second = QString(), quint32 number = 0);
+};
+
+#endif // DAEMONCOMMAND_H
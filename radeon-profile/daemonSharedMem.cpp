@@ -0,0 +1,100 @@
+#include "daemonSharedMem.h"
+
+#include <cstring>
+#include <time.h> // clock_gettime()
+
+static inline const char* payloadOf(const void *block) {
+    return static_cast<const char*>(block) + sizeof(DaemonSharedMemHeader);
+}
+
+bool DaemonSharedMem::hasHeader(const void *block) {
+    if (block == nullptr)
+        return false;
+
+    return static_cast<const DaemonSharedMemHeader*>(block)->magic.load(std::memory_order_acquire) == SHARED_MEM_MAGIC;
+}
+
+int DaemonSharedMem::read(const void *block, int blockSize, char *buffer, int size, qint64 *timestamp, PayloadFormat *format) {
+    if (!hasHeader(block) || size <= 0 || blockSize <= static_cast<int>(sizeof(DaemonSharedMemHeader)))
+        return -1;
+
+    const DaemonSharedMemHeader *header = static_cast<const DaemonSharedMemHeader*>(block);
+
+    if (header->version.load(std::memory_order_relaxed) != SHARED_MEM_VERSION)
+        return -1;
+
+    const quint32 capacity = blockSize - sizeof(DaemonSharedMemHeader);
+
+    for (int i = 0; i < SHARED_MEM_READ_RETRIES; ++i) {
+        const quint32 before = header->sequence.load(std::memory_order_acquire);
+
+        // 0 is nothing written yet, odd is write in progress
+        if (before == 0)
+            return -1;
+
+        if (before & 1)
+            continue;
+
+        // unsigned, a length past INT_MAX must not turn negative, it is checked after the copy is consistent
+        const quint32 payloadLength = header->length.load(std::memory_order_relaxed);
+        const int length = static_cast<int>(qMin<quint32>(payloadLength, qMin<quint32>(capacity, size - 1)));
+        const qint64 time = header->timestamp.load(std::memory_order_relaxed);
+        const PayloadFormat payloadFormat = static_cast<PayloadFormat>(header->format.load(std::memory_order_relaxed));
+
+        memcpy(buffer, payloadOf(block), length);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) != before)
+            continue;
+
+        // the writer never stores more than fits, so the block is broken
+        if (payloadLength > capacity)
+            return -1;
+
+        *timestamp = time;
+        *format = payloadFormat;
+
+        if (payloadFormat != PAYLOAD_TEXT)
+            return length;
+
+        int trimmed = length;
+        while (trimmed > 0 && (buffer[trimmed - 1] == '\n' || buffer[trimmed - 1] == ' '
+                               || buffer[trimmed - 1] == '\t' || buffer[trimmed - 1] == '\0'))
+            --trimmed;
+
+        buffer[trimmed] = '\0';
+        return trimmed;
+    }
+
+    return -1;
+}
+
+void DaemonSharedMem::write(void *block, int blockSize, const char *data, int length, qint64 timestamp, PayloadFormat format) {
+    if (blockSize <= static_cast<int>(sizeof(DaemonSharedMemHeader)))
+        return;
+
+    DaemonSharedMemHeader *header = static_cast<DaemonSharedMemHeader*>(block);
+    length = qBound(0, length, static_cast<int>(blockSize - sizeof(DaemonSharedMemHeader)));
+
+    // sequence of a block without header starts from 0
+    const quint32 sequence = hasHeader(block) ? header->sequence.load(std::memory_order_relaxed) & ~1u : 0;
+
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(static_cast<char*>(block) + sizeof(DaemonSharedMemHeader), data, length);
+    header->length.store(length, std::memory_order_relaxed);
+    header->timestamp.store(timestamp, std::memory_order_relaxed);
+    header->format.store(format, std::memory_order_relaxed);
+    header->version.store(SHARED_MEM_VERSION, std::memory_order_relaxed);
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+    header->magic.store(SHARED_MEM_MAGIC, std::memory_order_release);
+}
+
+bool DaemonSharedMem::isStale(qint64 timestamp, qint64 maxAge) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec - timestamp > maxAge;
+}
@@ -0,0 +1,92 @@
+#ifndef DAEMONSHAREDMEM_H
+#define DAEMONSHAREDMEM_H
+
+#include <QtGlobal>
+#include <atomic>
+
+#define SHARED_MEM_MAGIC 0x4d535052 // "RPSM"
+#define SHARED_MEM_VERSION 2
+
+// retries of a read racing with the writer, a write takes a memcpy of the payload
+#define SHARED_MEM_READ_RETRIES 1000
+
+/**
+ * @brief Header at the beginning of the shared memory block the daemon writes pm_info to, the payload follows it.
+ * The block is written with a seqlock: the sequence is odd while the daemon writes, so readers never take
+ * the QSharedMemory semaphore, they copy the payload and retry if the sequence changed meanwhile.
+ * @note Shared with radeon-profile-daemon, any change of the layout needs a new SHARED_MEM_VERSION.
+ */
+struct DaemonSharedMemHeader {
+    std::atomic<quint32> magic; // SHARED_MEM_MAGIC, anything else is the legacy layout (plain text at offset 0)
+    std::atomic<quint32> version;
+    std::atomic<quint32> sequence;
+    std::atomic<quint32> length; // of the payload, in bytes
+    std::atomic<quint32> format; // DaemonSharedMem::PayloadFormat
+    quint32 unused; // keeps timestamp at the same offset on every abi
+    std::atomic<qint64> timestamp; // CLOCK_MONOTONIC when the daemon read the data, in nS
+};
+
+/**
+ * @brief Clocks parsed from pm_info by the daemon, payload in PAYLOAD_CLOCKS_RECORD format.
+ * @note Values not in pm_info are -1.
+ */
+struct DaemonClocksRecord {
+    qint32 sclk, mclk, vclk, dclk; // MHz
+    qint32 vddc, vddci; // mV
+    qint32 powerLevel;
+    qint32 unused;
+    qint64 timestamp; // CLOCK_MONOTONIC when pm_info was read, in nS
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared memory header needs lock free atomics to work across processes");
+
+/**
+ * @brief The DaemonSharedMem class reads and writes the versioned shared memory block shared with the daemon.
+ */
+class DaemonSharedMem
+{
+public:
+    enum PayloadFormat {
+        PAYLOAD_TEXT,  // pm_info content as the daemon read it
+        PAYLOAD_CLOCKS_RECORD  // DaemonClocksRecord, if requested and the daemon supports it
+    };
+
+    /**
+     * @brief Check if the block was written with the header, old daemons write only plain text.
+     * @param block Beginning of the shared memory.
+     */
+    static bool hasHeader(const void *block);
+
+    /**
+     * @brief Copy the payload without locking, trailing whitespace of text is stripped.
+     * @param block Beginning of the shared memory, with header.
+     * @param blockSize Size of the shared memory.
+     * @param buffer Memory area to store the payload, text is always null terminated on success.
+     * @param size Size of the memory area.
+     * @param timestamp On success is filled with the time the daemon read the data.
+     * @param format On success is filled with the PayloadFormat of the data.
+     * @return Number of bytes stored in buffer, -1 if nothing was written yet, the version is unknown,
+     * the length in the header is larger than the block, or the writer was too busy to get a consistent copy.
+     */
+    static int read(const void *block, int blockSize, char *buffer, int size, qint64 *timestamp, PayloadFormat *format);
+
+    /**
+     * @brief Write the payload (what the daemon does), payload longer than the block is cut.
+     * @param block Beginning of the shared memory.
+     * @param blockSize Size of the shared memory.
+     * @param timestamp Time of the data, CLOCK_MONOTONIC in nS.
+     * @param format PayloadFormat of data.
+     */
+    static void write(void *block, int blockSize, const char *data, int length, qint64 timestamp,
+                      PayloadFormat format = PAYLOAD_TEXT);
+
+    /**
+     * @brief Check if data is older than maxAge.
+     * @param timestamp Time of the data, CLOCK_MONOTONIC in nS.
+     * @param maxAge Maximum age in nS.
+     */
+    static bool isStale(qint64 timestamp, qint64 maxAge);
+};
+
+#endif // DAEMONSHAREDMEM_H
@@ -1,18 +1,23 @@
 ﻿// copyright marazmista @ 29.03.2014
 
 #include "dxorg.h"
-#include "gpu.h"
-#include "radeon_profile.h"
+#include "daemonComm.h"
+#include "sysfsEnumerator.h"
 
 #include <QFile>
+#include <QFileInfo>
 #include <QTextStream>
 #include <QTime>
-#include <QCoreApplication>
 #include <QDebug>
 #include <QString>
 #include <QStringList>
+#include <QRegularExpression>
+#include <cstring>
+
+dXorg::dXorg(const GPUSysInfo &si, const InitializationConfig &config) : pmInfoLayout(PmInfoParser::LAYOUT_UNKNOWN),
+    waitingForDaemonData(false), debugfsPmInfoReadable(false), ioctlHnd(nullptr) {
+    setupWriteTimer();
 
-dXorg::dXorg(const GPUSysInfo &si, const InitializationConfig &config) : ioctlHnd(nullptr) {
     features.sysInfo = si;
     initConfig = config;
     configure();
@@ -28,20 +33,71 @@ void dXorg::configure() {
         return;
     }
 
-    if (radeon_profile::dcomm.isConnected() && initConfig.daemonData) {
+    if (DaemonComm::instance().isConnected() && initConfig.daemonData) {
         qDebug() << "Confguring shared memory for daemon";
         setupSharedMem();
         sendSharedMemInfoToDaemon();
 
         // fist call after setup to read pm_file, so notihing is in sharedmem and we need to wait for data
-        // because we need correctly figure out what is available
-        // see: https://stackoverflow.com/a/11487434/2347196
-        QTime delayTime = QTime::currentTime().addMSecs(1200);
-        qDebug() << "Waiting for first daemon data read...";
-        while (QTime::currentTime() < delayTime)
-            QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+        // because we need correctly figure out what is available, the owner waits without blocking
+        // and calls finishConfiguration() (see gpu::initialize())
+        waitingForDaemonData = true;
+        return;
+    }
+
+    figureOutDriverFeatures();
+}
+
+bool dXorg::isWaitingForDaemonData() const {
+    return waitingForDaemonData;
+}
+
+// shared memory is zeroed on create, so anything in it came from the daemon
+bool dXorg::hasDaemonData() {
+    if (!sharedMem.isAttached())
+        return false;
+
+    if (DaemonSharedMem::hasHeader(sharedMem.constData())) {
+        char buffer[SHARED_MEM_SIZE];
+        qint64 timestamp;
+        DaemonSharedMem::PayloadFormat format;
+        return DaemonSharedMem::read(sharedMem.constData(), sharedMem.size(), buffer, sizeof(buffer), &timestamp, &format) > 0;
     }
 
+    if (!sharedMem.lock())
+        return false;
+
+    const char *data = static_cast<const char*>(sharedMem.constData());
+    const bool filled = data != nullptr && data[0] != '\0';
+
+    sharedMem.unlock();
+    return filled;
+}
+
+void dXorg::finishConfiguration() {
+    if (!waitingForDaemonData)
+        return;
+
+    waitingForDaemonData = false;
+    figureOutDriverFeatures();
+}
+
+void dXorg::setDaemonData(bool enabled) {
+    if (initConfig.daemonData == enabled || initConfig.rootMode)
+        return;
+
+    initConfig.daemonData = enabled;
+
+    if (enabled && DaemonComm::instance().isConnected()) {
+        // the daemon is pointed to pm_info of this card and the shared memory of this handler,
+        // features are figured out again with its first read, as in configure()
+        setupSharedMem();
+        sendSharedMemInfoToDaemon();
+        waitingForDaemonData = true;
+        return;
+    }
+
+    waitingForDaemonData = false;
     figureOutDriverFeatures();
 }
 
@@ -50,10 +106,13 @@ dXorg::InitializationConfig dXorg::getInitConfig() {
 }
 
 void dXorg::setupIoctl() {
+    // "cardN", N can have more digits on hosts with many cards
+    const unsigned cardIndex = features.sysInfo.sysName.mid(4).toUInt();
+
     if (features.sysInfo.module == DriverModule::RADEON)
-        ioctlHnd = new radeonIoctlHandler(features.sysInfo.sysName[4].toLatin1() - '0');
+        ioctlHnd = new radeonIoctlHandler(cardIndex);
     else if (features.sysInfo.module == DriverModule::AMDGPU)
-        ioctlHnd = new amdgpuIoctlHandler(features.sysInfo.sysName[4].toLatin1() - '0');
+        ioctlHnd = new amdgpuIoctlHandler(cardIndex);
 }
 
 QString getValueFromSysFsFile(QString fileName) {
@@ -67,6 +126,63 @@ QString getValueFromSysFsFile(QString fileName) {
     return value;
 }
 
+void dXorg::clearSysfsCache() {
+    qDeleteAll(sysfsCache);
+    sysfsCache.clear();
+}
+
+void dXorg::setupSysfsCache() {
+    clearSysfsCache();
+
+    QStringList files = QStringList() << driverFiles.hwmonAttributes.temp1
+                                            << driverFiles.hwmonAttributes.pwm1
+                                            << driverFiles.hwmonAttributes.fan1_input
+                                            << driverFiles.hwmonAttributes.power1_cap
+                                            << driverFiles.hwmonAttributes.power1_average
+                                            << driverFiles.sysFs.gpu_busy_percent
+                                            << driverFiles.sysFs.power_dpm_state
+                                            << driverFiles.sysFs.power_profile
+                                            << driverFiles.sysFs.power_dpm_force_performance_level;
+
+    if (debugfsPmInfoReadable)
+        files << driverFiles.debugfs_pm_info;
+
+    for (const QString &file : files) {
+        if (!file.isEmpty() && !sysfsCache.contains(file))
+            sysfsCache.insert(file, new SysfsAttribute(file));
+    }
+}
+
+// files not in cache (read once at init) are opened for the single read
+bool dXorg::readSysfsInt(const QString &file, long long *value) const {
+    SysfsAttribute *attribute = sysfsCache.value(file, nullptr);
+
+    if (attribute != nullptr)
+        return attribute->readInt(value);
+
+    SysfsAttribute uncached(file);
+    return uncached.readInt(value);
+}
+
+QString dXorg::readSysfsString(const QString &file) const {
+    SysfsAttribute *attribute = sysfsCache.value(file, nullptr);
+
+    if (attribute == nullptr)
+        return getValueFromSysFsFile(file);
+
+    return attribute->readString();
+}
+
+int dXorg::readSysfsRaw(const QString &file, char *buffer, int size) const {
+    SysfsAttribute *attribute = sysfsCache.value(file, nullptr);
+
+    if (attribute != nullptr)
+        return attribute->read(buffer, size);
+
+    SysfsAttribute uncached(file);
+    return uncached.read(buffer, size);
+}
+
 
 //https://stackoverflow.com/a/18866593
 QString getRandomString() {
@@ -105,26 +221,26 @@ void dXorg::setupSharedMem() {
 }
 
 void dXorg::sendSharedMemInfoToDaemon() {
-    QString command;
-    command.append(DAEMON_SIGNAL_CONFIG).append(SEPARATOR);
-    command.append("pm_info").append(SEPARATOR).append(driverFiles.debugfs_pm_info).append(SEPARATOR);
-    command.append(DAEMON_SHAREDMEM_KEY).append(SEPARATOR).append(sharedMem.key()).append(SEPARATOR);
+    DaemonCommand command;
+    command.config("pm_info", driverFiles.debugfs_pm_info);
+    command.sharedMemKey(sharedMem.key(), DaemonSharedMem::PAYLOAD_CLOCKS_RECORD);
 
     if (!initConfig.daemonAutoRefresh)
-        command.append(DAEMON_SIGNAL_READ_CLOCKS).append(SEPARATOR);
+        command.readClocks();
 
-    qDebug() << "Sending daemon shared mem info: " << command;
-    radeon_profile::dcomm.sendCommand(command);
+    qDebug() << "Sending daemon shared mem info";
+    DaemonComm::instance().sendCommand(command);
 }
 
 void dXorg::figureOutGpuDataFilePaths(const QString &gpuName) {
-    QString devicePath = "/sys/class/drm/" + gpuName + "/device/";
+    QString devicePath = globalStuff::systemPath("/sys/class/drm/" + gpuName + "/device/");
     driverFiles.moduleParams = devicePath + "driver/module/parameters/";
-    driverFiles.debugfs_pm_info = "/sys/kernel/debug/dri/" + gpuName.right(1) + "/"+features.sysInfo.driverModuleString + "_pm_info"; // this path contains only index
+    driverFiles.debugfs_pm_info = globalStuff::systemPath("/sys/kernel/debug/dri/") + gpuName.mid(4) + "/"+features.sysInfo.driverModuleString + "_pm_info"; // this path contains only index
+    debugfsPmInfoReadable = QFileInfo(driverFiles.debugfs_pm_info).isReadable();
     driverFiles.sysFs = DeviceSysFs(devicePath);
 
     // look for hwmon devices in card dir
-    QString hwmonDevicePath = globalStuff::grabSystemInfo("ls "+ devicePath + "hwmon/")[0];
+    QString hwmonDevicePath = SysfsEnumerator::entries(devicePath + "hwmon/").value(0);
 
     hwmonDevicePath =  devicePath + "hwmon/" + ((hwmonDevicePath.isEmpty() ? "hwmon0/" : hwmonDevicePath + "/"));
 
@@ -134,24 +250,53 @@ void dXorg::figureOutGpuDataFilePaths(const QString &gpuName) {
 }
 
 // method for gather info about clocks from deamon or from debugfs if root
-QString dXorg::getClocksRawData() {
-    QString data;
+// returns length of data stored in buffer, -1 if nothing is available
+int dXorg::getClocksRawData(char *buffer, int size, DaemonSharedMem::PayloadFormat *format) {
+    *format = DaemonSharedMem::PAYLOAD_TEXT;
 
-    data = getValueFromSysFsFile(driverFiles.debugfs_pm_info);
-    if (data != "-1")
-        return data;
+    int length = -1;
 
-    if (radeon_profile::dcomm.isConnected()) {
+    // debugfs is readable only by root, without it every attempt would be a failed open
+    if (debugfsPmInfoReadable) {
+        length = readSysfsRaw(driverFiles.debugfs_pm_info, buffer, size);
+        if (length != -1)
+            return length;
+    }
+
+    // only the handler the daemon reads pm_info for has the shared memory
+    if (initConfig.daemonData && DaemonComm::instance().isConnected()) {
         if (!initConfig.daemonAutoRefresh){
             qDebug() << "Asking the daemon to read clocks";
-            radeon_profile::dcomm.sendCommand(QString(DAEMON_SIGNAL_READ_CLOCKS).append(SEPARATOR)); // SIGNAL_READ_CLOCKS + SEPARATOR
+
+            // called from the sampler thread, the socket belongs to the gui thread
+            QMetaObject::invokeMethod(&DaemonComm::instance(), "requestClocksRead", Qt::AutoConnection);
+        }
+
+        // daemons with the versioned layout are read without the semaphore
+        const void *block = sharedMem.constData();
+        if (DaemonSharedMem::hasHeader(block)) {
+            qint64 timestamp;
+            length = DaemonSharedMem::read(block, sharedMem.size(), buffer, size, &timestamp, format);
+
+            if (length != -1 && DaemonSharedMem::isStale(timestamp, DAEMON_DATA_MAX_AGE)) {
+                qWarning() << "Daemon data in shared memory is stale";
+                length = -1;
+            }
+
+            return length;
         }
 
        if (sharedMem.lock()) {
             const char *to = (const char*)sharedMem.constData();
             if (to != NULL) {
                 qDebug() << "Reading data from shared memory";
-                data = QString(QByteArray::fromRawData(to, SHARED_MEM_SIZE)).trimmed();
+                length = qstrnlen(to, qMin(size - 1, SHARED_MEM_SIZE));
+                memcpy(buffer, to, length);
+
+                while (length > 0 && QChar::isSpace(buffer[length - 1]))
+                    --length;
+
+                buffer[length] = '\0';
             } else
                 qWarning() << "Shared memory data pointer is invalid: " << sharedMem.errorString();
             sharedMem.unlock();
@@ -159,13 +304,32 @@ QString dXorg::getClocksRawData() {
             qWarning() << "Unable to lock the shared memory: " << sharedMem.errorString();
     }
 
-    return data;
+    return length;
+}
+
+SensorSnapshot dXorg::sampleSensors() const {
+    SensorSnapshot sensors;
+
+    if (ioctlHnd != nullptr)
+        ioctlHnd->sampleAll(&sensors);
+
+    return sensors;
+}
+
+void dXorg::startBackgroundSampling() {
+    if (ioctlHnd != nullptr)
+        ioctlHnd->startBackgroundSampling();
+}
+
+void dXorg::stopBackgroundSampling() {
+    if (ioctlHnd != nullptr)
+        ioctlHnd->stopBackgroundSampling();
 }
 
-GPUClocks dXorg::getClocks() {
+GPUClocks dXorg::getClocks(const SensorSnapshot &sensors) {
     switch (features.clocksDataSource) {
         case ClocksDataSource::IOCTL:
-            return getClocksFromIoctl();
+            return getClocksFromIoctl(sensors);
         case ClocksDataSource::PM_FILE:
             return getClocksFromPmFile();
         case ClocksDataSource::SOURCE_UNKNOWN:
@@ -175,11 +339,12 @@ GPUClocks dXorg::getClocks() {
     return GPUClocks();
 }
 
-GPUClocks dXorg::getClocksFromIoctl() {
+GPUClocks dXorg::getClocksFromIoctl(const SensorSnapshot &sensors) {
     GPUClocks clocksData;
 
-    ioctlHnd->getCoreClock(&clocksData.coreClk);
-    ioctlHnd->getMemoryClock(&clocksData.memClk);
+    clocksData.coreClk = sensors.coreClock;
+    clocksData.memClk = sensors.memoryClock;
+    clocksData.coreVolt = sensors.vddgfx;
 
     return clocksData;
 }
@@ -187,62 +352,26 @@ GPUClocks dXorg::getClocksFromIoctl() {
 
 GPUClocks dXorg::getClocksFromPmFile() {
     GPUClocks clocksData;
-    QString data = dXorg::getClocksRawData();
+    char data[SHARED_MEM_SIZE];
+    DaemonSharedMem::PayloadFormat format;
+    int length = getClocksRawData(data, sizeof(data), &format);
 
     // if nothing is there returns empty (-1) struct
-    if (data.isEmpty()) {
+    if (length <= 0) {
         qDebug() << "Can't get clocks, no data available";
         return clocksData;
     }
 
-    switch (features.currentPowerMethod) {
-        case PowerMethod::DPM: {
-            QRegExp rx;
-
-            rx.setPattern(rxPatterns.powerLevel);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty())
-                clocksData.powerLevel = rx.cap(0).split(' ')[2].toShort();
-
-            rx.setPattern(rxPatterns.sclk);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty())
-                clocksData.coreClk = rx.cap(0).split(' ',QString::SkipEmptyParts)[rxMatchIndex].toFloat() / dXorg::clocksValueDivider;
-
-            rx.setPattern(rxPatterns.mclk);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty())
-                clocksData.memClk = rx.cap(0).split(' ',QString::SkipEmptyParts)[rxMatchIndex].toFloat() / dXorg::clocksValueDivider;
-
-            rx.setPattern(rxPatterns.vclk);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty()) {
-                clocksData.uvdCClk = rx.cap(0).split(' ',QString::SkipEmptyParts)[rxMatchIndex].toFloat() / dXorg::clocksValueDivider;
-                clocksData.uvdCClk  = (clocksData.uvdCClk  == 0) ? -1 :  clocksData.uvdCClk;
-            }
-
-            rx.setPattern(rxPatterns.dclk);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty()) {
-                clocksData.uvdDClk = rx.cap(0).split(' ',QString::SkipEmptyParts)[rxMatchIndex].toFloat() / dXorg::clocksValueDivider;
-                clocksData.uvdDClk = (clocksData.uvdDClk == 0) ? -1 : clocksData.uvdDClk;
-            }
-
-            rx.setPattern(rxPatterns.vddc);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty())
-                clocksData.coreVolt = rx.cap(0).split(' ',QString::SkipEmptyParts)[rxMatchIndex].toInt();
+    // already parsed by the daemon
+    if (format == DaemonSharedMem::PAYLOAD_CLOCKS_RECORD)
+        return PmInfoParser::parseRecord(data, length);
 
-            rx.setPattern(rxPatterns.vddci);
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty())
-                clocksData.memVolt = rx.cap(0).split(' ',QString::SkipEmptyParts)[rxMatchIndex].toInt();
-
-            return clocksData;
-        }
+    switch (features.currentPowerMethod) {
+        case PowerMethod::DPM:
+            return PmInfoParser::parse(pmInfoLayout, data, length);
 
         case PowerMethod::PROFILE: {
-            QStringList dataStr = data.split("\n");
+            QStringList dataStr = QString::fromLatin1(data, length).split("\n");
             for (int i = 0; i < dataStr.count(); ++i) {
                 switch (i) {
                     case 1:
@@ -273,40 +402,33 @@ GPUClocks dXorg::getClocksFromPmFile() {
 }
 
 float dXorg::getTemperature() {
-    QString temp;
+    long long milliCelsius;
 
     switch (features.currentTemperatureSensor) {
         case TemperatureSensor::SYSFS_HWMON:
         case TemperatureSensor::CARD_HWMON:
-            return getValueFromSysFsFile(driverFiles.hwmonAttributes.temp1).toFloat() / 1000;
-        case TemperatureSensor::PCI_SENSOR: {
-            QStringList out = globalStuff::grabSystemInfo("sensors");
-            temp = out[sensorsGPUtempIndex+2].split(" ",QString::SkipEmptyParts)[1].remove("+").remove("C").remove("°");
-            break;
-        }
-        case TemperatureSensor::MB_SENSOR: {
-            QStringList out = globalStuff::grabSystemInfo("sensors");
-            temp = out[sensorsGPUtempIndex].split(" ",QString::SkipEmptyParts)[1].remove("+").remove("C").remove("°");
-            break;
-        }
+        case TemperatureSensor::PCI_SENSOR:
+        case TemperatureSensor::MB_SENSOR:
+            // every sensor is resolved to a hwmon tempN_input at init
+            return readSysfsInt(driverFiles.hwmonAttributes.temp1, &milliCelsius) ? milliCelsius / 1000.0f : -1;
         case TemperatureSensor::TS_UNKNOWN:
-            temp = "-1";
             break;
     }
 
-    return temp.toFloat();
+    return -1;
 }
 
-GPUUsage dXorg::getGPUUsage() {
+GPUUsage dXorg::getGPUUsage(const SensorSnapshot &sensors) {
     GPUUsage data;
 
-    ioctlHnd->getGpuUsage(&data.gpuUsage);
+    data.gpuUsage = sensors.gpuUsage;
 
-    if (data.gpuUsage == -1 && !driverFiles.sysFs.gpu_busy_percent.isEmpty())
-        data.gpuUsage = getValueFromSysFsFile(driverFiles.sysFs.gpu_busy_percent).toFloat();
-
-    ioctlHnd->getVramUsage(&data.gpuVramUsage);
+    long long busyPercent;
+    if (data.gpuUsage == -1 && !driverFiles.sysFs.gpu_busy_percent.isEmpty()
+            && readSysfsInt(driverFiles.sysFs.gpu_busy_percent, &busyPercent))
+        data.gpuUsage = busyPercent;
 
+    data.gpuVramUsage = sensors.vramUsage;
     data.gpuVramUsage /= 1048576; // 1024 * 1024
     data.gpuVramUsagePercent = (100 * data.gpuVramUsage) / params.VRAMSize;
 
@@ -331,7 +453,7 @@ TemperatureSensor dXorg::getTemperatureSensor() {
 
     // first method, try read temp from sysfs in card dir (path from figureOutGPUDataPaths())
     QString tmpValue = getValueFromSysFsFile(driverFiles.hwmonAttributes.temp1);
-    if (!tmpValue.isEmpty() || tmpValue != "-1")
+    if (!tmpValue.isEmpty() && tmpValue != "-1")
         return TemperatureSensor::CARD_HWMON;
     else {
         // second method, try find in system hwmon dir for file labeled VGA_TEMP
@@ -339,37 +461,101 @@ TemperatureSensor dXorg::getTemperatureSensor() {
         if (!driverFiles.hwmonAttributes.temp1.isEmpty())
             return TemperatureSensor::SYSFS_HWMON;
 
-        // if above fails, use lm_sensors
-        QStringList out = globalStuff::grabSystemInfo("sensors");
-        if (out.indexOf(QRegExp(features.sysInfo.driverModuleString+"-pci.+")) != -1) {
-            sensorsGPUtempIndex = out.indexOf(QRegExp(features.sysInfo.driverModuleString+"-pci.+"));  // in order to not search for it again in timer loop
+        // third method, hwmon chip named after the driver, the one lm_sensors shows as <module>-pci
+        // its temp1_input is read like other hwmon attributes instead of running sensors on every refresh
+        driverFiles.hwmonAttributes.temp1 = findSysfsHwmonTempByChipName(features.sysInfo.driverModuleString);
+        if (!driverFiles.hwmonAttributes.temp1.isEmpty())
             return TemperatureSensor::PCI_SENSOR;
-        }
-        else if (out.indexOf(QRegExp("VGA_TEMP.+")) != -1) {
-            sensorsGPUtempIndex = out.indexOf(QRegExp("VGA_TEMP.+"));
+
+        // last, VGA_TEMP label set in lm_sensors config, sensors is run once here to find the chip and input
+        driverFiles.hwmonAttributes.temp1 = findSysfsHwmonTempBySensorsLabel("VGA_TEMP");
+        if (!driverFiles.hwmonAttributes.temp1.isEmpty())
             return TemperatureSensor::MB_SENSOR;
-        }
     }
     return TemperatureSensor::TS_UNKNOWN;
 }
 
+// temperature labeled VGA_TEMP by the hwmon driver, labels are in the hwmon dir or in device subdir on older kernels
 QString dXorg::findSysfsHwmonForGPU() {
-    QStringList hwmonDev = globalStuff::grabSystemInfo("ls /sys/class/hwmon/");
+    static const QRegularExpression rxLabel("^temp\\d+_label$");
+    const QStringList hwmonDev = SysfsEnumerator::hwmonDevices();
 
-    for (int i = 0; i < hwmonDev.count(); i++) {
-        QStringList temp = globalStuff::grabSystemInfo("ls /sys/class/hwmon/"+hwmonDev[i]+"/device/").filter("label");
+    for (const QString &hwmon : hwmonDev) {
+        for (const QString &dir : { globalStuff::systemPath("/sys/class/hwmon/") + hwmon + "/",
+                                    globalStuff::systemPath("/sys/class/hwmon/") + hwmon + "/device/" }) {
+            const QStringList labels = SysfsEnumerator::entries(dir, rxLabel);
 
-        for (int o = 0; o < temp.count(); o++) {
-            QString file("/sys/class/hwmon/"+hwmonDev[i]+"/device/"+temp[o]);
-            QString s = getValueFromSysFsFile(file);
-            if (!s.isEmpty() && s.contains("VGA_TEMP"))
-                return file.replace("label", "input");
+            for (const QString &label : labels) {
+                if (!getValueFromSysFsFile(dir + label).contains("VGA_TEMP"))
+                    continue;
+
+                const QString input = dir + QString(label).replace("_label", "_input");
+                if (QFile::exists(input))
+                    return input;
+            }
         }
     }
 
     return "";
 }
 
+// 'sensors -u' lists chips ("it8721-isa-0290") with labels ("VGA_TEMP:") followed by their inputs ("  temp2_input: 45.000")
+QString dXorg::findSysfsHwmonTempBySensorsLabel(const QString &label) {
+    const QStringList out = globalStuff::grabSystemInfo("sensors -u");
+    QString chip;
+
+    for (int i = 0; i < out.count(); ++i) {
+        const QString &line = out.at(i);
+
+        if (line.isEmpty() || line.at(0).isSpace())
+            continue;
+
+        if (!line.contains(':')) {
+            chip = line.section('-', 0, 0);
+            continue;
+        }
+
+        if (chip.isEmpty() || line.section(':', 0, 0) != label)
+            continue;
+
+        for (int o = i + 1; o < out.count() && !out.at(o).isEmpty() && out.at(o).at(0).isSpace(); ++o) {
+            const QString input = out.at(o).trimmed().section(':', 0, 0);
+
+            if (input.startsWith("temp") && input.endsWith("_input"))
+                return findSysfsHwmonTempByChipName(chip, input);
+        }
+    }
+
+    return "";
+}
+
+// hwmon chips of the driver, when there is more than one, the one which belongs to this card is taken
+QString dXorg::findSysfsHwmonTempByChipName(const QString &chipName, const QString &inputName) {
+    const QString cardDevice = QFileInfo(globalStuff::systemPath("/sys/class/drm/") + features.sysInfo.sysName + "/device").canonicalFilePath();
+    const QStringList hwmonDev = SysfsEnumerator::hwmonDevices();
+    QString firstMatch;
+
+    for (const QString &hwmon : hwmonDev) {
+        const QString hwmonPath = globalStuff::systemPath("/sys/class/hwmon/") + hwmon + "/";
+
+        // older kernels keep attributes in device subdir
+        QString input = hwmonPath + inputName;
+        if (!QFile::exists(input))
+            input = hwmonPath + "device/" + inputName;
+
+        if (getValueFromSysFsFile(hwmonPath + "name") != chipName || !QFile::exists(input))
+            continue;
+
+        if (QFileInfo(hwmonPath + "device").canonicalFilePath() == cardDevice)
+            return input;
+
+        if (firstMatch.isEmpty())
+            firstMatch = input;
+    }
+
+    return firstMatch;
+}
+
 QList<QTreeWidgetItem *> dXorg::getModuleInfo() {
     QList<QTreeWidgetItem *> data;
     QStringList modInfo = globalStuff::grabSystemInfo("modinfo -p "+features.sysInfo.driverModuleString);
@@ -401,10 +587,10 @@ QList<QTreeWidgetItem *> dXorg::getModuleInfo() {
 QString dXorg::getCurrentPowerProfile() {
     switch (features.currentPowerMethod) {
         case PowerMethod::DPM:
-            return getValueFromSysFsFile(driverFiles.sysFs.power_dpm_state);
+            return readSysfsString(driverFiles.sysFs.power_dpm_state);
 
         case PowerMethod::PROFILE:
-            return getValueFromSysFsFile(driverFiles.sysFs.power_profile);
+            return readSysfsString(driverFiles.sysFs.power_profile);
 
         case PowerMethod::PM_UNKNOWN:
             return "err";
@@ -414,29 +600,138 @@ QString dXorg::getCurrentPowerProfile() {
 }
 
 QString dXorg::getCurrentPowerLevel() {
-    return getValueFromSysFsFile(driverFiles.sysFs.power_dpm_force_performance_level);
+    return readSysfsString(driverFiles.sysFs.power_dpm_force_performance_level);
+}
+
+void dXorg::setupWriteTimer() {
+    writeTimer.setSingleShot(true);
+    writeTimer.setInterval(WRITE_COALESCE_WINDOW);
+    QObject::connect(&writeTimer, &QTimer::timeout, [this]() {
+        flushWrites();
+    });
+
+    // the daemon couldn't write the value, so the same one must not be skipped next time
+    QObject::connect(&DaemonComm::instance(), &DaemonComm::commandFinished, &writeTimer, [this](quint32 requestId, int status) {
+        QMutexLocker locker(&writesMutex);
+        const QStringList paths = unconfirmedWrites.take(requestId);
+
+        if (status != 0) {
+            for (const QString &path : paths)
+                lastWrittenValues.remove(path);
+        }
+    });
+}
+
+// only plain values, the fan controller sets the same pwm on every temperature change
+bool dXorg::isDeduplicated(const QString &path) const {
+    return path == driverFiles.hwmonAttributes.pwm1 || path == driverFiles.hwmonAttributes.power1_cap;
 }
 
 void dXorg::setNewValue(const QString &filePath, const QString &newValue) {
-    if (radeon_profile::dcomm.isConnected())
-        radeon_profile::dcomm.sendCommand(createDaemonSetCmd(filePath, newValue));
-    else {
-        QFile file(filePath);
+    QMutexLocker locker(&writesMutex);
+    ++writeStatistics.requested;
+
+    // pp_od_clk_voltage takes commands, every one of them counts and the order matters
+    if (filePath != driverFiles.sysFs.pp_od_clk_voltage) {
+        for (PendingWrite &write : pendingWrites) {
+            if (write.path == filePath) {
+                // keeps its place, the flush is already scheduled
+                write.value = newValue;
+                ++writeStatistics.suppressed;
+                return;
+            }
+        }
+    }
+
+    PendingWrite write;
+    write.path = filePath;
+    write.value = newValue;
+    pendingWrites.append(write);
 
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream stream(&file);
-            stream << newValue + "\n";
+    // timers can't be started from another thread, the start is queued to the one of writeTimer
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QMetaObject::invokeMethod(&writeTimer, "start", Qt::QueuedConnection);
+    }
+}
 
-            if (!file.flush())
-                qWarning() << "Failed to flush " << filePath;
+void dXorg::flushWrites() {
+    writeTimer.stop();
 
-            file.close();
+    QMutexLocker locker(&writesMutex);
+    flushScheduled = false;
 
-        } else
-            qWarning() << "Unable to open " << filePath << " to write " << newValue;
+    if (pendingWrites.isEmpty())
+        return;
+
+    DaemonCommand command;
+    QStringList deduplicatedPaths;
+    const bool daemonConnected = DaemonComm::instance().isConnected();
+    const quint64 issuedBefore = writeStatistics.issued;
+
+    for (const PendingWrite &write : pendingWrites) {
+        if (isDeduplicated(write.path)) {
+            if (lastWrittenValues.value(write.path) == write.value) {
+                ++writeStatistics.suppressed;
+                continue;
+            }
+
+            lastWrittenValues.insert(write.path, write.value);
+            deduplicatedPaths.append(write.path);
+        }
+
+        // driver can change pwm when the mode changes, so it has to be written again
+        if (write.path == driverFiles.hwmonAttributes.pwm1_enable)
+            lastWrittenValues.remove(driverFiles.hwmonAttributes.pwm1);
+
+        ++writeStatistics.issued;
+
+        if (daemonConnected)
+            command.setValue(write.path, write.value);
+        else if (!writeFile(write.path, write.value))
+            lastWrittenValues.remove(write.path);
+    }
+
+    pendingWrites.clear();
+
+    if (writeStatistics.issued == issuedBefore)
+        return;
+
+    ++writeStatistics.batches;
+
+    if (daemonConnected) {
+        // legacy daemons don't answer, what they got is taken as written
+        const quint32 requestId = DaemonComm::instance().sendCommand(command);
+
+        if (requestId != 0 && !deduplicatedPaths.isEmpty())
+            unconfirmedWrites.insert(requestId, deduplicatedPaths);
     }
 }
 
+const dXorg::WriteStatistics& dXorg::getWriteStatistics() const {
+    return writeStatistics;
+}
+
+bool dXorg::writeFile(const QString &filePath, const QString &newValue) {
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Unable to open " << filePath << " to write " << newValue;
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream << newValue + "\n";
+
+    if (!file.flush()) {
+        qWarning() << "Failed to flush " << filePath;
+        return false;
+    }
+
+    file.close();
+    return true;
+}
+
 void dXorg::setPowerProfile(PowerProfiles newPowerProfile) {
     QString newValue;
     switch (newPowerProfile) {
@@ -508,84 +803,23 @@ void dXorg::setForcePowerLevel(ForcePowerLevels newForcePowerLevel) {
 GPUFanSpeed dXorg::getFanSpeed() {
     GPUFanSpeed tmp;
 
+    long long value;
+
     if (driverFiles.hwmonAttributes.pwm1.isEmpty())
         return tmp;
 
-    tmp.fanSpeedPercent = (getValueFromSysFsFile(driverFiles.hwmonAttributes.pwm1).toFloat() / params.pwmMaxSpeed) * 100;
+    if (readSysfsInt(driverFiles.hwmonAttributes.pwm1, &value))
+        tmp.fanSpeedPercent = (static_cast<float>(value) / params.pwmMaxSpeed) * 100;
 
-    if (!driverFiles.hwmonAttributes.fan1_input.isEmpty())
-        tmp.fanSpeedRpm = getValueFromSysFsFile(driverFiles.hwmonAttributes.fan1_input).toInt();
+    if (!driverFiles.hwmonAttributes.fan1_input.isEmpty() && readSysfsInt(driverFiles.hwmonAttributes.fan1_input, &value))
+        tmp.fanSpeedRpm = value;
 
     return tmp;
 }
 
-void dXorg::setupRegex(const QString &data) {
-    QRegExp rx;
-
-    switch (features.sysInfo.module) {
-        case DriverModule::RADEON:
-            rx.setPattern("sclk:\\s\\d+");
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty()) {
-                dXorg::rxPatterns.powerLevel = "power\\slevel\\s\\d",
-                        dXorg::rxPatterns.sclk = "sclk:\\s\\d+",
-                        dXorg::rxPatterns.mclk = "mclk:\\s\\d+",
-                        dXorg::rxPatterns.vclk = "vclk:\\s\\d+",
-                        dXorg::rxPatterns.dclk = "dclk:\\s\\d+",
-                        dXorg::rxPatterns.vddc = "vddc:\\s\\d+",
-                        dXorg::rxPatterns.vddci = "vddci:\\s\\d+";
-
-                rxMatchIndex = 1;
-                clocksValueDivider = 100;
-
-
-            }
-            return;
-
-        case DriverModule::AMDGPU:
-            rx.setPattern("\\[\\s+sclk\\s+\\]:\\s\\d+");
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty()) {
-                dXorg::rxPatterns.sclk = "\\[\\s+sclk\\s+\\]:\\s\\d+",
-                        dXorg::rxPatterns.mclk = "\\[\\s+mclk\\s+\\]:\\s\\d+";
-
-                rxMatchIndex = 3;
-                clocksValueDivider = 1;
-                return;
-            }
-
-
-            rx.setPattern("\\d+\\s\\w+\\s\\(SCLK\\)");
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty()) {
-                dXorg::rxPatterns.sclk = "\\d+\\s\\w+\\s\\(SCLK\\)",
-                        dXorg::rxPatterns.mclk = "\\d+\\s\\w+\\s\\(MCLK\\)";
-
-                rxMatchIndex = 0;
-                clocksValueDivider = 1;
-                return;
-            }
-
-            rx.setPattern("sclk:\\s\\d+");
-            rx.indexIn(data);
-            if (!rx.cap(0).isEmpty()) {
-                dXorg::rxPatterns.powerLevel = "power\\slevel\\s\\d",
-                        dXorg::rxPatterns.sclk = "sclk:\\s\\d+",
-                        dXorg::rxPatterns.mclk = "mclk:\\s\\d+",
-                        dXorg::rxPatterns.vclk = "vclk:\\s\\d+",
-                        dXorg::rxPatterns.dclk = "dclk:\\s\\d+",
-                        dXorg::rxPatterns.vddc = "vddc:\\s\\d+",
-                        dXorg::rxPatterns.vddci = "vddci:\\s\\d+";
-
-                rxMatchIndex = 1;
-                clocksValueDivider = 100;
-            }
-
-            return;
-
-        case DriverModule::MODULE_UNKNOWN:
-            return;
-    }
+void dXorg::setupPmInfoLayout(const char *data, int length) {
+    pmInfoLayout = PmInfoParser::detectLayout(features.sysInfo.module, data, length);
+    qDebug() << "pm_info layout: " << pmInfoLayout;
 }
 
 void dXorg::figureOutDriverFeatures() {
@@ -595,9 +829,16 @@ void dXorg::figureOutDriverFeatures() {
         features.clocksDataSource = ClocksDataSource::IOCTL;
     else {
         features.clocksDataSource = ClocksDataSource::PM_FILE;
-        QString data = getClocksRawData();
-        setupRegex(data);
-        GPUClocks test = getClocks();
+
+        char data[SHARED_MEM_SIZE];
+        DaemonSharedMem::PayloadFormat format;
+        int length = getClocksRawData(data, sizeof(data), &format);
+
+        // the layout matters only for text, a record is the same for every driver
+        if (format == DaemonSharedMem::PAYLOAD_TEXT)
+            setupPmInfoLayout(data, qMax(length, 0));
+
+        GPUClocks test = getClocksFromPmFile();
 
         // still, sometimes there is miscomunication between daemon,
         // but vales are there, so look again in the file which daemon has
@@ -612,7 +853,7 @@ void dXorg::figureOutDriverFeatures() {
         case PowerMethod::DPM:
             qDebug() << "Power method: DPM";
 
-            if (initConfig.rootMode || radeon_profile::dcomm.isConnected())
+            if (initConfig.rootMode || DaemonComm::instance().isConnected())
                 features.isChangeProfileAvailable = true;
             else {
                 QFile f(driverFiles.sysFs.power_dpm_state);
@@ -656,10 +897,15 @@ void dXorg::figureOutDriverFeatures() {
 
         features.isVDDCCurveAvailable = features.currentStatesTables.contains(OD_VDDC_CURVE);
     }
+
+    setupSysfsCache();
 }
 
 void dXorg::refreshPowerPlayTables()
 {
+    // tables have to show what was just set
+    flushWrites();
+
     if (!driverFiles.sysFs.pp_dpm_sclk.isEmpty())
         features.sclkTable = loadPowerPlayTable(driverFiles.sysFs.pp_dpm_sclk);
 
@@ -722,17 +968,6 @@ GPUClocks dXorg::getFeaturesFallback() {
     return fallbackfeatures;
 }
 
-QString dXorg::createDaemonSetCmd(const QString &file, const QString &value)
-{
-    QString command;
-    command.append(DAEMON_SIGNAL_SET_VALUE).append(SEPARATOR);
-    command.append(value).append(SEPARATOR);
-    command.append(file).append(SEPARATOR);
-
-    qDebug() << "Daemon command: " << command;
-
-    return command;
-}
 
 QStringList dXorg::loadPowerPlayTable(const QString &file) {
     QStringList ppt;
@@ -762,20 +997,26 @@ int dXorg::getCurrentPowerPlayTableId(const QString &file) {
     return 0;
 }
 
+// -1 when the read fails, a failed read must not be scaled into a plausible value
 int dXorg::getPowerCapSelected() const {
-    return getValueFromSysFsFile(driverFiles.hwmonAttributes.power1_cap).toInt() / MICROWATT_DIVIDER;
+    long long microWatts;
+    return readSysfsInt(driverFiles.hwmonAttributes.power1_cap, &microWatts) ? microWatts / MICROWATT_DIVIDER : -1;
 }
 
 int dXorg::getPowerCapAverage() const {
-    return getValueFromSysFsFile(driverFiles.hwmonAttributes.power1_average).toInt() / MICROWATT_DIVIDER;
+    long long microWatts;
+    return readSysfsInt(driverFiles.hwmonAttributes.power1_average, &microWatts) ? microWatts / MICROWATT_DIVIDER : -1;
 }
 
 const std::tuple<MapFVTables, MapOCRanges> dXorg::parseOcTable() {
     MapFVTables tables;
     MapOCRanges ocRanges;
 
+    // table is re-read after every OC change, so compile the pattern once
+    static const QRegularExpression rxSeparators(":|MHz|mV", QRegularExpression::CaseInsensitiveOption);
+
     QStringList sl = getValueFromSysFsFile(driverFiles.sysFs.pp_od_clk_voltage).remove(' ')
-            .replace(QRegularExpression(":|MHz|mV", QRegularExpression::CaseInsensitiveOption), "|").split('\n');
+            .replace(rxSeparators, "|").split('\n');
 
     // OD_VDDC_CURVE only in Vega20+
     bool vega20Mode = sl.contains(QString(OD_VDDC_CURVE).append('|'));
@@ -838,19 +1079,18 @@ const std::tuple<MapFVTables, MapOCRanges> dXorg::parseOcTable() {
 }
 
 void dXorg::readOcTableAndRanges() {
+    flushWrites();
+
     auto ocTable = parseOcTable();
 
     features.currentStatesTables = std::get<0>(ocTable);
     features.ocRages = std::get<1>(ocTable);
 }
 
+// states are merged by setNewValue(), so the whole table goes in one batch
 void dXorg::setOcTable(const QString &tableType, const FVTable &table) {
-    QString cmd;
-
     for (const auto &s : table.keys()) {
         const FreqVoltPair &fvt = table.value(s);
-        cmd.append(createDaemonSetCmd(driverFiles.sysFs.pp_od_clk_voltage, tableType + " "+ QString::number(s) + " " + QString::number(fvt.frequency) + " " + QString::number(fvt.voltage)));
+        setNewValue(driverFiles.sysFs.pp_od_clk_voltage, tableType + " "+ QString::number(s) + " " + QString::number(fvt.frequency) + " " + QString::number(fvt.voltage));
     }
-
-    radeon_profile::dcomm.sendCommand(cmd);
 }
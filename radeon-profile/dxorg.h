@@ -7,22 +7,31 @@
 
 #include "globalStuff.h"
 #include "ioctlHandler.h"
+#include "sysfsAttribute.h"
+#include "pmInfoParser.h"
+#include "daemonSharedMem.h"
 
 #include <QString>
+#include <QHash>
 #include <QList>
 #include <QTreeWidgetItem>
 #include <QSharedMemory>
 #include <QFile>
+#include <QTimer>
+#include <QVector>
+#include <QMutex>
 
 
 #define SHARED_MEM_SIZE 2048
 
+// daemon data older than this is not used, in nS (daemon timer interval can be a few seconds)
+#define DAEMON_DATA_MAX_AGE 10000000000LL
+
+// writes within this time (ms) are merged into one daemon message
+#define WRITE_COALESCE_WINDOW 25
+
 class dXorg
 {
-    struct RxPatterns {
-        QString powerLevel, sclk, mclk, vclk, dclk, vddc, vddci;
-    };
-
 public:
     struct InitializationConfig {
         bool daemonAutoRefresh, daemonData, rootMode;
@@ -34,12 +43,22 @@ public:
 
         InitializationConfig(bool isRoot, bool data, bool autoRefresh) {
             rootMode = isRoot;
-            daemonData = autoRefresh;
+            daemonAutoRefresh = autoRefresh;
             daemonData = data;
         }
     };
 
-    dXorg() : ioctlHnd(nullptr) { }
+    // counters of setNewValue(), to see how many writes the coalescing saves
+    struct WriteStatistics {
+        quint64 requested = 0,  // setNewValue() calls
+                issued = 0,  // values written to files or sent to the daemon
+                suppressed = 0,  // same value as written before, or replaced by a later one in the window
+                batches = 0;  // flushes (one daemon message each)
+    };
+
+    dXorg() : pmInfoLayout(PmInfoParser::LAYOUT_UNKNOWN), waitingForDaemonData(false), debugfsPmInfoReadable(false), ioctlHnd(nullptr) {
+        setupWriteTimer();
+    }
     dXorg(const GPUSysInfo &si, const InitializationConfig &config);
 
     ~dXorg() {
@@ -48,6 +67,7 @@ public:
 
     void cleanup() {
         delete ioctlHnd;
+        clearSysfsCache();
 
         if (sharedMem.isAttached()){
             // In case the closing signal interrupts a sharedMem lock+read+unlock phase, sharedmem is unlocked
@@ -62,12 +82,19 @@ public:
     GPUConstParams params;
     DeviceFilePaths driverFiles;
 
+    // all ioctl sensors of one refresh, read back-to-back and passed to getClocks() and getGPUUsage()
+    SensorSnapshot sampleSensors() const;
+
+    // ioctl polling between refreshes (radeon busy state), runs only while sampling does
+    void startBackgroundSampling();
+    void stopBackgroundSampling();
+
     GPUClocks getClocksFromPmFile();
-    GPUClocks getClocksFromIoctl();
-    GPUClocks getClocks();
+    GPUClocks getClocksFromIoctl(const SensorSnapshot &sensors);
+    GPUClocks getClocks(const SensorSnapshot &sensors);
 
     float getTemperature();
-    GPUUsage getGPUUsage();
+    GPUUsage getGPUUsage(const SensorSnapshot &sensors);
     GPUFanSpeed getFanSpeed();
 
     QList<QTreeWidgetItem *> getModuleInfo();
@@ -82,11 +109,30 @@ public:
 
     void figureOutGpuDataFilePaths(const QString &gpuName);
     void configure();
+
+    // with daemon data, features are figured out only after the daemon read pm_info once,
+    // until then the handler waits and finishConfiguration() has to be called
+    bool isWaitingForDaemonData() const;
+    bool hasDaemonData();
+    void finishConfiguration();
+
+    /**
+     * @brief Move pm_info reading by the daemon to or away from this card, the daemon reads one card only.
+     * When enabled, the handler waits for the daemon data again, otherwise features are figured out right away.
+     * @note Only when the card is not sampled.
+     */
+    void setDaemonData(bool enabled);
+
     void reconfigureDaemon();
     GPUClocks getFeaturesFallback();
-    void setupRegex(const QString &data);
+    void setupPmInfoLayout(const char *data, int length);
     int getCurrentPowerPlayTableId(const QString &file);
+    // write is delayed by WRITE_COALESCE_WINDOW and merged with the following ones, see flushWrites(), thread safe
     void setNewValue(const QString &filePath, const QString &newValue);
+    // only in the thread dXorg was created in (the one of writeTimer)
+    void flushWrites();
+    const WriteStatistics& getWriteStatistics() const;
+
     void readOcTableAndRanges();
     void setOcTable(const QString &tableType, const FVTable &table);
     InitializationConfig getInitConfig();
@@ -95,15 +141,41 @@ public:
 private:
     QChar gpuSysIndex;
     QSharedMemory sharedMem;
-    int sensorsGPUtempIndex;
-    short rxMatchIndex, clocksValueDivider;
-    RxPatterns rxPatterns;
+    PmInfoParser::Layout pmInfoLayout;
     InitializationConfig initConfig;
+    bool waitingForDaemonData;
+
+    // debugfs needs root, checked once so ticks without it don't retry the open
+    bool debugfsPmInfoReadable;
 
     ioctlHandler *ioctlHnd;
 
-    QString getClocksRawData();
+    // attributes read on every refresh, kept open for the whole life of dXorg
+    QHash<QString, SysfsAttribute*> sysfsCache;
+
+    struct PendingWrite {
+        QString path, value;
+    };
+
+    // guards the write queue, cache and statistics, setNewValue() is called from other threads too
+    QMutex writesMutex;
+    // in order of the first setNewValue() of the path, at most one per path except command files (pp_od_clk_voltage)
+    QVector<PendingWrite> pendingWrites;
+    QHash<QString, QString> lastWrittenValues;
+    // deduplicated paths sent in a framed command, by request id, dropped from the cache if it fails
+    QHash<quint32, QStringList> unconfirmedWrites;
+    QTimer writeTimer;
+    bool flushScheduled = false;
+    WriteStatistics writeStatistics;
+
+    bool isDeduplicated(const QString &path) const;
+    void setupWriteTimer();
+    bool writeFile(const QString &filePath, const QString &newValue);
+
+    int getClocksRawData(char *buffer, int size, DaemonSharedMem::PayloadFormat *format);
     QString findSysfsHwmonForGPU();
+    QString findSysfsHwmonTempByChipName(const QString &chipName, const QString &inputName = "temp1_input");
+    QString findSysfsHwmonTempBySensorsLabel(const QString &label);
     PowerMethod getPowerMethod();
     TemperatureSensor getTemperatureSensor();
     QString findSysFsHwmonForGpu();
@@ -113,8 +185,12 @@ private:
     void setupIoctl();
     void setupSharedMem();
     void sendSharedMemInfoToDaemon();
+    void setupSysfsCache();
+    void clearSysfsCache();
+    bool readSysfsInt(const QString &file, long long *value) const;
+    QString readSysfsString(const QString &file) const;
+    int readSysfsRaw(const QString &file, char *buffer, int size) const;
     QStringList loadPowerPlayTable(const QString &file);
-    QString createDaemonSetCmd(const QString &file, const QString &tableIndex);
         const std::tuple<QMap<QString, FVTable>, QMap<QString, OCRange>> parseOcTable();
 };
 
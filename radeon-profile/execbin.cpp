@@ -9,6 +9,8 @@
 
 ExecBin::ExecBin() : QObject(),
     tab(new QWidget()),
+    logEnabled(false),
+    logCardIndex(-1),
     p(new QProcess(this)),
     output(new QPlainTextEdit()),
     cmd(new QPlainTextEdit()),
@@ -41,6 +41,7 @@ public:
     QString name;
     QWidget *tab;
     bool logEnabled;
+    int logCardIndex;  // card logged, -1 for the selected one
 
 public slots:
     void execProcessReadOutput();
@@ -10,6 +10,11 @@
 #include <QStringList>
 #include <QFile>
 #include <QMap>
+#include <array>
+
+#ifdef RP_FORMAT_COUNTER
+#include <atomic>
+#endif
 
 #define dpm_battery "battery"
 #define dpm_performance "performance"
@@ -45,8 +50,6 @@
 
 #define MICROWATT_DIVIDER 1000000
 
-static QString MOCK_PATH("/home/marazmista/aasd/testfies/");
-
 enum ValueID {
     CLK_CORE,
     CLK_MEM,
@@ -65,7 +68,9 @@ enum ValueID {
     FAN_SPEED_RPM,
     POWER_LEVEL,
     POWER_CAP_SELECTED,
-    POWER_CAP_AVERAGE
+    POWER_CAP_AVERAGE,
+
+    VALUE_ID_COUNT  // keep last, number of ids for GPUDataContainer
 };
 
 enum ValueUnit {
@@ -105,10 +110,10 @@ enum PowerMethod {
 };
 
 enum class TemperatureSensor {
-    SYSFS_HWMON = 0, // try to read temp from /sys/class/hwmonX/device/tempX_input
+    SYSFS_HWMON = 0, // try to read temp from /sys/class/hwmon/hwmonX/[device/]tempX_input labeled VGA_TEMP
     CARD_HWMON, // try to read temp from /sys/class/drm/cardX/device/hwmon/hwmonX/temp1_input
-    PCI_SENSOR,  // PCI Card, 'radeon-pci' label on sensors output
-    MB_SENSOR,  // Card in motherboard, 'VGA' label on sensors output
+    PCI_SENSOR,  // PCI Card, hwmon chip shown as 'radeon-pci' on sensors output
+    MB_SENSOR,  // Card in motherboard, 'VGA_TEMP' label of sensors config, resolved to the hwmon input at init
     TS_UNKNOWN
 };
 
@@ -120,24 +125,34 @@ struct GPUSysInfo {
 struct RPValue {
     ValueUnit unit;
     float value;
-    QString strValue;
 
-    RPValue() {
-        value = -1;
-    }
+    RPValue() : unit(ValueUnit::NONE), value(-1) { }
 
-    RPValue(ValueUnit u, float v = -1) {
-        unit = u;
-        value = v;
-        strValue = toString();
-    }
+    RPValue(ValueUnit u, float v = -1) : unit(u), value(v) { }
 
     void setValue(float v) {
         value = v;
-        strValue = toString();
     }
 
-    QString toString() {
+    // string is made when it is read, so when nothing is displayed (window hidden) no formatting is done at all.
+    // Not cached, values are read from snapshots shared by the sampler and ui threads
+    QString strValue() const {
+        return toString();
+    }
+
+#ifdef RP_FORMAT_COUNTER
+    // test builds only, toString() calls since the start, to check nothing is formatted while the window is hidden
+    static std::atomic<quint64>& formatCount() {
+        static std::atomic<quint64> count(0);
+        return count;
+    }
+#endif
+
+    QString toString() const {
+#ifdef RP_FORMAT_COUNTER
+        ++formatCount();
+#endif
+
         if (value == -1)
             return "";
 
@@ -184,7 +199,127 @@ struct OCRange {
     }
 };
 
-typedef QMap<ValueID, RPValue> GPUDataContainer;
+// every ValueID has its own slot in a fixed array, which ids are set is kept in a bitmask,
+// so lookups on every refresh are just indexing instead of map searches
+// interface is the subset of QMap that was used when this was QMap<ValueID, RPValue>
+class GPUDataContainer {
+public:
+    // walks only ids present in container, in ValueID order
+    class IdIterator {
+    public:
+        explicit IdIterator(quint32 mask) : remaining(mask) { }
+
+        ValueID operator*() const {
+            return static_cast<ValueID>(__builtin_ctz(remaining));
+        }
+
+        IdIterator& operator++() {
+            remaining &= remaining - 1;
+            return *this;
+        }
+
+        bool operator!=(const IdIterator &other) const {
+            return remaining != other.remaining;
+        }
+
+    private:
+        quint32 remaining;
+    };
+
+    struct IdRange {
+        quint32 mask;
+
+        IdIterator begin() const {
+            return IdIterator(mask);
+        }
+
+        IdIterator end() const {
+            return IdIterator(0);
+        }
+    };
+
+    GPUDataContainer() : presentMask(0) { }
+
+    bool contains(const ValueID id) const {
+        return isValid(id) && (presentMask & bit(id));
+    }
+
+    const RPValue& value(const ValueID id) const {
+        static const RPValue empty;
+        return contains(id) ? values[id] : empty;
+    }
+
+    RPValue value(const ValueID id, const RPValue &defaultValue) const {
+        return contains(id) ? values[id] : defaultValue;
+    }
+
+    // as in QMap, missing id is inserted with default value
+    RPValue& operator[](const ValueID id) {
+        Q_ASSERT(isValid(id));
+
+        if (!contains(id)) {
+            values[id] = RPValue();
+            presentMask |= bit(id);
+        }
+
+        return values[id];
+    }
+
+    void insert(const ValueID id, const RPValue &v) {
+        Q_ASSERT(isValid(id));
+
+        values[id] = v;
+        presentMask |= bit(id);
+    }
+
+    void remove(const ValueID id) {
+        if (!contains(id))
+            return;
+
+        values[id] = RPValue();
+        presentMask &= ~bit(id);
+    }
+
+    void clear() {
+        values.fill(RPValue());
+        presentMask = 0;
+    }
+
+    int count() const {
+        return __builtin_popcount(presentMask);
+    }
+
+    bool isEmpty() const {
+        return presentMask == 0;
+    }
+
+    IdRange presentIds() const {
+        return IdRange { presentMask };
+    }
+
+    QList<ValueID> keys() const {
+        QList<ValueID> ids;
+        for (const ValueID id : presentIds())
+            ids.append(id);
+
+        return ids;
+    }
+
+private:
+    std::array<RPValue, ValueID::VALUE_ID_COUNT> values;
+    quint32 presentMask;
+
+    static bool isValid(const ValueID id) {
+        return id >= 0 && id < ValueID::VALUE_ID_COUNT;
+    }
+
+    static quint32 bit(const ValueID id) {
+        return 1u << id;
+    }
+
+    static_assert(ValueID::VALUE_ID_COUNT <= 32, "presentMask is too small for all ValueIDs");
+};
+
 typedef QMap<unsigned, FreqVoltPair> FVTable;
 typedef QMap<QString, FVTable> MapFVTables;
 typedef QMap<QString, OCRange> MapOCRanges;
@@ -377,6 +512,25 @@ struct GPUConstParams {
 
 class globalStuff {
 public:
+    // prefix for /sys, /sys/kernel/debug and /dev/dri, so device can be read from a captured tree
+    // set from RADEON_PROFILE_ROOT env variable or --root option, empty means the real system
+    static QString& systemRoot() {
+        static QString root;
+        return root;
+    }
+
+    static QString systemPath(const QString &path) {
+        return systemRoot() + path;
+    }
+
+    static void setSystemRoot(const QString &root) {
+        systemRoot() = root;
+
+        // paths are appended to it as "/sys/..."
+        while (systemRoot().endsWith('/'))
+            systemRoot().chop(1);
+    }
+
     static QStringList grabSystemInfo(const QString cmd) {
         QProcess *p = new QProcess();
         p->setProcessChannelMode(QProcess::MergedChannels);
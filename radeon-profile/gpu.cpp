@@ -1,7 +1,8 @@
 // copyright marazmista @ 29.03.2014
 
 #include "gpu.h"
-#include "radeon_profile.h"
+#include "daemonComm.h"
+#include "sysfsEnumerator.h"
 
 #include <cmath>
 #include <QFile>
@@ -41,10 +42,10 @@ static const char * pnpIdFiles [PNP_ID_FILE_COUNT] = {
 };
 
 void gpu::detectCards() {
-    QStringList out = globalStuff::grabSystemInfo("ls /sys/class/drm/").filter(QRegExp("card\\d$"));
+    QStringList out = SysfsEnumerator::drmCards();
 
     for (char i = 0; i < out.count(); i++) {
-        QFile f("/sys/class/drm/"+out[i]+"/device/uevent");
+        QFile f(globalStuff::systemPath("/sys/class/drm/")+out[i]+"/device/uevent");
 
         if (!f.open(QIODevice::ReadOnly))
             continue;
@@ -91,136 +92,345 @@ bool gpu::initialize(const dXorg::InitializationConfig &config) {
         return false;
     }
 
-    driverHandler = new dXorg(gpuList.at(0), config);
-    defineAvailableDataContainer();
+    for (int i = 0; i < gpuList.count(); ++i) {
+        // daemon serves pm_info of one card only, the others read clocks from ioctl or debugfs
+        dXorg::InitializationConfig cardConfig = config;
+        if (i > 0)
+            cardConfig.daemonData = false;
+
+        driverHandlers.append(new dXorg(gpuList.at(i), cardConfig));
+    }
+
+    currentGpuIndex = 0;
+    driverHandler = driverHandlers.at(0);
+
+    // daemon data is waited for here and on every gpu change, see handOverDaemonData()
+    connect(&DaemonComm::instance(), SIGNAL(dataReady()), this, SLOT(checkDaemonData()), Qt::UniqueConnection);
+
+    bool waitingForDaemon = false;
+    for (const dXorg *handler : driverHandlers)
+        waitingForDaemon |= handler->isWaitingForDaemonData();
+
+    if (!waitingForDaemon) {
+        finishInitialization();
+        return true;
+    }
+
+    qDebug() << "Waiting for first daemon data read...";
+    initializationPending = true;
+    daemonDataWait.start();
+    daemonDataTimer.start();
 
     return true;
 }
 
+void gpu::checkDaemonData() {
+    if (!daemonDataTimer.isActive())
+        return;
+
+    bool ready = true;
+    for (dXorg *handler : driverHandlers) {
+        if (handler->isWaitingForDaemonData() && !handler->hasDaemonData())
+            ready = false;
+    }
+
+    if (!ready) {
+        if (daemonDataWait.elapsed() < DAEMON_DATA_TIMEOUT)
+            return;
+
+        qWarning() << "No data from daemon after" << DAEMON_DATA_TIMEOUT << "ms, some features may be not detected";
+    } else
+        qDebug() << "Daemon data ready after" << daemonDataWait.elapsed() << "ms";
+
+    daemonDataTimer.stop();
+
+    if (initializationPending) {
+        finishInitialization();
+        return;
+    }
+
+    const bool sampling = sampler.isRunning();
+    stopSampling();
+    finishDaemonHandover();
+
+    if (sampling)
+        startSampling();
+}
+
+void gpu::finishInitialization() {
+    for (dXorg *handler : driverHandlers) {
+        handler->finishConfiguration();
+        cardsData.append(defineAvailableDataContainer(handler));
+    }
+
+    gpuData = cardsData.at(0);
+    cardsHistory.resize(cardsData.count());
+
+    for (TimeSeriesHistory &history : cardsHistory)
+        history.setSamplingInterval(sampler.getInterval());
+
+    loadHistoryFiles();
+    sampler.setDriverHandlers(driverHandlers, cardsData);
+
+    initializationPending = false;
+    emit initialized();
+}
+
+void gpu::loadHistoryFiles() {
+    if (historyDirectory.isEmpty() || historyFileSize <= 0)
+        return;
+
+    for (int i = 0; i < cardsHistory.count(); ++i) {
+        HistoryFile *file = new HistoryFile();
+        historyFiles.append(file);
+
+        if (!file->open(historyDirectory + "/history-" + gpuList.at(i).sysName, historyFileSize))
+            continue;
+
+        const int loaded = file->load(&cardsHistory[i]);
+        qDebug() << "Loaded" << loaded << "history records of" << gpuList.at(i).sysName;
+    }
+}
+
 bool gpu::isInitialized() {
     return gpuList.count() > 0;
 }
 
+bool gpu::isInitializationPending() const {
+    return initializationPending;
+}
+
+// all cards are sampled all the time, so only the selected one changes
 void gpu::changeGpu(int index) {
-    dXorg::InitializationConfig initConfig = driverHandler->getInitConfig();
-    delete driverHandler;
+    if (index < 0 || index >= driverHandlers.count() || index == currentGpuIndex)
+        return;
+
+    const int previousIndex = currentGpuIndex;
+    currentGpuIndex = index;
+    driverHandler = driverHandlers.at(index);
+
+    // the snapshot is left for readLatestSnapshot(), so it still goes to the history
+    applySelectedCard();
 
-    driverHandler = new dXorg(gpuList.at(index), initConfig);
-    driverHandler->configure();
-    defineAvailableDataContainer();
+    handOverDaemonData(previousIndex, index);
 }
 
-void gpu::defineAvailableDataContainer() {
-    GPUClocks tmpClk = driverHandler->getClocks();
+// the daemon reads pm_info of one card only, it follows the selected card as when only that one was monitored
+void gpu::handOverDaemonData(int from, int to) {
+    if (initializationPending || !driverHandlers.at(from)->getInitConfig().daemonData)
+        return;
+
+    // features of both cards change, the sampler must not read them meanwhile
+    const bool sampling = sampler.isRunning();
+    stopSampling();
+
+    // a handover still waiting is finished first, its card gives the daemon away again
+    for (dXorg *handler : driverHandlers)
+        handler->finishConfiguration();
+
+    driverHandlers.at(from)->setDaemonData(false);
+    driverHandlers.at(to)->setDaemonData(true);
+
+    if (!driverHandlers.at(to)->isWaitingForDaemonData()) {
+        finishDaemonHandover();
+        if (sampling)
+            startSampling();
+
+        return;
+    }
+
+    // the new card is sampled in the meantime, its clocks are missing until the daemon reads them
+    qDebug() << "Waiting for daemon data of" << gpuList.at(to).sysName;
+    daemonDataWait.start();
+    daemonDataTimer.start();
+
+    if (sampling)
+        startSampling();
+}
+
+void gpu::finishDaemonHandover() {
+    for (int i = 0; i < driverHandlers.count(); ++i) {
+        driverHandlers.at(i)->finishConfiguration();
+        cardsData[i] = defineAvailableDataContainer(driverHandlers.at(i));
+    }
+
+    sampler.setDriverHandlers(driverHandlers, cardsData);
+}
+
+const GPUDataContainer& gpu::cardData(int index) const {
+    if (index < 0 || index >= cardsData.count())
+        return gpuData;
+
+    return cardsData.at(index);
+}
+
+GPUDataContainer gpu::defineAvailableDataContainer(dXorg *handler) {
+    GPUDataContainer data;
+
+    const SensorSnapshot sensors = handler->sampleSensors();
+    GPUClocks tmpClk = handler->getClocks(sensors);
 
     if (tmpClk.coreClk != -1)
-        gpuData.insert(ValueID::CLK_CORE, RPValue(ValueUnit::MEGAHERTZ, tmpClk.coreClk));
+        data.insert(ValueID::CLK_CORE, RPValue(ValueUnit::MEGAHERTZ, tmpClk.coreClk));
 
     if (tmpClk.coreVolt != -1)
-        gpuData.insert(ValueID::VOLT_CORE, RPValue(ValueUnit::MILIVOLT, tmpClk.coreVolt));
+        data.insert(ValueID::VOLT_CORE, RPValue(ValueUnit::MILIVOLT, tmpClk.coreVolt));
 
     if (tmpClk.memClk != -1)
-        gpuData.insert(ValueID::CLK_MEM, RPValue(ValueUnit::MEGAHERTZ, tmpClk.memClk));
+        data.insert(ValueID::CLK_MEM, RPValue(ValueUnit::MEGAHERTZ, tmpClk.memClk));
 
     if (tmpClk.memVolt != -1)
-        gpuData.insert(ValueID::VOLT_MEM, RPValue(ValueUnit::MILIVOLT, tmpClk.memVolt));
+        data.insert(ValueID::VOLT_MEM, RPValue(ValueUnit::MILIVOLT, tmpClk.memVolt));
 
     if (tmpClk.uvdCClk != -1)
-        gpuData.insert(ValueID::CLK_UVD, RPValue(ValueUnit::MEGAHERTZ, tmpClk.uvdCClk));
+        data.insert(ValueID::CLK_UVD, RPValue(ValueUnit::MEGAHERTZ, tmpClk.uvdCClk));
 
     if (tmpClk.uvdDClk != -1)
-        gpuData.insert(ValueID::DCLK_UVD, RPValue(ValueUnit::MEGAHERTZ, tmpClk.uvdDClk));
+        data.insert(ValueID::DCLK_UVD, RPValue(ValueUnit::MEGAHERTZ, tmpClk.uvdDClk));
 
     if (tmpClk.powerLevel != -1)
-        gpuData.insert(ValueID::POWER_LEVEL, RPValue(ValueUnit::NONE, tmpClk.powerLevel));
+        data.insert(ValueID::POWER_LEVEL, RPValue(ValueUnit::NONE, tmpClk.powerLevel));
 
 
-    GPUFanSpeed tmpPwm = driverHandler->getFanSpeed();
+    GPUFanSpeed tmpPwm = handler->getFanSpeed();
 
     if (tmpPwm.fanSpeedPercent != -1)
-        gpuData.insert(ValueID::FAN_SPEED_PERCENT, RPValue(ValueUnit::PERCENT, tmpPwm.fanSpeedPercent));
+        data.insert(ValueID::FAN_SPEED_PERCENT, RPValue(ValueUnit::PERCENT, tmpPwm.fanSpeedPercent));
 
     if (tmpPwm.fanSpeedRpm != -1)
-        gpuData.insert(ValueID::FAN_SPEED_RPM, RPValue(ValueUnit::RPM, tmpPwm.fanSpeedRpm));
+        data.insert(ValueID::FAN_SPEED_RPM, RPValue(ValueUnit::RPM, tmpPwm.fanSpeedRpm));
 
 
-    float tmpTemp = driverHandler->getTemperature();
+    float tmpTemp = handler->getTemperature();
 
     if (tmpTemp != -1) {
-        gpuData.insert(ValueID::TEMPERATURE_CURRENT, RPValue(ValueUnit::CELSIUS, tmpTemp));
-        gpuData.insert(ValueID::TEMPERATURE_BEFORE_CURRENT, RPValue(ValueUnit::CELSIUS, tmpTemp));
-        gpuData.insert(ValueID::TEMPERATURE_MIN, RPValue(ValueUnit::CELSIUS, tmpTemp));
-        gpuData.insert(ValueID::TEMPERATURE_MAX, RPValue(ValueUnit::CELSIUS, tmpTemp));
+        data.insert(ValueID::TEMPERATURE_CURRENT, RPValue(ValueUnit::CELSIUS, tmpTemp));
+        data.insert(ValueID::TEMPERATURE_BEFORE_CURRENT, RPValue(ValueUnit::CELSIUS, tmpTemp));
+        data.insert(ValueID::TEMPERATURE_MIN, RPValue(ValueUnit::CELSIUS, tmpTemp));
+        data.insert(ValueID::TEMPERATURE_MAX, RPValue(ValueUnit::CELSIUS, tmpTemp));
     }
 
-    GPUUsage tmpUsage = driverHandler->getGPUUsage();
+    GPUUsage tmpUsage = handler->getGPUUsage(sensors);
 
     if (tmpUsage.gpuUsage != -1)
-        gpuData.insert(ValueID::GPU_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, tmpUsage.gpuUsage));
+        data.insert(ValueID::GPU_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, tmpUsage.gpuUsage));
 
     if (tmpUsage.gpuVramUsage != -1)
-        gpuData.insert(ValueID::GPU_VRAM_USAGE_MB, RPValue(ValueUnit::MEGABYTE, tmpUsage.gpuVramUsage));
+        data.insert(ValueID::GPU_VRAM_USAGE_MB, RPValue(ValueUnit::MEGABYTE, tmpUsage.gpuVramUsage));
 
     if (tmpUsage.gpuVramUsagePercent != -1)
-        gpuData.insert(ValueID::GPU_VRAM_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, tmpUsage.gpuVramUsagePercent));
+        data.insert(ValueID::GPU_VRAM_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, tmpUsage.gpuVramUsagePercent));
 
 
-    if (driverHandler->features.isPowerCapAvailable) {
-        int tmpPowerCap = driverHandler->getPowerCapSelected();
+    if (handler->features.isPowerCapAvailable) {
+        int tmpPowerCap = handler->getPowerCapSelected();
 
         if (tmpPowerCap != -1)
-            gpuData.insert(ValueID::POWER_CAP_SELECTED, RPValue(ValueUnit::WATT, tmpPowerCap));
+            data.insert(ValueID::POWER_CAP_SELECTED, RPValue(ValueUnit::WATT, tmpPowerCap));
 
-        tmpPowerCap = driverHandler->getPowerCapAverage();
+        tmpPowerCap = handler->getPowerCapAverage();
 
         if (tmpPowerCap != -1)
-            gpuData.insert(ValueID::POWER_CAP_AVERAGE, RPValue(ValueUnit::WATT, tmpPowerCap));
+            data.insert(ValueID::POWER_CAP_AVERAGE, RPValue(ValueUnit::WATT, tmpPowerCap));
     }
+
+    return data;
 }
 
-void gpu::getClocks() {
-    GPUClocks tmp = driverHandler->getClocks();
+void gpu::startSampling() {
+    if (driverHandler == nullptr || sampler.isRunning())
+        return;
 
-    if (gpuData.contains(ValueID::CLK_CORE))
-        gpuData[ValueID::CLK_CORE].setValue(tmp.coreClk);
+    for (dXorg *handler : driverHandlers)
+        handler->startBackgroundSampling();
 
-    if (gpuData.contains(ValueID::VOLT_CORE))
-         gpuData[ValueID::VOLT_CORE].setValue(tmp.coreVolt);
+    sampler.start();
+}
 
-    if (gpuData.contains(ValueID::CLK_MEM))
-         gpuData[ValueID::CLK_MEM].setValue(tmp.memClk);
+void gpu::stopSampling() {
+    sampler.stop();
 
-    if (gpuData.contains(ValueID::VOLT_MEM))
-         gpuData[ValueID::VOLT_MEM].setValue(tmp.memVolt);
+    // after the sampler, nothing reads busy state anymore
+    for (dXorg *handler : driverHandlers)
+        handler->stopBackgroundSampling();
+}
 
-    if (gpuData.contains(ValueID::CLK_UVD))
-         gpuData[ValueID::CLK_UVD].setValue(tmp.uvdCClk);
+void gpu::setSamplingInterval(int msec) {
+    sampler.setInterval(msec);
 
-    if (gpuData.contains(ValueID::DCLK_UVD))
-         gpuData[ValueID::DCLK_UVD].setValue(tmp.uvdDClk);
+    for (TimeSeriesHistory &history : cardsHistory)
+        history.setSamplingInterval(msec);
+}
 
-    if (gpuData.contains(ValueID::POWER_LEVEL))
-         gpuData[ValueID::POWER_LEVEL].setValue(tmp.powerLevel);
+void gpu::setHistoryFile(const QString &directory, int sizeMb) {
+    historyDirectory = directory;
+    historyFileSize = sizeMb;
 }
 
-void gpu::getTemperature() {
-    if (!gpuData.contains(ValueID::TEMPERATURE_CURRENT))
+int gpu::getHistoryFileSize() const {
+    return historyFileSize;
+}
+
+void gpu::setSamplingMode(SamplerThread::SamplingMode mode) {
+    sampler.setMode(mode);
+}
+
+// copy the latest snapshot for the gui
+// returns false if there is nothing new since the last call
+bool gpu::readLatestSnapshot() {
+    GPUSnapshotPtr snapshot = sampler.takeLatestSnapshot();
+
+    if (!snapshot || snapshot->sequence == snapshotSequence)
+        return false;
+
+    latestSnapshot = snapshot;
+    applySnapshot();
+
+    // only values read in the tick, a hidden window samples just the temperature
+    for (int i = 0; i < cardsHistory.count() && i < snapshot->cards.count(); ++i)
+        cardsHistory[i].append(snapshot->timestamp, snapshot->cards.at(i).data, snapshot->cards.at(i).sampledIds);
+
+    // a memcpy into the mapping each, written back to disk by the kernel
+    for (int i = 0; i < historyFiles.count() && i < snapshot->cards.count(); ++i)
+        historyFiles[i]->append(snapshot->timestamp, snapshot->cards.at(i).data, snapshot->cards.at(i).sampledIds);
+
+    return true;
+}
+
+void gpu::applySnapshot() {
+    if (!latestSnapshot || latestSnapshot->cards.count() <= currentGpuIndex)
         return;
 
-    gpuData[ValueID::TEMPERATURE_BEFORE_CURRENT].setValue(gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
-    gpuData[ValueID::TEMPERATURE_CURRENT].setValue(driverHandler->getTemperature());
+    snapshotSequence = latestSnapshot->sequence;
 
-    if (gpuData.value(ValueID::TEMPERATURE_MIN, RPValue()).value > gpuData.value(ValueID::TEMPERATURE_CURRENT).value)
-        gpuData[ValueID::TEMPERATURE_MIN].setValue(gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
+    cardsData.resize(latestSnapshot->cards.count());
+    for (int i = 0; i < latestSnapshot->cards.count(); ++i)
+        cardsData[i] = latestSnapshot->cards.at(i).data;
 
-    if (gpuData.value(ValueID::TEMPERATURE_MAX, RPValue()).value < gpuData.value(ValueID::TEMPERATURE_CURRENT).value)
-        gpuData[ValueID::TEMPERATURE_MAX].setValue(gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
+    applySelectedCard();
 }
 
-void gpu::getGpuUsage() {
+void gpu::applySelectedCard() {
+    if (currentGpuIndex < cardsData.count())
+        gpuData = cardsData.at(currentGpuIndex);
 
-    // getting gpu usage seems to be heavy and cause ui lag, so it is done in another thread
-    futureGpuUsage.setFuture(QtConcurrent::run(driverHandler,&dXorg::getGPUUsage));
+    if (!latestSnapshot || latestSnapshot->cards.count() <= currentGpuIndex)
+        return;
+
+    const GPUCardSample &selected = latestSnapshot->cards.at(currentGpuIndex);
+    currentPowerProfile = selected.powerProfile;
+    currentPowerLevel = selected.powerLevel;
+}
+
+void gpu::resetMinMax() {
+    if (!gpuData.contains(ValueID::TEMPERATURE_CURRENT))
+        return;
+
+    // show it right away, sampler applies it in next tick
+    gpuData[ValueID::TEMPERATURE_MIN].setValue(gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
+    gpuData[ValueID::TEMPERATURE_MAX].setValue(gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
+
+    sampler.requestMinMaxReset(currentGpuIndex);
 }
 
 QList<QTreeWidgetItem *> gpu::getModuleInfo() const {
@@ -249,17 +459,13 @@ QStringList gpu::getGLXInfo(QString gpuName) const {
     return data;
 }
 
-QString gpu::getCurrentPowerLevel() {
-    return driverHandler->getCurrentPowerLevel();
-}
-
-QString gpu::getCurrentPowerProfile()  {
-    return driverHandler->getCurrentPowerProfile();
+// read by the sampler, the handler is not read from the gui thread while it samples
+QString gpu::getCurrentPowerLevel() const {
+    return currentPowerLevel;
 }
 
-void gpu::getPowerLevel() {
-    currentPowerLevel = getCurrentPowerLevel();
-    currentPowerProfile = getCurrentPowerProfile();
+QString gpu::getCurrentPowerProfile() const {
+    return currentPowerProfile;
 }
 
 void gpu::setPowerProfile(PowerProfiles newPowerProfile) {
@@ -279,18 +485,6 @@ void gpu::setPwmManualControl(bool manual) {
     driverHandler->setNewValue(getDriverFiles().hwmonAttributes.pwm1_enable, QString(manual ? pwm_manual : pwm_auto));
 }
 
-void gpu::getFanSpeed() {
-    if (!gpuData.contains(ValueID::FAN_SPEED_PERCENT))
-        return;
-
-    GPUFanSpeed tmp = driverHandler->getFanSpeed();
-
-    gpuData[ValueID::FAN_SPEED_PERCENT].setValue(tmp.fanSpeedPercent);
-
-    if (gpuData.contains(ValueID::FAN_SPEED_RPM))
-        gpuData[ValueID::FAN_SPEED_RPM].setValue(tmp.fanSpeedRpm);
-}
-
 const DriverFeatures& gpu::getDriverFeatures() const {
     return driverHandler->features;
 }
@@ -304,14 +498,30 @@ const DeviceFilePaths& gpu::getDriverFiles() const {
 }
 
 void gpu::finalize() {
-    if (gpuData.contains(ValueID::FAN_SPEED_PERCENT))
-        setPwmManualControl(false);
+    sampler.stop();
+
+    // fan and overclock could have been changed on any card, not only the selected one
+    for (int i = 0; i < driverHandlers.count(); ++i) {
+        dXorg *handler = driverHandlers.at(i);
+
+        if (cardsData.value(i).contains(ValueID::FAN_SPEED_PERCENT))
+            handler->setNewValue(handler->driverFiles.hwmonAttributes.pwm1_enable, QString(pwm_auto));
+
+        if (handler->features.isPercentCoreOcAvailable) {
+            handler->setNewValue(handler->driverFiles.sysFs.pp_sclk_od, "0");
+            handler->setNewValue(handler->driverFiles.sysFs.pp_mclk_od, "0");
+        }
 
-    if (getDriverFeatures().isPercentCoreOcAvailable)
-        resetOverclock();
+        // app quits right after this, nothing can wait for the coalescing window
+        handler->flushWrites();
 
-    if (futureGpuUsage.isRunning())
-        futureGpuUsage.waitForFinished();
+        const dXorg::WriteStatistics &stats = handler->getWriteStatistics();
+        qDebug() << "Writes of card" << i << "requested:" << stats.requested << "issued:" << stats.issued
+                 << "suppressed:" << stats.suppressed << "batches:" << stats.batches;
+    }
+
+    for (HistoryFile *file : historyFiles)
+        file->close();
 }
 
 void gpu::setOverclockValue(const QString &file, const int value) {
@@ -344,20 +554,10 @@ void gpu::refreshPowerPlayTables() {
     driverHandler->refreshPowerPlayTables();
 }
 
-void gpu::getPowerCapSelected() {
-    if (getDriverFeatures().isPowerCapAvailable)
-        gpuData[ValueID::POWER_CAP_SELECTED].setValue(driverHandler->getPowerCapSelected());
-}
-
 void gpu::setManualFrequencyControlStates(const QString &file, const QString &states) {
     driverHandler->setNewValue(file, states);
 }
 
-void gpu::getPowerCapAverage() {
-    if (getDriverFeatures().isPowerCapAvailable)
-        gpuData[ValueID::POWER_CAP_AVERAGE].setValue(driverHandler->getPowerCapAverage());
-}
-
 void gpu::setPowerCap(const unsigned int value) {
     driverHandler->setNewValue(getDriverFiles().hwmonAttributes.power1_cap, QString::number(value * MICROWATT_DIVIDER));
 }
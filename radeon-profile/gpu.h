@@ -9,42 +9,77 @@
 
 #include "globalStuff.h"
 #include "dxorg.h"
+#include "samplerThread.h"
+#include "timeSeriesStore.h"
+#include "historyFile.h"
 #include <QtConcurrent/QtConcurrent>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// with daemon data, how often the shared memory is checked and how long to wait for the first pm_info read
+#define DAEMON_DATA_POLL_INTERVAL 50
+#define DAEMON_DATA_TIMEOUT 5000
 
 class gpu : public QObject
 {
 
     Q_OBJECT
 public:
-    explicit gpu(QObject *parent = 0 ) : QObject(parent), currentGpuIndex(0), driverHandler(nullptr) {
-        connect(&futureGpuUsage, SIGNAL(finished()),this,SLOT(handleGpuUsageResult()));
+    explicit gpu(QObject *parent = 0 ) : QObject(parent), currentGpuIndex(0), driverHandler(nullptr), snapshotSequence(0),
+        initializationPending(false), historyFileSize(HISTORY_FILE_DEFAULT_SIZE) {
+        connect(&sampler, SIGNAL(snapshotReady()), this, SIGNAL(dataReady()));
+
+        // old daemons don't signal the data, so the shared memory is checked periodically as well
+        daemonDataTimer.setInterval(DAEMON_DATA_POLL_INTERVAL);
+        connect(&daemonDataTimer, SIGNAL(timeout()), this, SLOT(checkDaemonData()));
     }
 
     ~gpu() {
-        if (driverHandler != nullptr)
-            delete driverHandler;
+        sampler.stop();
+        qDeleteAll(driverHandlers);
+        qDeleteAll(historyFiles);
     }
 
-    // main map that has all info available by ValueID
+    // main map that has all info available by ValueID, copy of the latest sampler snapshot for the selected card
     GPUDataContainer gpuData;
+
+    // same for every monitored card, in order of gpuList
+    QVector<GPUDataContainer> cardsData;
+
+    // history of every monitored card, one sample per snapshot read, in order of gpuList
+    QVector<TimeSeriesHistory> cardsHistory;
     QList<GPUSysInfo> gpuList;
 
-    char currentGpuIndex;
+    int currentGpuIndex;
     QString currentPowerProfile, currentPowerLevel;
 
     QList<QTreeWidgetItem *> getCardConnectors() const;
     QStringList getGLXInfo(QString gpuName) const;
     QList<QTreeWidgetItem *> getModuleInfo() const;
-    QString getCurrentPowerLevel();
-    QString getCurrentPowerProfile();
-    void getPowerLevel();
-
-    void getClocks();
-    void getTemperature();
-    void getFanSpeed();
-    void getGpuUsage();
-    void getPowerCapSelected();
-    void getPowerCapAverage();
+    QString getCurrentPowerLevel() const;
+    QString getCurrentPowerProfile() const;
+
+    /**
+     * @brief Data of a monitored card.
+     * @param index Index of the card in gpuList, -1 (or out of range) for the selected card.
+     */
+    const GPUDataContainer& cardData(int index) const;
+
+    void startSampling();
+    void stopSampling();
+    void setSamplingInterval(int msec);
+    void setSamplingMode(SamplerThread::SamplingMode mode);
+
+    /**
+     * @brief Keep history of every card in a file in directory, cardsHistory is loaded from it on initialization.
+     * Has to be set before initialize(), history is kept only in memory without it.
+     * @param directory Directory of the files, empty disables them.
+     * @param sizeMb Size of the file of one card in MiB, 0 disables them.
+     */
+    void setHistoryFile(const QString &directory, int sizeMb);
+    int getHistoryFileSize() const;
+    bool readLatestSnapshot();
+    void resetMinMax();
 
     void changeGpu(int index);
     void setPowerProfile(PowerProfiles _newPowerProfile);
@@ -60,6 +95,21 @@ public:
     void refreshPowerPlayTables();
 
     void detectCards();
+
+    /**
+     * @brief Read all values once and keep only those the card has.
+     * @param handler Initialized driver handler of the card.
+     * @return Container with available values, used as initial data for the sampler.
+     */
+    static GPUDataContainer defineAvailableDataContainer(dXorg *handler);
+
+    /**
+     * @brief Create driver handlers of all detected cards.
+     * Handlers which read pm_info through the daemon wait for its first read without blocking,
+     * so initialization may finish later, initialized() is emitted then (or right away if nothing waits).
+     * @param config Configuration of handlers.
+     * @return False if no card was found.
+     */
     bool initialize(const dXorg::InitializationConfig &config);
     void setOverclockValue(const QString &file, int value);
     void resetOverclock();
@@ -68,29 +118,45 @@ public:
     const DeviceFilePaths& getDriverFiles() const;
     void finalize();
     bool isInitialized();
+    bool isInitializationPending() const;
     int getCurrentPowerPlayTableId(const QString &file);
     void readOcTableAndRanges();
     void setOcTable(const QString &tableType, const FVTable &table);
 
-private slots:
-    void handleGpuUsageResult() {
-        GPUUsage tmp = futureGpuUsage.result();
-
-        if (gpuData.contains(ValueID::GPU_USAGE_PERCENT))
-            gpuData[ValueID::GPU_USAGE_PERCENT].setValue(tmp.gpuUsage);
+signals:
+    // new snapshot from the sampler thread (or just a tick when sampling is idle)
+    void dataReady();
 
-        if (gpuData.contains(ValueID::GPU_VRAM_USAGE_MB))
-            gpuData[ValueID::GPU_VRAM_USAGE_MB].setValue(tmp.gpuVramUsage);
+    // handlers are configured and have initial data, sampling can start
+    void initialized();
 
-        if (gpuData.contains(ValueID::GPU_VRAM_USAGE_PERCENT)) {
-            gpuData[ValueID::GPU_VRAM_USAGE_PERCENT].setValue(tmp.gpuVramUsagePercent);
-        }
-    }
+private slots:
+    void checkDaemonData();
 
 private:
+    // every card has its handler for the whole run, driverHandler points to the selected one
+    QVector<dXorg*> driverHandlers;
     dXorg *driverHandler;
-    void defineAvailableDataContainer();
-    QFutureWatcher<GPUUsage> futureGpuUsage;
+
+    SamplerThread sampler;
+    GPUSnapshotPtr latestSnapshot;
+    quint64 snapshotSequence;
+
+    bool initializationPending;
+    QTimer daemonDataTimer;
+    QElapsedTimer daemonDataWait;
+
+    // same order as cardsHistory
+    QVector<HistoryFile*> historyFiles;
+    QString historyDirectory;
+    int historyFileSize;
+
+    void finishInitialization();
+    void loadHistoryFiles();
+    void applySnapshot();
+    void applySelectedCard();
+    void handOverDaemonData(int from, int to);
+    void finishDaemonHandover();
 
 };
 
@@ -0,0 +1,163 @@
+#include "historyFile.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+#include <cstddef> // offsetof()
+#include <cstring>
+
+HistoryFile::HistoryFile() :
+    mapping(nullptr),
+    records(nullptr),
+    capacity(0),
+    next(0),
+    sequence(0) {
+}
+
+HistoryFile::~HistoryFile() {
+    close();
+}
+
+bool HistoryFile::open(const QString &path, int sizeMb) {
+    close();
+
+    capacity = qMax<qint64>(1, (static_cast<qint64>(sizeMb) * 1048576 - sizeof(HistoryFileHeader)) / sizeof(HistoryRecord));
+    const qint64 size = sizeof(HistoryFileHeader) + static_cast<qint64>(capacity) * sizeof(HistoryRecord);
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    file.setFileName(path);
+
+    if (!file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Cannot open history file" << path << file.errorString();
+        return false;
+    }
+
+    HistoryFileHeader header;
+    const bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header)
+            && header.magic == HISTORY_FILE_MAGIC && header.version == HISTORY_FILE_VERSION
+            && header.recordSize == sizeof(HistoryRecord) && header.valueCount == ValueID::VALUE_ID_COUNT
+            && header.capacity == static_cast<quint32>(capacity);
+
+    // started anew, zeros of the (sparse) file are empty slots
+    if (!valid && file.size() > 0 && !file.resize(0)) {
+        qWarning() << "Cannot clear history file" << path << file.errorString();
+        file.close();
+        return false;
+    }
+
+    // a file cut off in the middle of a record is extended with zeros, which fail the checksum
+    if (file.size() != size && !file.resize(size)) {
+        qWarning() << "Cannot resize history file" << path << file.errorString();
+        file.close();
+        return false;
+    }
+
+    mapping = file.map(0, size);
+    if (mapping == nullptr) {
+        qWarning() << "Cannot map history file" << path << file.errorString();
+        file.close();
+        return false;
+    }
+
+    records = reinterpret_cast<HistoryRecord*>(mapping + sizeof(HistoryFileHeader));
+
+    if (!valid)
+        initialize();
+
+    findNext();
+    return true;
+}
+
+void HistoryFile::close() {
+    if (mapping != nullptr)
+        file.unmap(mapping);
+
+    // no sync, dirty pages are written back by the kernel
+    file.close();
+
+    mapping = nullptr;
+    records = nullptr;
+}
+
+void HistoryFile::initialize() {
+    HistoryFileHeader header;
+    header.magic = HISTORY_FILE_MAGIC;
+    header.version = HISTORY_FILE_VERSION;
+    header.recordSize = sizeof(HistoryRecord);
+    header.valueCount = ValueID::VALUE_ID_COUNT;
+    header.capacity = capacity;
+    header.unused = 0;
+
+    memcpy(mapping, &header, sizeof(header));
+}
+
+// FNV-1a, catches records the writer didn't finish
+quint32 HistoryFile::checksumOf(const HistoryRecord &record) {
+    const uchar *data = reinterpret_cast<const uchar*>(&record);
+    quint32 hash = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(HistoryRecord, checksum); ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+bool HistoryFile::isValid(const HistoryRecord &record) const {
+    return record.timestamp != 0 && record.checksum == checksumOf(record);
+}
+
+void HistoryFile::findNext() {
+    next = 0;
+    sequence = 0;
+
+    bool found = false;
+    for (int i = 0; i < capacity; ++i) {
+        if (!isValid(records[i]) || (found && records[i].sequence <= sequence))
+            continue;
+
+        found = true;
+        sequence = records[i].sequence;
+        next = (i + 1) % capacity;
+    }
+}
+
+void HistoryFile::append(qint64 timestamp, const GPUDataContainer &data, quint32 ids) {
+    if (!isOpen())
+        return;
+
+    HistoryRecord record = {};
+    record.timestamp = timestamp;
+    record.sequence = ++sequence;
+
+    for (const ValueID id : GPUDataContainer::IdRange { data.presentIds().mask & ids }) {
+        record.values[id] = data.value(id).value;
+        record.presence |= 1u << id;
+    }
+
+    record.checksum = checksumOf(record);
+
+    memcpy(&records[next], &record, sizeof(record));
+    next = (next + 1) % capacity;
+}
+
+int HistoryFile::load(TimeSeriesHistory *history) const {
+    if (!isOpen())
+        return 0;
+
+    int loaded = 0;
+
+    // next is the oldest slot, records are read in place
+    for (int i = 0; i < capacity; ++i) {
+        const HistoryRecord &record = records[(next + i) % capacity];
+
+        if (!isValid(record))
+            continue;
+
+        history->append(record.timestamp, record.presence, record.values);
+        ++loaded;
+    }
+
+    return loaded;
+}
@@ -0,0 +1,87 @@
+#ifndef HISTORYFILE_H
+#define HISTORYFILE_H
+
+#include "globalStuff.h"
+#include "timeSeriesStore.h"
+
+#include <QFile>
+
+#define HISTORY_FILE_MAGIC 0x46485052 // "RPHF"
+#define HISTORY_FILE_VERSION 1
+
+// size of the file of one card, in MiB, the oldest records are overwritten when it is full
+#define HISTORY_FILE_DEFAULT_SIZE 32
+
+struct HistoryFileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 recordSize;
+    quint32 valueCount;  // ValueID::VALUE_ID_COUNT of the writer, ids are indexes of HistoryRecord::values
+    quint32 capacity;  // records after the header
+    quint32 unused;
+};
+
+/**
+ * @brief One sample of all values of a card.
+ * @note A record with wrong checksum (written partially, or cut off with the file) is skipped on load.
+ */
+struct HistoryRecord {
+    qint64 timestamp;  // mS since epoch, 0 is an empty slot
+    quint32 sequence;  // order of writing, the newest record has the highest
+    quint32 presence;  // bit of every ValueID in values
+    float values[ValueID::VALUE_ID_COUNT];
+    quint32 checksum;  // of everything before it
+    quint32 unused;
+};
+
+/**
+ * @brief The HistoryFile class keeps history of one card in a memory mapped file, so it survives restarts.
+ * The file is a header and a ring of fixed size records. A record is written straight into the mapping,
+ * the kernel writes dirty pages back in its own time, so appending costs a memcpy and is never synced.
+ */
+class HistoryFile
+{
+public:
+    HistoryFile();
+    ~HistoryFile();
+
+    /**
+     * @brief Open (or create) the file and map it, a file of other layout or size is started anew.
+     * A file cut off in the middle (e.g. a crash) is extended back, records which are not complete are skipped.
+     * @param path Path to the file, missing directories are created.
+     * @param sizeMb Size of the file in MiB.
+     * @return Success.
+     */
+    bool open(const QString &path, int sizeMb);
+    void close();
+
+    bool isOpen() const {
+        return records != nullptr;
+    }
+
+    /**
+     * @brief Write sample of values in data, over the oldest record if the file is full.
+     * @param ids Bit of every ValueID to take from data, as in TimeSeriesStore::append().
+     */
+    void append(qint64 timestamp, const GPUDataContainer &data, quint32 ids = ~0u);
+
+    /**
+     * @brief Append all valid records, oldest first, to history, read directly from the mapping.
+     * @return Number of records loaded.
+     */
+    int load(TimeSeriesHistory *history) const;
+
+private:
+    QFile file;
+    uchar *mapping;
+    HistoryRecord *records;
+    int capacity, next;
+    quint32 sequence;
+
+    static quint32 checksumOf(const HistoryRecord &record);
+    bool isValid(const HistoryRecord &record) const;
+    void initialize();
+    void findNext();
+};
+
+#endif // HISTORYFILE_H
@@ -0,0 +1,177 @@
+#include "ioctlBackend.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <cerrno>
+#include <cstring> // memcpy()
+#include <cstdio> // perror()
+#include <sys/ioctl.h> // ioctl()
+#include <unistd.h> // close()
+#include <fcntl.h> // open()
+
+// fd handed out by the replay backend, never used for syscalls
+#define REPLAY_FD 1000
+
+static IoctlBackend *customDefaultBackend = nullptr;
+
+IoctlBackend::IoctlBackend() :
+    calls(0),
+    failures(0),
+    totalNs(0),
+    maxNs(0) { }
+
+IoctlBackend* IoctlBackend::defaultBackend() {
+    static SystemIoctlBackend systemBackend;
+
+    return (customDefaultBackend != nullptr) ? customDefaultBackend : &systemBackend;
+}
+
+void IoctlBackend::setDefaultBackend(IoctlBackend *backend) {
+    customDefaultBackend = backend;
+}
+
+int IoctlBackend::call(int fd, const IoctlRequest &request) {
+    QElapsedTimer timer;
+    timer.start();
+
+    const int result = doCall(fd, request);
+
+    const quint64 elapsed = timer.nsecsElapsed();
+    const int savedErrno = errno;
+
+    ++calls;
+    totalNs += elapsed;
+
+    if (result != 0)
+        ++failures;
+
+    quint64 max = maxNs;
+    while (elapsed > max && !maxNs.compare_exchange_weak(max, elapsed)) { }
+
+    // callers check errno after a failure
+    errno = savedErrno;
+    return result;
+}
+
+IoctlBackend::Statistics IoctlBackend::statistics() const {
+    Statistics s;
+    s.calls = calls;
+    s.failures = failures;
+    s.totalNs = totalNs;
+    s.maxNs = maxNs;
+
+    return s;
+}
+
+QByteArray IoctlBackend::requestKey(const IoctlRequest &request) {
+    return QByteArray::number(static_cast<qulonglong>(request.code), 16) + ' '
+            + QByteArray::number(request.query, 16) + ' '
+            + QByteArray::number(request.parameter, 16);
+}
+
+
+int SystemIoctlBackend::openDevice(const char *path) {
+    return open(path, O_RDONLY);
+}
+
+void SystemIoctlBackend::closeDevice(int fd) {
+    if (close(fd))
+        perror("fd close");
+}
+
+int SystemIoctlBackend::doCall(int fd, const IoctlRequest &request) {
+    return ioctl(fd, request.code, request.arg);
+}
+
+
+RecordingIoctlBackend::RecordingIoctlBackend(const QString &file) : filePath(file) { }
+
+RecordingIoctlBackend::~RecordingIoctlBackend() {
+    save();
+}
+
+int RecordingIoctlBackend::doCall(int fd, const IoctlRequest &request) {
+    const int result = SystemIoctlBackend::doCall(fd, request);
+
+    if (result == 0 && request.result != nullptr) {
+        QMutexLocker locker(&mutex);
+        results.insert(requestKey(request), QByteArray(static_cast<const char*>(request.result), request.resultSize));
+    }
+
+    return result;
+}
+
+// one request per line: "code query parameter result", all in hex
+bool RecordingIoctlBackend::save() const {
+    QFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Can't save ioctl recording to" << filePath;
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    for (auto i = results.constBegin(); i != results.constEnd(); ++i)
+        f.write(i.key() + ' ' + i.value().toHex() + '\n');
+
+    qDebug() << "Saved" << results.count() << "ioctl results to" << filePath;
+    return true;
+}
+
+
+ReplayIoctlBackend::ReplayIoctlBackend(const QString &file) : loaded(false) {
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+        qWarning() << "Can't open ioctl recording" << file;
+        return;
+    }
+
+    while (!f.atEnd()) {
+        const QByteArray line = f.readLine().trimmed();
+        const int separator = line.lastIndexOf(' ');
+
+        if (line.isEmpty() || separator == -1)
+            continue;
+
+        results.insert(line.left(separator), QByteArray::fromHex(line.mid(separator + 1)));
+    }
+
+    loaded = true;
+    qDebug() << "Loaded" << results.count() << "ioctl results from" << file;
+}
+
+bool ReplayIoctlBackend::isLoaded() const {
+    return loaded;
+}
+
+int ReplayIoctlBackend::openDevice(const char *path) {
+    Q_UNUSED(path);
+
+    if (!loaded) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    return REPLAY_FD;
+}
+
+void ReplayIoctlBackend::closeDevice(int fd) {
+    Q_UNUSED(fd);
+}
+
+int ReplayIoctlBackend::doCall(int fd, const IoctlRequest &request) {
+    Q_UNUSED(fd);
+
+    const auto i = results.constFind(requestKey(request));
+    if (i == results.constEnd()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (request.result != nullptr)
+        memcpy(request.result, i.value().constData(), qMin(static_cast<unsigned>(i.value().size()), request.resultSize));
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+#ifndef IOCTLBACKEND_H
+#define IOCTLBACKEND_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <atomic>
+
+/**
+ * @brief One ioctl call, with what is needed to record and replay it.
+ */
+struct IoctlRequest {
+    unsigned long code;  // ioctl request code
+    void *arg;  // struct passed to ioctl()
+    unsigned query;  // driver query or command in the struct, 0 if none
+    unsigned parameter;  // sensor type or register address, 0 if none
+    void *result;  // memory filled by the driver
+    unsigned resultSize;
+
+    IoctlRequest(unsigned long code, void *arg, unsigned query, unsigned parameter, void *result, unsigned resultSize) :
+        code(code), arg(arg), query(query), parameter(parameter), result(result), resultSize(resultSize) { }
+};
+
+/**
+ * @brief The IoctlBackend class is the syscall layer under ioctlHandler (open, ioctl, close on /dev/dri).
+ * Calls are counted and timed in every backend.
+ */
+class IoctlBackend
+{
+public:
+    struct Statistics {
+        quint64 calls, failures, totalNs, maxNs;
+    };
+
+    IoctlBackend();
+    virtual ~IoctlBackend() { }
+
+    /**
+     * @brief Backend used by handlers created without an explicit one.
+     * @return The one set with setDefaultBackend(), SystemIoctlBackend if none was set.
+     */
+    static IoctlBackend* defaultBackend();
+
+    /**
+     * @brief Set the backend used by handlers created from now on.
+     * @param backend Backend, owned by the caller, nullptr restores the system one.
+     */
+    static void setDefaultBackend(IoctlBackend *backend);
+
+    /**
+     * @brief Open the device file.
+     * @return File descriptor, -1 on failure (errno is set).
+     */
+    virtual int openDevice(const char *path) = 0;
+    virtual void closeDevice(int fd) = 0;
+
+    /**
+     * @brief Execute the ioctl.
+     * @return 0 on success, -1 on failure (errno is set), as ioctl() does.
+     */
+    int call(int fd, const IoctlRequest &request);
+
+    Statistics statistics() const;
+
+protected:
+    virtual int doCall(int fd, const IoctlRequest &request) = 0;
+
+    /**
+     * @brief Key of the request in recorded files: "code query parameter", in hex.
+     */
+    static QByteArray requestKey(const IoctlRequest &request);
+
+private:
+    std::atomic<quint64> calls, failures, totalNs, maxNs;
+};
+
+
+/**
+ * @brief The SystemIoctlBackend class executes the real syscalls.
+ */
+class SystemIoctlBackend : public IoctlBackend
+{
+public:
+    int openDevice(const char *path);
+    void closeDevice(int fd);
+
+protected:
+    int doCall(int fd, const IoctlRequest &request);
+};
+
+
+/**
+ * @brief The RecordingIoctlBackend class executes the real syscalls and keeps the last result of every request,
+ * saved to a file readable by ReplayIoctlBackend.
+ */
+class RecordingIoctlBackend : public SystemIoctlBackend
+{
+public:
+    explicit RecordingIoctlBackend(const QString &file);
+
+    /**
+     * @brief Save the results on destruction as well.
+     */
+    ~RecordingIoctlBackend();
+
+    bool save() const;
+
+protected:
+    int doCall(int fd, const IoctlRequest &request);
+
+private:
+    QString filePath;
+
+    // handlers call from the sampler and busy sampler threads
+    mutable QMutex mutex;
+    QHash<QByteArray, QByteArray> results;
+};
+
+
+/**
+ * @brief The ReplayIoctlBackend class answers the requests with results from a file written by RecordingIoctlBackend,
+ * so handlers work without /dev/dri (GPU-less hosts, benchmarks).
+ * @note Requests not in the file fail with EINVAL, as unsupported queries do.
+ */
+class ReplayIoctlBackend : public IoctlBackend
+{
+public:
+    explicit ReplayIoctlBackend(const QString &file);
+
+    bool isLoaded() const;
+
+    int openDevice(const char *path);
+    void closeDevice(int fd);
+
+protected:
+    int doCall(int fd, const IoctlRequest &request);
+
+private:
+    // read only after the constructor
+    QHash<QByteArray, QByteArray> results;
+    bool loaded;
+};
+
+#endif // IOCTLBACKEND_H
@@ -1,26 +1,28 @@
 #include "ioctlHandler.h"
+#include "globalStuff.h"
 
 #include <QDebug>
-#include <sys/ioctl.h> // ioctl()
+#include <QFile>
+#include <climits> // PATH_MAX
 #include <cerrno>
 #include <cstdio> // snprintf()
-#include <unistd.h> // close(), usleep()
-#include <fcntl.h> // open()
+#include <unistd.h> // usleep()
+#include <time.h> // clock_gettime()
 
 #ifndef NO_IOCTL // Include libdrm headers only if NO_IOCTL is not defined
 #  include <libdrm/drm.h>
 #endif
 
 
-#define PATH_SIZE 20
 #define NAME_SIZE 10
 
 
 int ioctlHandler::openPath(const char *prefix, unsigned index) const {
-    char path[PATH_SIZE];
-    snprintf(path, PATH_SIZE, "%s%u", prefix, index);
+    const QByteArray root = QFile::encodeName(globalStuff::systemRoot());
+    char path[PATH_MAX];
+    snprintf(path, PATH_MAX, "%s%s%u", root.constData(), prefix, index);
 
-    int res = open(path, O_RDONLY);
+    int res = backend->openDevice(path);
     if(res < 0) // Open failed
         perror(path);
     else
@@ -29,6 +31,12 @@ int ioctlHandler::openPath(const char *prefix, unsigned index) const {
     return res;
 }
 
+qint64 ioctlHandler::monotonicTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
 /**
  * Open file descriptor to card device.<br>
  * The kernel generates for the card with index N the files /dev/dri/card<N> and /dev/dri/renderD<128+N>.<br>
@@ -39,7 +47,7 @@ int ioctlHandler::openPath(const char *prefix, unsigned index) const {
  * @see https://en.wikipedia.org/wiki/Direct_Rendering_Manager#Render_nodes
  * @see https://www.x.org/wiki/Events/XDC2013/XDC2013DavidHerrmannDRMSecurity/slides.pdf#page=14
  */
-ioctlHandler::ioctlHandler(unsigned card){
+ioctlHandler::ioctlHandler(unsigned card, IoctlBackend *ioctlBackend) : backend(ioctlBackend) {
 #ifdef NO_IOCTL
     qWarning() << "radeon profile was compiled with NO_IOCTL, ioctls won't work";
     fd = -1;
@@ -78,7 +86,7 @@ QString ioctlHandler::getDriverName() const {
     drm_version_t v = {};
     v.name = driver;
     v.name_len = NAME_SIZE;
-    if(ioctl(fd, DRM_IOCTL_VERSION, &v)){
+    if(backend->call(fd, IoctlRequest(DRM_IOCTL_VERSION, &v, 0, 0, driver, NAME_SIZE))){
         perror("DRM_IOCTL_VERSION");
         return "";
     }
@@ -90,8 +98,8 @@ QString ioctlHandler::getDriverName() const {
 
 ioctlHandler::~ioctlHandler(){
     qDebug() << "Closing ioctl fd, number:" << fd;
-    if((fd >= 0) && close(fd))
-        perror("fd close");
+    if(fd >= 0)
+        backend->closeDevice(fd);
 }
 
 
@@ -114,6 +122,19 @@ bool ioctlHandler::getGpuUsage(float *data, int time, int frequency) const {
 }
 
 
+bool ioctlHandler::sampleAll(SensorSnapshot *data) const {
+    data->timestamp = monotonicTime();
+
+    bool success = getCoreClock(&data->coreClock);
+    success |= getMemoryClock(&data->memoryClock);
+    success |= getTemperature(&data->temperature);
+    success |= getGpuUsage(&data->gpuUsage);
+    success |= getVramUsage(&data->vramUsage);
+
+    return success;
+}
+
+
 bool ioctlHandler::getVramUsagePercentage(long *data) const {
     float total = 0;
     long usage = 0;
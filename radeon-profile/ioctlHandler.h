@@ -2,9 +2,28 @@
 #define RADEON_IOCTL_H
 
 
+#include "busySampler.h"
+#include "ioctlBackend.h"
+
 #include <QString>
 
 
+/**
+ * @brief Values of all ioctl sensors, read back-to-back in one ioctlHandler::sampleAll() call.
+ * @note Values not available for the driver or the asic are left as -1.
+ */
+struct SensorSnapshot {
+    qint64 timestamp = -1; // CLOCK_MONOTONIC when sampling started, in nS
+    int coreClock = -1, memoryClock = -1; // MHz
+    int stableCoreClock = -1, stableMemoryClock = -1; // MHz, clocks of the stable pstate used for profiling
+    int temperature = -1; // m°C
+    int vddgfx = -1, vddnb = -1; // mV
+    int averagePower = -1; // W
+    float gpuUsage = -1; // %
+    long vramUsage = -1; // bytes
+};
+
+
 /**
  * @brief The ioctlHandler class is an interface to the kernel IOCTL system that allows to retrieve informations from the driver.
  */
@@ -16,6 +35,11 @@ protected:
      */
     int fd;
 
+    /**
+     * @brief Syscall layer used for fd and ioctls, not owned.
+     */
+    IoctlBackend *backend;
+
     /**
      * @brief Execute an ioctl call to the driver.
      * @param data Points to the memory area to store input/output data.
@@ -47,14 +71,20 @@ protected:
      */
     int openPath(const char *prefix, unsigned index) const;
 
+    /**
+     * @brief Current CLOCK_MONOTONIC time, in nS.
+     */
+    static qint64 monotonicTime();
+
 
     /**
      * @brief Open the communication with the device and initialize the ioctl handler.
      * @note You can check if it worked out with isValid().
      * @param card Index of the card to be opened (for example 'card0' --> 0).
+     * @param ioctlBackend Syscall layer, owned by the caller.
      * @note You can find the list of available cards by running 'ls /dev/dri/ | grep card'.
      */
-    ioctlHandler(unsigned card);
+    ioctlHandler(unsigned card, IoctlBackend *ioctlBackend);
 
 public:
     /**
@@ -146,6 +176,24 @@ public:
      */
     virtual bool getVramSize(float *data) const = 0;
 
+    /**
+     * @brief Read all sensors of the driver back-to-back.
+     * Default implementation calls the single getters, drivers with more sensors override it.
+     * @param data Filled with the values read, the ones that failed are left as -1.
+     * @return Success, true if at least one value was read.
+     */
+    virtual bool sampleAll(SensorSnapshot *data) const;
+
+    /**
+     * @brief Start polling the driver needs between reads (radeon busy state), nothing by default.
+     */
+    virtual void startBackgroundSampling() { }
+
+    /**
+     * @brief Stop the polling started by startBackgroundSampling().
+     */
+    virtual void stopBackgroundSampling() { }
+
     /**
      * @brief Get the name of driver
      * @return Driver name on success, empty on failure
@@ -166,14 +214,22 @@ protected:
     bool readRegistry(unsigned *data) const;
     bool isCardActive(bool *data) const;
 
+private:
+    /**
+     * @brief Polls isCardActive() in background while sampling runs, used by getGpuUsage().
+     */
+    BusySampler busySampler;
+
 public:
     /**
      * @brief Open the communication with the device and initialize the ioctl handler.
      * @note You can check if it worked out with isValid().
      * @param cardIndex Index of the card to be opened (for example 'card0' --> 0).
+     * @param ioctlBackend Syscall layer, owned by the caller (replay backend for testing and benchmarks).
      * @note You can find the list of available cards by running 'ls /dev/dri/ | grep card'.
      */
-    radeonIoctlHandler(unsigned cardIndex);
+    radeonIoctlHandler(unsigned cardIndex, IoctlBackend *ioctlBackend = IoctlBackend::defaultBackend());
+    ~radeonIoctlHandler();
     bool getCoreClock(int *data) const;
     bool getMaxCoreClock(int *data) const;
     bool getMaxMemoryClock(int *data) const;
@@ -182,7 +238,15 @@ public:
     bool getTemperature(int *data) const;
     bool getVramSize(float *data) const;
     bool getVramUsage(long *data) const;
+
+    /**
+     * @brief Get how busy the GPU was in the last 500 mS, from the background busy sampler.
+     * @note Doesn't block, fails until the first sample is taken and while sampling is stopped.
+     */
     bool getGpuUsage(float *data) const;
+
+    void startBackgroundSampling();
+    void stopBackgroundSampling();
 };
 
 
@@ -199,16 +263,24 @@ protected:
     bool isCardActive(bool *data) const;
 
 private:
+    /**
+     * @brief Sensors which failed once in sampleAll(), they are not queried again.
+     * @note sampleAll() is called only from the sampling thread.
+     */
+    mutable unsigned unsupportedSensors;
+
     bool getSensorValue(void* data, unsigned dataSize, unsigned sensor) const;
+    bool sampleSensor(int *data, unsigned sensor, unsigned sensorBit) const;
 
 public:
     /**
      * @brief Open the communication with the device and initialize the ioctl handler.
      * @note You can check if it worked out with isValid().
      * @param cardIndex Index of the card to be opened (for example 'card0' --> 0).
+     * @param ioctlBackend Syscall layer, owned by the caller (replay backend for testing and benchmarks).
      * @note You can find the list of available cards by running 'ls /dev/dri/ | grep card'.
      */
-    amdgpuIoctlHandler(unsigned cardIndex);
+    amdgpuIoctlHandler(unsigned cardIndex, IoctlBackend *ioctlBackend = IoctlBackend::defaultBackend());
     bool getCoreClock(int *data) const;
     bool getMaxCoreClock(int *data) const;
     bool getMaxMemoryClock(int *data) const;
@@ -219,6 +291,11 @@ public:
     bool getVramSize(float *data) const;
     bool getVramUsage(long *data) const;
     bool getGpuUsage(float *data) const;
+
+    /**
+     * @brief Read clocks, temperature, load, voltages, average power and VRAM usage back-to-back.
+     */
+    bool sampleAll(SensorSnapshot *data) const;
 };
 
 #endif
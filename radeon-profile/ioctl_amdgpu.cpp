@@ -1,8 +1,8 @@
 #include "ioctlHandler.h"
 
 #include <QDebug>
-#include <sys/ioctl.h> // ioctl()
 #include <cstdio> // perror()
+#include <cerrno>
 
 #ifndef NO_IOCTL // Include libdrm headers only if NO_IOCTL is not defined
 #  ifndef NO_AMDGPU_IOCTL // Include libdrm amdgpu headers only if NO_AMDGPU_IOCTL is not declared
@@ -11,7 +11,21 @@
 #endif
 
 
-amdgpuIoctlHandler::amdgpuIoctlHandler(unsigned cardIndex) : ioctlHandler(cardIndex) { }
+// bits of amdgpuIoctlHandler::unsupportedSensors
+enum SensorBit {
+    SENSOR_SCLK = 1 << 0,
+    SENSOR_MCLK = 1 << 1,
+    SENSOR_TEMP = 1 << 2,
+    SENSOR_LOAD = 1 << 3,
+    SENSOR_VDDGFX = 1 << 4,
+    SENSOR_VDDNB = 1 << 5,
+    SENSOR_AVG_POWER = 1 << 6,
+    SENSOR_STABLE_SCLK = 1 << 7,
+    SENSOR_STABLE_MCLK = 1 << 8
+};
+
+amdgpuIoctlHandler::amdgpuIoctlHandler(unsigned cardIndex, IoctlBackend *ioctlBackend) : ioctlHandler(cardIndex, ioctlBackend),
+    unsupportedSensors(0) { }
 
 bool amdgpuIoctlHandler::getSensorValue(void *data, unsigned dataSize, unsigned sensor) const {
 #if defined(DRM_IOCTL_AMDGPU_INFO) && defined(AMDGPU_INFO_SENSOR)
@@ -20,7 +34,7 @@ bool amdgpuIoctlHandler::getSensorValue(void *data, unsigned dataSize, unsigned
     buffer.return_pointer = reinterpret_cast<uint64_t>(data);
     buffer.return_size = dataSize;
     buffer.sensor_info.type = sensor;
-    bool success = !ioctl(fd, DRM_IOCTL_AMDGPU_INFO, &buffer);
+    bool success = !backend->call(fd, IoctlRequest(DRM_IOCTL_AMDGPU_INFO, &buffer, AMDGPU_INFO_SENSOR, sensor, data, dataSize));
     if (Q_UNLIKELY(!success))
         perror("DRM_IOCTL_AMDGPU_INFO");
     return success;
@@ -43,7 +57,15 @@ bool amdgpuIoctlHandler::getValue(void *data, unsigned dataSize, unsigned comman
     buffer.query = command;
     buffer.return_pointer = reinterpret_cast<uint64_t>(data);
     buffer.return_size = dataSize;
-    bool success = !ioctl(fd, DRM_IOCTL_AMDGPU_INFO, &buffer);
+
+    // register reads pass the address in data, it is part of the request
+#ifdef AMDGPU_INFO_READ_MMR_REG
+    const unsigned parameter = (command == AMDGPU_INFO_READ_MMR_REG) ? *static_cast<unsigned*>(data) : 0;
+#else
+    const unsigned parameter = 0;
+#endif
+
+    bool success = !backend->call(fd, IoctlRequest(DRM_IOCTL_AMDGPU_INFO, &buffer, command, parameter, data, dataSize));
     if(Q_UNLIKELY(!success))
         perror("DRM_IOCTL_AMDGPU_INFO");
     return success;
@@ -57,8 +79,12 @@ bool amdgpuIoctlHandler::getValue(void *data, unsigned dataSize, unsigned comman
 
 bool amdgpuIoctlHandler::getGpuUsage(float *data) const {
 #ifdef AMDGPU_INFO_SENSOR_GPU_LOAD
-    int *tmp = reinterpret_cast<int*>(data);
-    return getSensorValue(&tmp, sizeof(tmp), AMDGPU_INFO_SENSOR_GPU_LOAD);
+    // the sensor is an integer percentage
+    int tmp;
+    bool success = getSensorValue(&tmp, sizeof(tmp), AMDGPU_INFO_SENSOR_GPU_LOAD);
+    if (success)
+        *data = tmp;
+    return success;
 #else
     Q_UNUSED(data);
     return false;
@@ -67,7 +93,7 @@ bool amdgpuIoctlHandler::getGpuUsage(float *data) const {
 
 bool amdgpuIoctlHandler::getTemperature(int *data) const {
 #ifdef AMDGPU_INFO_SENSOR_GPU_TEMP
-    return getSensorValue(data, sizeof(data), AMDGPU_INFO_SENSOR_GPU_TEMP);
+    return getSensorValue(data, sizeof(*data), AMDGPU_INFO_SENSOR_GPU_TEMP);
 #else
     Q_UNUSED(data);
     return false;
@@ -76,7 +102,7 @@ bool amdgpuIoctlHandler::getTemperature(int *data) const {
 
 bool amdgpuIoctlHandler::getCoreClock(int *data) const {
 #ifdef AMDGPU_INFO_SENSOR_GFX_SCLK
-    return getSensorValue(data, sizeof(data), AMDGPU_INFO_SENSOR_GFX_SCLK);
+    return getSensorValue(data, sizeof(*data), AMDGPU_INFO_SENSOR_GFX_SCLK);
 #else
     Q_UNUSED(data);
     return false;
@@ -114,7 +140,7 @@ bool amdgpuIoctlHandler::getMaxClocks(int *core, int *memory) const {
 
 bool amdgpuIoctlHandler::getMemoryClock(int *data) const {
 #ifdef  AMDGPU_INFO_SENSOR_GFX_MCLK
-    return getSensorValue(data, sizeof(data), AMDGPU_INFO_SENSOR_GFX_MCLK);
+    return getSensorValue(data, sizeof(*data), AMDGPU_INFO_SENSOR_GFX_MCLK);
 #else
     Q_UNUSED(data);
     return false;
@@ -185,3 +211,56 @@ bool amdgpuIoctlHandler::isCardActive(bool *data) const {
         *data = reg & (1 << 31);
     return success;
 }
+
+
+/**
+ * A sensor not supported by the asic or the kernel is skipped in the next calls,
+ * so it doesn't cost an ioctl and an error message on every refresh.
+ */
+bool amdgpuIoctlHandler::sampleSensor(int *data, unsigned sensor, unsigned sensorBit) const {
+    if (unsupportedSensors & sensorBit)
+        return false;
+
+    if (getSensorValue(data, sizeof(*data), sensor))
+        return true;
+
+    *data = -1;
+
+    if (errno == EINVAL || errno == EOPNOTSUPP)
+        unsupportedSensors |= sensorBit;
+
+    return false;
+}
+
+/**
+ * @see https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/tree/include/uapi/drm/amdgpu_drm.h#n875
+ */
+bool amdgpuIoctlHandler::sampleAll(SensorSnapshot *data) const {
+    data->timestamp = monotonicTime();
+    bool success = false;
+
+#ifdef AMDGPU_INFO_SENSOR
+    int load = -1;
+    success |= sampleSensor(&data->coreClock, AMDGPU_INFO_SENSOR_GFX_SCLK, SENSOR_SCLK);
+    success |= sampleSensor(&data->memoryClock, AMDGPU_INFO_SENSOR_GFX_MCLK, SENSOR_MCLK);
+    success |= sampleSensor(&data->temperature, AMDGPU_INFO_SENSOR_GPU_TEMP, SENSOR_TEMP);
+
+    if (sampleSensor(&load, AMDGPU_INFO_SENSOR_GPU_LOAD, SENSOR_LOAD)) {
+        data->gpuUsage = load;
+        success = true;
+    }
+
+    success |= sampleSensor(&data->averagePower, AMDGPU_INFO_SENSOR_GPU_AVG_POWER, SENSOR_AVG_POWER);
+    success |= sampleSensor(&data->vddnb, AMDGPU_INFO_SENSOR_VDDNB, SENSOR_VDDNB);
+    success |= sampleSensor(&data->vddgfx, AMDGPU_INFO_SENSOR_VDDGFX, SENSOR_VDDGFX);
+
+#  ifdef AMDGPU_INFO_SENSOR_STABLE_PSTATE_GFX_SCLK // Linux >= 4.15
+    success |= sampleSensor(&data->stableCoreClock, AMDGPU_INFO_SENSOR_STABLE_PSTATE_GFX_SCLK, SENSOR_STABLE_SCLK);
+    success |= sampleSensor(&data->stableMemoryClock, AMDGPU_INFO_SENSOR_STABLE_PSTATE_GFX_MCLK, SENSOR_STABLE_MCLK);
+#  endif
+#endif
+
+    success |= getVramUsage(&data->vramUsage);
+
+    return success;
+}
@@ -1,7 +1,6 @@
 #include "ioctlHandler.h"
 
 #include <QDebug>
-#include <sys/ioctl.h> // ioctl()
 #include <cstdio> // perror()
 
 #ifndef NO_IOCTL // Include libdrm headers only if NO_IOCTL is not defined
@@ -9,7 +8,26 @@
 #endif
 
 
-radeonIoctlHandler::radeonIoctlHandler(unsigned cardIndex) : ioctlHandler(cardIndex){}
+// same window and frequency the blocking sampling used
+#define BUSY_SAMPLING_FREQUENCY 150
+#define BUSY_SAMPLING_WINDOW 500
+
+radeonIoctlHandler::radeonIoctlHandler(unsigned cardIndex, IoctlBackend *ioctlBackend) : ioctlHandler(cardIndex, ioctlBackend),
+    busySampler([this](bool *active) { return isCardActive(active); }, BUSY_SAMPLING_FREQUENCY, BUSY_SAMPLING_WINDOW) { }
+
+radeonIoctlHandler::~radeonIoctlHandler() {
+    // before the base class closes fd
+    busySampler.stop();
+}
+
+void radeonIoctlHandler::startBackgroundSampling() {
+    if (isValid() && !busySampler.isRunning())
+        busySampler.start();
+}
+
+void radeonIoctlHandler::stopBackgroundSampling() {
+    busySampler.stop();
+}
 
 /**
  * @see https://cgit.freedesktop.org/mesa/drm/tree/include/drm/radeon_drm.h#n993
@@ -20,7 +38,15 @@ bool radeonIoctlHandler::getValue(void *data, unsigned dataSize, unsigned comman
     struct drm_radeon_info buffer = {};
     buffer.request = command;
     buffer.value = reinterpret_cast<uint64_t>(data);
-    const bool success = !ioctl(fd, DRM_IOCTL_RADEON_INFO, &buffer);
+
+    // register reads pass the address in data, it is part of the request
+#ifdef RADEON_INFO_READ_REG
+    const unsigned parameter = (command == RADEON_INFO_READ_REG) ? *static_cast<unsigned*>(data) : 0;
+#else
+    const unsigned parameter = 0;
+#endif
+
+    const bool success = !backend->call(fd, IoctlRequest(DRM_IOCTL_RADEON_INFO, &buffer, command, parameter, data, dataSize));
     if(Q_UNLIKELY(!success))
         perror("DRM_IOCTL_RADEON_INFO");
     return success;
@@ -95,13 +121,13 @@ bool radeonIoctlHandler::getVramUsage(long *data) const {
 }
 
 bool radeonIoctlHandler::getGpuUsage(float *data) const {
-    return ioctlHandler::getGpuUsage(data, 500000, 150);
+    return busySampler.getUsage(data);
 }
 
 bool radeonIoctlHandler::getVramSize(float *data) const {
 #ifdef DRM_IOCTL_RADEON_GEM_INFO
     struct drm_radeon_gem_info buffer = {};
-    const bool success = !ioctl(fd, DRM_IOCTL_RADEON_GEM_INFO, &buffer);
+    const bool success = !backend->call(fd, IoctlRequest(DRM_IOCTL_RADEON_GEM_INFO, &buffer, 0, 0, &buffer, sizeof(buffer)));
     if(Q_LIKELY(success))
         *data = buffer.vram_size;
     else
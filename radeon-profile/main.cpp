@@ -1,6 +1,10 @@
 #include "radeon_profile.h"
+#include "ioctlBackend.h"
 #include <QApplication>
 #include <QTranslator>
+#include <QCommandLineParser>
+#include <QProcessEnvironment>
+#include <memory>
 
 int main(int argc, char *argv[])
 {
@@ -20,6 +24,31 @@ int main(int argc, char *argv[])
             qWarning() << "Translation not found.";
     }
 
+    // read device files from another root (captured sysfs tree) instead of the real system
+    QCommandLineParser parser;
+    QCommandLineOption rootOption("root", "Directory used as root for /sys, /sys/kernel/debug and /dev/dri.", "directory"),
+            replayOption("ioctl-replay", "Answer ioctls with results recorded in file, no /dev/dri needed.", "file"),
+            recordOption("ioctl-record", "Save results of real ioctls to file on exit.", "file");
+    parser.addOption(rootOption);
+    parser.addOption(replayOption);
+    parser.addOption(recordOption);
+    parser.parse(a.arguments());
+
+    // declared before radeon_profile, so it outlives the ioctl handlers
+    std::unique_ptr<IoctlBackend> ioctlBackend;
+    if (parser.isSet(replayOption))
+        ioctlBackend.reset(new ReplayIoctlBackend(parser.value(replayOption)));
+    else if (parser.isSet(recordOption))
+        ioctlBackend.reset(new RecordingIoctlBackend(parser.value(recordOption)));
+
+    IoctlBackend::setDefaultBackend(ioctlBackend.get());
+
+    globalStuff::setSystemRoot(parser.isSet(rootOption) ? parser.value(rootOption)
+                                                       : QProcessEnvironment::systemEnvironment().value("RADEON_PROFILE_ROOT"));
+
+    if (!globalStuff::systemRoot().isEmpty())
+        qDebug() << "Using system root: " << globalStuff::systemRoot();
+
     qDebug() << "Creating radeon_profile";
     radeon_profile w;
 
@@ -0,0 +1,263 @@
+#include "pmInfoParser.h"
+
+#include <cstring>
+
+// only the first occurrence of every value counts, as with the regex scans used before
+enum FoundValue {
+    FOUND_POWER_LEVEL = 1 << 0,
+    FOUND_SCLK = 1 << 1,
+    FOUND_MCLK = 1 << 2,
+    FOUND_VCLK = 1 << 3,
+    FOUND_DCLK = 1 << 4,
+    FOUND_VDDC = 1 << 5,
+    FOUND_VDDCI = 1 << 6
+};
+
+static inline bool isDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool isWordChar(const char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// check if literal is at data[pos]
+static bool matchesAt(const char *data, int length, int pos, const char *literal) {
+    for (; *literal != '\0'; ++literal, ++pos) {
+        if (pos >= length || data[pos] != *literal)
+            return false;
+    }
+
+    return true;
+}
+
+// check if literal ends right before data[pos]
+static bool endsAt(const char *data, int pos, const char *literal) {
+    int len = 0;
+    while (literal[len] != '\0')
+        ++len;
+
+    if (pos < len)
+        return false;
+
+    return matchesAt(data, pos, pos - len, literal);
+}
+
+static int readNumber(const char *data, int length, int pos) {
+    int value = 0;
+    for (; pos < length && isDigit(data[pos]); ++pos)
+        value = value * 10 + (data[pos] - '0');
+
+    return value;
+}
+
+static inline bool takeFirst(unsigned *found, const FoundValue v) {
+    if (*found & v)
+        return false;
+
+    *found |= v;
+    return true;
+}
+
+// radeon values are in 10 kHz
+GPUClocks PmInfoParser::parseRadeonDpm(const char *data, int length) {
+    GPUClocks clocks;
+    unsigned found = 0;
+
+    for (int i = 0; i < length; ++i) {
+        // "power level N"
+        if (data[i] == 'p') {
+            if (matchesAt(data, length, i, "power") && i + 7 < length && isSpace(data[i + 5])
+                    && matchesAt(data, length, i + 6, "level") && i + 12 < length
+                    && isSpace(data[i + 11]) && isDigit(data[i + 12])
+                    && takeFirst(&found, FOUND_POWER_LEVEL))
+                clocks.powerLevel = readNumber(data, length, i + 12);
+
+            continue;
+        }
+
+        // "key: N"
+        if (data[i] != ':' || i + 2 >= length || !isSpace(data[i + 1]) || !isDigit(data[i + 2]))
+            continue;
+
+        const int value = readNumber(data, length, i + 2);
+
+        if (endsAt(data, i, "sclk")) {
+            if (takeFirst(&found, FOUND_SCLK))
+                clocks.coreClk = value / 100;
+        } else if (endsAt(data, i, "mclk")) {
+            if (takeFirst(&found, FOUND_MCLK))
+                clocks.memClk = value / 100;
+        } else if (endsAt(data, i, "vclk")) {
+            if (takeFirst(&found, FOUND_VCLK))
+                clocks.uvdCClk = (value / 100 == 0) ? -1 : value / 100;
+        } else if (endsAt(data, i, "dclk")) {
+            if (takeFirst(&found, FOUND_DCLK))
+                clocks.uvdDClk = (value / 100 == 0) ? -1 : value / 100;
+        } else if (endsAt(data, i, "vddci")) {
+            if (takeFirst(&found, FOUND_VDDCI))
+                clocks.memVolt = value;
+        } else if (endsAt(data, i, "vddc")) {
+            if (takeFirst(&found, FOUND_VDDC))
+                clocks.coreVolt = value;
+        }
+    }
+
+    return clocks;
+}
+
+// "[  sclk  ]: 300 MHz", values in MHz
+GPUClocks PmInfoParser::parseAmdgpuBrackets(const char *data, int length) {
+    GPUClocks clocks;
+    unsigned found = 0;
+
+    for (int i = 0; i < length; ++i) {
+        if (data[i] != '[')
+            continue;
+
+        int pos = i + 1;
+        if (pos >= length || !isSpace(data[pos]))
+            continue;
+
+        while (pos < length && isSpace(data[pos]))
+            ++pos;
+
+        const bool sclk = matchesAt(data, length, pos, "sclk"),
+                mclk = !sclk && matchesAt(data, length, pos, "mclk");
+
+        if (!sclk && !mclk)
+            continue;
+
+        pos += 4;
+        if (pos >= length || !isSpace(data[pos]))
+            continue;
+
+        while (pos < length && isSpace(data[pos]))
+            ++pos;
+
+        if (!matchesAt(data, length, pos, "]:") || pos + 3 >= length || !isSpace(data[pos + 2]) || !isDigit(data[pos + 3]))
+            continue;
+
+        const int value = readNumber(data, length, pos + 3);
+
+        if (sclk && takeFirst(&found, FOUND_SCLK))
+            clocks.coreClk = value;
+        else if (mclk && takeFirst(&found, FOUND_MCLK))
+            clocks.memClk = value;
+
+        i = pos + 3;
+    }
+
+    return clocks;
+}
+
+// "300 MHz (SCLK)", values in MHz
+GPUClocks PmInfoParser::parseAmdgpuSuffix(const char *data, int length) {
+    GPUClocks clocks;
+    unsigned found = 0;
+
+    for (int i = 0; i < length; ++i) {
+        if (data[i] != '(')
+            continue;
+
+        const bool sclk = matchesAt(data, length, i + 1, "SCLK)"),
+                mclk = !sclk && matchesAt(data, length, i + 1, "MCLK)");
+
+        if (!sclk && !mclk)
+            continue;
+
+        // walk back over "N unit "
+        int pos = i - 1;
+        if (pos < 0 || !isSpace(data[pos]))
+            continue;
+
+        int unitEnd = --pos;
+        while (pos >= 0 && isWordChar(data[pos]))
+            --pos;
+
+        if (pos == unitEnd || pos < 0 || !isSpace(data[pos]))
+            continue;
+
+        int numberEnd = --pos;
+        while (pos >= 0 && isDigit(data[pos]))
+            --pos;
+
+        if (pos == numberEnd)
+            continue;
+
+        const int value = readNumber(data, length, pos + 1);
+
+        if (sclk && takeFirst(&found, FOUND_SCLK))
+            clocks.coreClk = value;
+        else if (mclk && takeFirst(&found, FOUND_MCLK))
+            clocks.memClk = value;
+    }
+
+    return clocks;
+}
+
+GPUClocks PmInfoParser::parse(Layout layout, const char *data, int length) {
+    switch (layout) {
+        case Layout::RADEON_DPM:
+            return parseRadeonDpm(data, length);
+        case Layout::AMDGPU_BRACKETS:
+            return parseAmdgpuBrackets(data, length);
+        case Layout::AMDGPU_SUFFIX:
+            return parseAmdgpuSuffix(data, length);
+        case Layout::LAYOUT_UNKNOWN:
+            break;
+    }
+
+    return GPUClocks();
+}
+
+GPUClocks PmInfoParser::parseRecord(const char *data, int length) {
+    GPUClocks clocks;
+
+    if (length < static_cast<int>(sizeof(DaemonClocksRecord)))
+        return clocks;
+
+    DaemonClocksRecord record;
+    memcpy(&record, data, sizeof(record));
+
+    clocks.coreClk = record.sclk;
+    clocks.memClk = record.mclk;
+    clocks.uvdCClk = record.vclk;
+    clocks.uvdDClk = record.dclk;
+    clocks.coreVolt = record.vddc;
+    clocks.memVolt = record.vddci;
+    clocks.powerLevel = record.powerLevel;
+
+    return clocks;
+}
+
+PmInfoParser::Layout PmInfoParser::detectLayout(DriverModule module, const char *data, int length) {
+    switch (module) {
+        case DriverModule::RADEON:
+            if (parseRadeonDpm(data, length).coreClk != -1)
+                return Layout::RADEON_DPM;
+
+            break;
+
+        case DriverModule::AMDGPU:
+            if (parseAmdgpuBrackets(data, length).coreClk != -1)
+                return Layout::AMDGPU_BRACKETS;
+
+            if (parseAmdgpuSuffix(data, length).coreClk != -1)
+                return Layout::AMDGPU_SUFFIX;
+
+            if (parseRadeonDpm(data, length).coreClk != -1)
+                return Layout::RADEON_DPM;
+
+            break;
+
+        case DriverModule::MODULE_UNKNOWN:
+            break;
+    }
+
+    return Layout::LAYOUT_UNKNOWN;
+}
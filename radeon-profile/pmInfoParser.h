@@ -0,0 +1,46 @@
+#ifndef PMINFOPARSER_H
+#define PMINFOPARSER_H
+
+#include "globalStuff.h"
+#include "daemonSharedMem.h"
+
+/**
+ * @brief The PmInfoParser class extracts clocks and voltages from the content of debugfs *_pm_info.
+ * The buffer is walked once and values are parsed in place, nothing is allocated.
+ */
+class PmInfoParser
+{
+public:
+    enum Layout {
+        LAYOUT_UNKNOWN,
+        RADEON_DPM,  // radeon (and amdgpu on older asics): "power level 0    sclk: 30000 mclk: 15000 vddc: 900"
+        AMDGPU_BRACKETS,  // "[  sclk  ]: 300 MHz"
+        AMDGPU_SUFFIX  // "300 MHz (SCLK)"
+    };
+
+    /**
+     * @brief Find out which layout the pm_info content uses.
+     * @param module Driver module, layouts are checked in order specific for the driver.
+     * @return Detected layout, LAYOUT_UNKNOWN if no core clock can be found.
+     */
+    static Layout detectLayout(DriverModule module, const char *data, int length);
+
+    /**
+     * @brief Parse pm_info content in given layout.
+     * @return Clocks, fields not found in data are left as -1.
+     */
+    static GPUClocks parse(Layout layout, const char *data, int length);
+
+    /**
+     * @brief Take clocks from a DaemonClocksRecord, pm_info already parsed by the daemon.
+     * @return Clocks, all -1 if data is too short for a record.
+     */
+    static GPUClocks parseRecord(const char *data, int length);
+
+private:
+    static GPUClocks parseRadeonDpm(const char *data, int length);
+    static GPUClocks parseAmdgpuBrackets(const char *data, int length);
+    static GPUClocks parseAmdgpuSuffix(const char *data, int length);
+};
+
+#endif // PMINFOPARSER_H
@@ -31,9 +31,21 @@ SOURCES += main.cpp\
     dxorg.cpp \
     settings.cpp \
     daemonComm.cpp \
+    daemonCommand.cpp \
+    daemonSharedMem.cpp \
     ioctlHandler.cpp \
+    ioctlBackend.cpp \
+    busySampler.cpp \
     ioctl_radeon.cpp \
     ioctl_amdgpu.cpp \
+    sysfsAttribute.cpp \
+    sysfsEnumerator.cpp \
+    pmInfoParser.cpp \
+    samplerThread.cpp \
+    workStealingPool.cpp \
+    timeSeriesStore.cpp \
+    seriesDecimator.cpp \
+    historyFile.cpp \
     execbin.cpp \
     dialogs/dialog_defineplot.cpp \
     dialogs/dialog_rpevent.cpp \
@@ -51,9 +63,21 @@ HEADERS  += radeon_profile.h \
     dxorg.h \
     globalStuff.h \
     daemonComm.h \
+    daemonCommand.h \
+    daemonSharedMem.h \
     execbin.h \
     rpevent.h \
     ioctlHandler.h \
+    ioctlBackend.h \
+    busySampler.h \
+    sysfsAttribute.h \
+    sysfsEnumerator.h \
+    pmInfoParser.h \
+    samplerThread.h \
+    workStealingPool.h \
+    timeSeriesStore.h \
+    seriesDecimator.h \
+    historyFile.h \
     components/rpplot.h \
     components/pieprogressbar.h \
     components/topbarcomponents.h \
@@ -27,15 +27,14 @@
 #include <QDateTime>
 #include <QMessageBox>
 #include <QDebug>
+#include <unistd.h> // geteuid()
 
-DaemonComm radeon_profile::dcomm;
+DaemonComm &radeon_profile::dcomm = DaemonComm::instance();
 
 radeon_profile::radeon_profile(QWidget *parent) :
     QMainWindow(parent),
     icon_tray(nullptr),
     refreshWhenHidden(new QAction(icon_tray)),
-    timer(new QTimer(this)),
-    counter_ticks(0),
     counter_statsTick(0),
     hysteresisRelativeTepmerature(0),
     enableChangeEvent(false),
@@ -46,12 +45,13 @@ radeon_profile::radeon_profile(QWidget *parent) :
 
     connect(dcomm.getSocketPtr(), SIGNAL(connected()), this, SLOT(daemonConnected()));
     connect(dcomm.getSocketPtr(), SIGNAL(disconnected()), this, SLOT(daemonDisconnected()));
+    connect(&device, SIGNAL(initialized()), this, SLOT(deviceInitialized()));
 
     loadConfig();
     setupUiElements();
 
     // checks if running as root
-    if (globalStuff::grabSystemInfo("whoami")[0] == "root") {
+    if (geteuid() == 0) {
         rootMode = true;
         ui->label_rootWarrning->setVisible(true);
 
@@ -72,16 +72,17 @@ radeon_profile::~radeon_profile()
     delete ui;
 }
 
+// continues in deviceInitialized(), which can be later if the daemon reads pm_info
 void radeon_profile::initializeDevice() {
     if (!device.initialize(dXorg::InitializationConfig(rootMode, ui->cb_daemonData->isChecked(), ui->cb_daemonAutoRefresh->isChecked()))) {
         QMessageBox::critical(this,tr("Error"), tr("No Radeon cards have been found in the system."));
 
         for (int i = 0; i < ui->tw_main->count() - 1; ++i)
             ui->tw_main->setTabEnabled(i, false);
-
-        return;
     }
+}
 
+void radeon_profile::deviceInitialized() {
     setupDeviceDependantUiElements();
     setupUiEnabledFeatures(device.getDriverFeatures(), device.gpuData);
 
@@ -89,7 +90,10 @@ void radeon_profile::initializeDevice() {
 
     connectSignals();
 
-    timer->start();
+    device.startSampling();
+
+    if (dcomm.isConnected())
+        configureDaemonPostDeviceInit();
 }
 
 void radeon_profile::daemonConnected() {
@@ -99,9 +103,8 @@ void radeon_profile::daemonConnected() {
 
         configureDaemonPreDeviceInit();
         initializeDevice();
-        configureDaemonPostDeviceInit();
 
-    } else {
+    } else if (!device.isInitializationPending()) {
 
         enableUiControls(true);
         restoreFanState();
@@ -115,25 +118,24 @@ void radeon_profile::daemonDisconnected() {
 }
 
 void radeon_profile::configureDaemonPreDeviceInit() {
-    QString command;
+    DaemonCommand command;
 
-    if (ui->cb_daemonData->isChecked() && ui->cb_daemonAutoRefresh->isChecked()) {
-        command.append(DAEMON_SIGNAL_TIMER_ON).append(SEPARATOR);
-        command.append(QString::number(ui->spin_timerInterval->value())).append(SEPARATOR);
-    } else
-        command.append(DAEMON_SIGNAL_TIMER_OFF).append(SEPARATOR);
+    if (ui->cb_daemonData->isChecked() && ui->cb_daemonAutoRefresh->isChecked())
+        command.timerOn(qRound(ui->spin_timerInterval->value() * 1000));
+    else
+        command.timerOff();
 
     if (ui->combo_connConfirmMethod->currentIndex() == 0)
-        command.append(DAEMON_ALIVE).append(SEPARATOR).append('0').append(SEPARATOR);
+        command.alive(false);
 
     dcomm.sendCommand(command);
 }
 
 void radeon_profile::configureDaemonPostDeviceInit() {
-    QString command;
+    DaemonCommand command;
 
     if (device.getDriverFeatures().isFanControlAvailable)
-         command.append(DAEMON_SIGNAL_CONFIG).append(SEPARATOR).append("pwm1_enable").append(SEPARATOR).append(device.getDriverFiles().hwmonAttributes.pwm1_enable).append(SEPARATOR);
+        command.config("pwm1_enable", device.getDriverFiles().hwmonAttributes.pwm1_enable);
 
     dcomm.sendCommand(command);
 }
@@ -144,7 +146,7 @@ void radeon_profile::connectSignals()
     connect(ui->combo_gpus,SIGNAL(currentIndexChanged(QString)),this,SLOT(gpuChanged()));
     connect(ui->combo_pLevel,SIGNAL(currentIndexChanged(int)),this,SLOT(setPowerLevelFromCombo()));
     connect(&group_Dpm, SIGNAL(buttonClicked(int)), this, SLOT(setPowerLevel(int)));
-    connect(timer,SIGNAL(timeout()),this,SLOT(mainTimerEvent()));
+    connect(&device, SIGNAL(dataReady()), this, SLOT(mainTimerEvent()));
     connect(ui->combo_fanProfiles, SIGNAL(currentIndexChanged(const QString&)), this, SLOT(createFanProfileListaAndGraph(const QString&)));
     connect(ui->combo_ocProfiles, SIGNAL(currentIndexChanged(const QString&)), this, SLOT(createOcProfileListsAndGraph(const QString&)));
     connect(ui->slider_powerCap, SIGNAL(valueChanged(int)), this, SLOT(powerCapValueChange(int)));
@@ -241,7 +243,6 @@ void radeon_profile::setupUiEnabledFeatures(const DriverFeatures &features, cons
                     on_btn_pwmFixed_clicked();
                     break;
                 case 2:
-                    device.getTemperature();
                     on_btn_pwmProfile_clicked();
                     break;
             }
@@ -293,7 +294,7 @@ void radeon_profile::setupUiEnabledFeatures(const DriverFeatures &features, cons
 
                 ui->slider_powerCap->setRange(device.getGpuConstParams().power1_cap_min, device.getGpuConstParams().power1_cap_max);
                 ui->spin_powerCap->setRange(device.getGpuConstParams().power1_cap_min, device.getGpuConstParams().power1_cap_max);
-                ui->slider_powerCap->setValue(device.gpuData[ValueID::POWER_CAP_SELECTED].value);
+                ui->slider_powerCap->setValue(device.gpuData.value(ValueID::POWER_CAP_SELECTED).value);
             }
 
             if (ocProfiles.isEmpty())
@@ -333,16 +334,6 @@ void radeon_profile::setupUiEnabledFeatures(const DriverFeatures &features, cons
     }
 }
 
-void radeon_profile::refreshGpuData() {
-    device.getPowerLevel();
-    device.getClocks();
-    device.getTemperature();
-    device.getGpuUsage();
-    device.getFanSpeed();
-    device.getPowerCapSelected();
-    device.getPowerCapAverage();
-}
-
 void radeon_profile::addTreeWidgetItem(QTreeWidget * parent, const QString &leftColumn, const QString  &rightColumn) {
     parent->addTopLevelItem(new QTreeWidgetItem(QStringList() << leftColumn << rightColumn));
 }
@@ -352,12 +343,12 @@ QString radeon_profile::createCurrentMinMaxString(const QString &current, const
 }
 
 QString radeon_profile::createCurrentMinMaxString(const ValueID idCurrent, const ValueID idMin, const ValueID idMax) {
-    return createCurrentMinMaxString(device.gpuData.value(idCurrent).strValue, device.gpuData.value(idMin).strValue, device.gpuData.value(idMax).strValue);
+    return createCurrentMinMaxString(device.gpuData.value(idCurrent).strValue(), device.gpuData.value(idMin).strValue(), device.gpuData.value(idMax).strValue());
 }
 
 void radeon_profile::refreshUI() {
     // refresh top bar
-    topbarManager.updateItems(device.gpuData);
+    topbarManager.updateItems(device.gpuData, device.cardsData);
 
     // GPU data list
     if (ui->tw_main->currentIndex() == 0) {
@@ -367,7 +358,7 @@ void radeon_profile::refreshUI() {
                     ui->list_currentGPUData->topLevelItem(i)->setText(1, createCurrentMinMaxString(ValueID::TEMPERATURE_CURRENT, ValueID::TEMPERATURE_MIN, ValueID::TEMPERATURE_MAX));
                     continue;
                 case ValueID::POWER_CAP_SELECTED:
-                    ui->list_currentGPUData->topLevelItem(i)->setText(1, createCurrentMinMaxString(device.gpuData.value(ValueID::POWER_CAP_SELECTED).strValue,
+                    ui->list_currentGPUData->topLevelItem(i)->setText(1, createCurrentMinMaxString(device.gpuData.value(ValueID::POWER_CAP_SELECTED).strValue(),
                                                                                                    QString::number(device.getGpuConstParams().power1_cap_min),
                                                                                                    QString::number(device.getGpuConstParams().power1_cap_max)));
                     continue;
@@ -379,7 +370,7 @@ void radeon_profile::refreshUI() {
                     continue;
 
                 default:
-                    ui->list_currentGPUData->topLevelItem(i)->setText(1, device.gpuData.value(keysInCurrentGpuList.at(i)).strValue);
+                    ui->list_currentGPUData->topLevelItem(i)->setText(1, device.gpuData.value(keysInCurrentGpuList.at(i)).strValue());
             }
         }
     }
@@ -423,14 +414,16 @@ void radeon_profile::createCurrentGpuDataListItems()
 void radeon_profile::updateExecLogs() {
     for (int i = 0; i < execsRunning.count(); i++) {
         if (execsRunning.at(i)->getExecState() == QProcess::Running && execsRunning.at(i)->logEnabled) {
-            QString logData = QDateTime::currentDateTime().toString(logDateFormat) +";" + device.gpuData.value(ValueID::POWER_LEVEL, RPValue()).strValue + ";" +
-                    device.gpuData.value(ValueID::CLK_CORE).strValue + ";"+
-                    device.gpuData.value(ValueID::CLK_MEM).strValue + ";"+
-                    device.gpuData.value(ValueID::CLK_UVD).strValue + ";"+
-                    device.gpuData.value(ValueID::DCLK_UVD).strValue + ";"+
-                    device.gpuData.value(ValueID::VOLT_CORE).strValue + ";"+
-                    device.gpuData.value(ValueID::VOLT_MEM).strValue + ";"+
-                    device.gpuData.value(ValueID::TEMPERATURE_CURRENT).strValue;
+            const GPUDataContainer &data = device.cardData(execsRunning.at(i)->logCardIndex);
+
+            QString logData = QDateTime::currentDateTime().toString(logDateFormat) +";" + data.value(ValueID::POWER_LEVEL, RPValue()).strValue() + ";" +
+                    data.value(ValueID::CLK_CORE).strValue() + ";"+
+                    data.value(ValueID::CLK_MEM).strValue() + ";"+
+                    data.value(ValueID::CLK_UVD).strValue() + ";"+
+                    data.value(ValueID::DCLK_UVD).strValue() + ";"+
+                    data.value(ValueID::VOLT_CORE).strValue() + ";"+
+                    data.value(ValueID::VOLT_MEM).strValue() + ";"+
+                    data.value(ValueID::TEMPERATURE_CURRENT).strValue();
             execsRunning.at(i)->appendToLog(logData);
         }
     }
@@ -449,21 +442,25 @@ void radeon_profile::mainTimerEvent() {
     if (!rootMode && !dcomm.isConnected())
         dcomm.connectToDaemon();
 
-    if (!refreshWhenHidden->isChecked() && this->isHidden()) {
+    const bool fanProfileActive = device.gpuData.contains(ValueID::FAN_SPEED_PERCENT) && device.getDriverFeatures().isChangeProfileAvailable && ui->btn_pwmProfile->isChecked(),
+            hidden = !refreshWhenHidden->isChecked() && this->isHidden();
 
-        // even if in tray, keep the fan control active (if enabled)
-        if (device.gpuData.contains(ValueID::FAN_SPEED_PERCENT) && device.getDriverFeatures().isChangeProfileAvailable && ui->btn_pwmProfile->isChecked()) {
-            device.getTemperature();
-            adjustFanSpeed();
-        }
-        return;
-    }
+    // even if in tray, keep the fan control active (if enabled), so sampler reads the temperature only
+    if (hidden)
+        device.setSamplingMode(fanProfileActive ? SamplerThread::TEMPERATURE_ONLY : SamplerThread::IDLE);
+    else
+        device.setSamplingMode(SamplerThread::FULL);
 
-    refreshGpuData();
+    // data is sampled in another thread, here only the latest snapshot is taken
+    if (!device.readLatestSnapshot())
+        return;
 
-    if (device.gpuData.contains(ValueID::FAN_SPEED_PERCENT) && device.getDriverFeatures().isChangeProfileAvailable && ui->btn_pwmProfile->isChecked())
+    if (fanProfileActive)
         adjustFanSpeed();
 
+    if (hidden)
+        return;
+
     if (Q_LIKELY(ui->cb_graphs->isChecked()))
         refreshGraphs();
 
@@ -540,10 +537,11 @@ void radeon_profile::restoreFanState() {
 }
 
 void radeon_profile::refreshGraphs() {
-    if (ui->stack_plots->currentIndex() != 0 || plotManager.plots.count() == 0)
+    // history is recorded anyway, plots catch up when they are shown again
+    if (ui->stack_plots->currentIndex() != 0 || !ui->stack_plots->isVisible() || plotManager.plots.count() == 0)
         return;
 
-    plotManager.updateSeries(++counter_ticks, device.gpuData);
+    plotManager.updateSeries(device.cardsHistory, device.currentGpuIndex);
 }
 
 void radeon_profile::doTheStats() {
@@ -551,7 +549,7 @@ void radeon_profile::doTheStats() {
     counter_statsTick++;
 
     // figure out pm level based on data provided
-    QString pmLevelName = "Core: " + device.gpuData.value(ValueID::CLK_CORE).strValue + "  Mem: " + device.gpuData.value(ValueID::CLK_MEM).strValue;
+    QString pmLevelName = "Core: " + device.gpuData.value(ValueID::CLK_CORE).strValue() + "  Mem: " + device.gpuData.value(ValueID::CLK_MEM).strValue();
 
     if (pmStats.contains(pmLevelName))
         pmStats[pmLevelName]++;
@@ -573,7 +571,7 @@ void radeon_profile::refreshTooltip()
     QString tooltipData = radeon_profile::windowTitle() + "\n" + tr("Current profile: ")+ device.currentPowerProfile + "  " + device.currentPowerLevel +"\n";
 
     for (auto i = 0; i < ui->list_currentGPUData->topLevelItemCount(); i++)
-        tooltipData += ui->list_currentGPUData->topLevelItem(i)->text(0) + ": " + device.gpuData.value(keysInCurrentGpuList.at(i)).strValue + '\n';
+        tooltipData += ui->list_currentGPUData->topLevelItem(i)->text(0) + ": " + device.gpuData.value(keysInCurrentGpuList.at(i)).strValue() + '\n';
 
     icon_tray->setToolTip(tooltipData.trimmed());
 }
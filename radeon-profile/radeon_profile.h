@@ -28,6 +28,11 @@
 #define minFanStepSpeed 0
 #define maxFanStepSpeed 100
 
+// time range of plots in seconds, slider_timeRange moves over it in logarithmic steps
+#define minPlotsTimeRange 60
+#define maxPlotsTimeRange 86400
+#define plotsTimeRangeSteps 1000
+
 #define appVersion 20190903
 
 namespace Ui {
@@ -63,7 +68,7 @@ public:
     explicit radeon_profile(QWidget *parent = 0);
     ~radeon_profile();
     
-    static DaemonComm dcomm;
+    static DaemonComm &dcomm;
 
 private slots:
     void mainTimerEvent();
@@ -154,6 +159,7 @@ private slots:
     void ocProfilesMenuActionClicked(QAction* action);
     void daemonConnected();
     void daemonDisconnected();
+    void deviceInitialized();
     void on_btn_connConfirmMethodInfo_clicked();
     void frequencyControlToggled(bool toogle);
     void applyFrequencyTables();
@@ -168,7 +174,6 @@ private:
 
     QSystemTrayIcon *icon_tray;
     QAction *refreshWhenHidden;
-    QTimer *timer;
 
 
     gpu device;
@@ -178,7 +183,7 @@ private:
     QMap<QString, OCProfile> ocProfiles;
     QMap<QString, RPEvent> events;
     QMap<QString, unsigned int> pmStats;
-    unsigned int counter_ticks, counter_statsTick;
+    unsigned int counter_statsTick;
     short hysteresisRelativeTepmerature;
     bool enableChangeEvent, rootMode;
     QButtonGroup group_pwm, group_Dpm;
@@ -200,8 +205,9 @@ private:
     void doTheStats();
     void updateStatsTable();
     void addRuntmeWidgets();
-    void refreshGpuData();
     void refreshGraphs();
+    static int timeRangeFromSlider(int position);
+    static int sliderFromTimeRange(int seconds);
     void setupUiEnabledFeatures(const DriverFeatures &features, const GPUDataContainer &data);
     void loadVariables();
     void updateExecLogs();
@@ -0,0 +1,299 @@
+#include "samplerThread.h"
+
+#include <QTimer>
+#include <QDateTime>
+#include <QDebug>
+
+// the sampler thread runs tasks as well, so up to 4 reads at once
+#define MAX_POOL_THREADS 3
+
+// set by applyTemperature()
+#define TEMPERATURE_IDS ((1u << ValueID::TEMPERATURE_CURRENT) | (1u << ValueID::TEMPERATURE_BEFORE_CURRENT) \
+    | (1u << ValueID::TEMPERATURE_MIN) | (1u << ValueID::TEMPERATURE_MAX))
+
+SamplerThread::SamplerThread(QObject *parent) : QThread(parent),
+    pool(qBound(1, QThread::idealThreadCount() - 1, MAX_POOL_THREADS)),
+    sequence(0),
+    interval(1000),
+    mode(SamplingMode::FULL),
+    notificationPending(false) { }
+
+SamplerThread::~SamplerThread() {
+    stop();
+}
+
+void SamplerThread::setDriverHandlers(const QVector<dXorg*> &handlers, const QVector<GPUDataContainer> &initialData) {
+    cards.clear();
+    cards.reserve(handlers.count());
+
+    for (int i = 0; i < handlers.count(); ++i) {
+        CardState card;
+        card.driverHandler = handlers.at(i);
+        card.index = i;
+        card.sample.data = initialData.value(i);
+        card.sample.sampledIds = card.sample.data.presentIds().mask;
+        card.sample.powerProfile = card.driverHandler->getCurrentPowerProfile();
+        card.sample.powerLevel = card.driverHandler->getCurrentPowerLevel();
+
+        cards.push_back(card);
+    }
+
+    // atomics can't be moved, so a new vector for every card set
+    minMaxResetRequested = std::vector<std::atomic<bool>>(handlers.count());
+
+    createTasks();
+    publish();
+}
+
+// groups read different files (or the ioctl), so tasks of one card can run at the same time
+void SamplerThread::createTasks() {
+    fullTasks.clear();
+    temperatureTasks.clear();
+
+    for (CardState &c : cards) {
+        CardState *card = &c;
+        const GPUDataContainer &data = card->sample.data;
+
+        fullTasks.push_back([card]() {
+            card->readings.powerLevel = card->driverHandler->getCurrentPowerLevel();
+            card->readings.powerProfile = card->driverHandler->getCurrentPowerProfile();
+        });
+
+        const bool usageNeeded = data.contains(ValueID::GPU_USAGE_PERCENT) || data.contains(ValueID::GPU_VRAM_USAGE_MB)
+                || data.contains(ValueID::GPU_VRAM_USAGE_PERCENT);
+
+        // clocks and usage share the ioctl sensors
+        fullTasks.push_back([card, usageNeeded]() {
+            const SensorSnapshot sensors = card->driverHandler->sampleSensors();
+            card->readings.clocks = card->driverHandler->getClocks(sensors);
+
+            if (usageNeeded)
+                card->readings.usage = card->driverHandler->getGPUUsage(sensors);
+        });
+
+        if (data.contains(ValueID::TEMPERATURE_CURRENT)) {
+            auto temperatureTask = [card]() {
+                card->readings.temperature = card->driverHandler->getTemperature();
+            };
+
+            fullTasks.push_back(temperatureTask);
+            temperatureTasks.push_back(temperatureTask);
+        }
+
+        if (data.contains(ValueID::FAN_SPEED_PERCENT)) {
+            fullTasks.push_back([card]() {
+                card->readings.fan = card->driverHandler->getFanSpeed();
+            });
+        }
+
+        if (card->driverHandler->features.isPowerCapAvailable) {
+            fullTasks.push_back([card]() {
+                card->readings.powerCapSelected = card->driverHandler->getPowerCapSelected();
+                card->readings.powerCapAverage = card->driverHandler->getPowerCapAverage();
+            });
+        }
+    }
+}
+
+GPUSnapshotPtr SamplerThread::takeLatestSnapshot() {
+    notificationPending = false;
+    return std::atomic_load(&latestSnapshot);
+}
+
+void SamplerThread::setInterval(int msec) {
+    interval = msec;
+}
+
+void SamplerThread::setMode(SamplingMode newMode) {
+    mode = newMode;
+}
+
+void SamplerThread::requestMinMaxReset(int card) {
+    if (card < 0 || card >= static_cast<int>(minMaxResetRequested.size()))
+        return;
+
+    minMaxResetRequested[card] = true;
+}
+
+void SamplerThread::stop() {
+    if (!isRunning())
+        return;
+
+    quit();
+    wait();
+}
+
+void SamplerThread::sampleOnce() {
+    if (isRunning() || cards.empty())
+        return;
+
+    sample();
+}
+
+void SamplerThread::run() {
+    if (cards.empty())
+        return;
+
+    qDebug() << "Sampler thread started";
+
+    QTimer timer;
+    timer.setInterval(interval);
+
+    // the timer lives in this thread, so the lambda runs here as well
+    connect(&timer, &QTimer::timeout, [this, &timer]() {
+        sample();
+
+        if (timer.interval() != interval)
+            timer.setInterval(interval);
+    });
+
+    timer.start();
+    exec();
+
+    qDebug() << "Sampler thread stopped";
+}
+
+void SamplerThread::sample() {
+    const SamplingMode currentMode = static_cast<SamplingMode>(mode.load());
+
+    switch (currentMode) {
+        case SamplingMode::FULL:
+            // barrier, all reads of all cards are done after this
+            pool.run(fullTasks);
+
+            for (CardState &card : cards) {
+                card.sample.powerLevel = card.readings.powerLevel;
+                card.sample.powerProfile = card.readings.powerProfile;
+                applyClocks(card);
+                applyTemperature(card);
+                applyGpuUsage(card);
+                applyFanSpeed(card);
+                applyPowerCap(card);
+                card.sample.sampledIds = card.sample.data.presentIds().mask;
+            }
+
+            publish();
+            break;
+
+        case SamplingMode::TEMPERATURE_ONLY:
+            pool.run(temperatureTasks);
+
+            // clocks, usage and the rest keep values of the last full tick, they aren't samples of this one
+            for (CardState &card : cards) {
+                applyTemperature(card);
+                card.sample.sampledIds = card.sample.data.presentIds().mask & TEMPERATURE_IDS;
+            }
+
+            publish();
+            break;
+
+        case SamplingMode::IDLE:
+            break;
+    }
+
+    if (!notificationPending.exchange(true))
+        emit snapshotReady();
+}
+
+void SamplerThread::publish() {
+    auto snapshot = std::make_shared<GPUSnapshot>();
+
+    // fixed size copies, strings inside are implicitly shared
+    snapshot->cards.reserve(cards.size());
+    for (const CardState &card : cards)
+        snapshot->cards.append(card.sample);
+
+    snapshot->sequence = ++sequence;
+    snapshot->timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    std::atomic_store(&latestSnapshot, GPUSnapshotPtr(snapshot));
+}
+
+void SamplerThread::applyClocks(CardState &card) {
+    GPUDataContainer &data = card.sample.data;
+    const GPUClocks &tmp = card.readings.clocks;
+
+    if (data.contains(ValueID::CLK_CORE))
+        data[ValueID::CLK_CORE].setValue(tmp.coreClk);
+
+    if (data.contains(ValueID::VOLT_CORE))
+        data[ValueID::VOLT_CORE].setValue(tmp.coreVolt);
+
+    if (data.contains(ValueID::CLK_MEM))
+        data[ValueID::CLK_MEM].setValue(tmp.memClk);
+
+    if (data.contains(ValueID::VOLT_MEM))
+        data[ValueID::VOLT_MEM].setValue(tmp.memVolt);
+
+    if (data.contains(ValueID::CLK_UVD))
+        data[ValueID::CLK_UVD].setValue(tmp.uvdCClk);
+
+    if (data.contains(ValueID::DCLK_UVD))
+        data[ValueID::DCLK_UVD].setValue(tmp.uvdDClk);
+
+    if (data.contains(ValueID::POWER_LEVEL))
+        data[ValueID::POWER_LEVEL].setValue(tmp.powerLevel);
+}
+
+void SamplerThread::applyTemperature(CardState &card) {
+    GPUDataContainer &data = card.sample.data;
+
+    if (!data.contains(ValueID::TEMPERATURE_CURRENT))
+        return;
+
+    data[ValueID::TEMPERATURE_BEFORE_CURRENT].setValue(data.value(ValueID::TEMPERATURE_CURRENT).value);
+    data[ValueID::TEMPERATURE_CURRENT].setValue(card.readings.temperature);
+
+    const float current = card.readings.temperature;
+
+    if (minMaxResetRequested[card.index].exchange(false)) {
+        data[ValueID::TEMPERATURE_MIN].setValue(current);
+        data[ValueID::TEMPERATURE_MAX].setValue(current);
+        return;
+    }
+
+    if (data.value(ValueID::TEMPERATURE_MIN, RPValue()).value > current)
+        data[ValueID::TEMPERATURE_MIN].setValue(current);
+
+    if (data.value(ValueID::TEMPERATURE_MAX, RPValue()).value < current)
+        data[ValueID::TEMPERATURE_MAX].setValue(current);
+}
+
+void SamplerThread::applyGpuUsage(CardState &card) {
+    GPUDataContainer &data = card.sample.data;
+    const GPUUsage &tmp = card.readings.usage;
+
+    if (data.contains(ValueID::GPU_USAGE_PERCENT))
+        data[ValueID::GPU_USAGE_PERCENT].setValue(tmp.gpuUsage);
+
+    if (data.contains(ValueID::GPU_VRAM_USAGE_MB))
+        data[ValueID::GPU_VRAM_USAGE_MB].setValue(tmp.gpuVramUsage);
+
+    if (data.contains(ValueID::GPU_VRAM_USAGE_PERCENT))
+        data[ValueID::GPU_VRAM_USAGE_PERCENT].setValue(tmp.gpuVramUsagePercent);
+}
+
+void SamplerThread::applyFanSpeed(CardState &card) {
+    GPUDataContainer &data = card.sample.data;
+
+    if (!data.contains(ValueID::FAN_SPEED_PERCENT))
+        return;
+
+    data[ValueID::FAN_SPEED_PERCENT].setValue(card.readings.fan.fanSpeedPercent);
+
+    if (data.contains(ValueID::FAN_SPEED_RPM))
+        data[ValueID::FAN_SPEED_RPM].setValue(card.readings.fan.fanSpeedRpm);
+}
+
+void SamplerThread::applyPowerCap(CardState &card) {
+    GPUDataContainer &data = card.sample.data;
+
+    if (!card.driverHandler->features.isPowerCapAvailable)
+        return;
+
+    if (data.contains(ValueID::POWER_CAP_SELECTED))
+        data[ValueID::POWER_CAP_SELECTED].setValue(card.readings.powerCapSelected);
+
+    if (data.contains(ValueID::POWER_CAP_AVERAGE))
+        data[ValueID::POWER_CAP_AVERAGE].setValue(card.readings.powerCapAverage);
+}
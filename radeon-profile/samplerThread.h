@@ -0,0 +1,148 @@
+#ifndef SAMPLERTHREAD_H
+#define SAMPLERTHREAD_H
+
+#include "globalStuff.h"
+#include "dxorg.h"
+#include "workStealingPool.h"
+
+#include <QThread>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Values of one card read in a sampler tick.
+ */
+struct GPUCardSample {
+    GPUDataContainer data;
+    quint32 sampledIds = 0;  // bit of every ValueID read in the tick, the others in data are from an earlier one
+    QString powerProfile, powerLevel;
+};
+
+/**
+ * @brief Immutable set of values of all monitored cards read in one sampler tick.
+ */
+struct GPUSnapshot {
+    QVector<GPUCardSample> cards;  // in order of gpu::gpuList
+    quint64 sequence;
+    qint64 timestamp;  // when the values were read, in mS since epoch
+};
+
+typedef std::shared_ptr<const GPUSnapshot> GPUSnapshotPtr;
+
+/**
+ * @brief The SamplerThread class reads the drivers of all monitored cards on its own thread and timer,
+ * so slow sysfs reads or sensors don't stall the gui.
+ * A tick is split in tasks per card and attribute group, run on a WorkStealingPool, so it takes as long
+ * as the slowest read instead of the sum of all reads. Results are applied after the pool barrier.
+ * Every tick produces a new GPUSnapshot which is published with an atomic shared_ptr swap,
+ * readers always get a complete snapshot and keep it alive as long as they hold the pointer.
+ */
+class SamplerThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum SamplingMode {
+        FULL,
+        TEMPERATURE_ONLY,  // window hidden, only the fan control needs data
+        IDLE  // window hidden, nothing needs data, only the tick is signaled
+    };
+
+    explicit SamplerThread(QObject *parent = 0);
+    ~SamplerThread();
+
+    /**
+     * @brief Set the drivers to sample from and publish the initial data as first snapshot.
+     * @note Only when the thread is stopped.
+     * @param handlers Driver handler of every card, owned by the caller.
+     * @param initialData Container with all values available, for every card.
+     */
+    void setDriverHandlers(const QVector<dXorg*> &handlers, const QVector<GPUDataContainer> &initialData);
+
+    /**
+     * @brief Take the latest published snapshot and allow signaling the next one.
+     * @return Snapshot, nullptr if nothing was published yet.
+     */
+    GPUSnapshotPtr takeLatestSnapshot();
+
+    void setInterval(int msec);
+
+    int getInterval() const {
+        return interval;
+    }
+
+    void setMode(SamplingMode newMode);
+
+    /**
+     * @brief Set temperature min and max of the card to the current temperature in the next tick.
+     * @param card Index of the card.
+     */
+    void requestMinMaxReset(int card);
+
+    void stop();
+
+    /**
+     * @brief Run one tick on the calling thread (for benchmarks), the thread must be stopped.
+     */
+    void sampleOnce();
+
+    int poolThreadCount() const {
+        return pool.threadCount();
+    }
+
+signals:
+    /**
+     * @brief Emitted after a tick, but only once until the snapshot is taken,
+     * so a slow consumer doesn't get a queue of notifications.
+     */
+    void snapshotReady();
+
+protected:
+    void run();
+
+private:
+    // raw values read by the tasks of one card, every group writes only its own fields
+    struct CardReadings {
+        GPUClocks clocks;
+        GPUUsage usage;
+        GPUFanSpeed fan;
+        float temperature = -1;
+        int powerCapSelected = -1, powerCapAverage = -1;
+        QString powerLevel, powerProfile;
+    };
+
+    struct CardState {
+        dXorg *driverHandler;
+        int index;
+        GPUCardSample sample;
+        CardReadings readings;
+    };
+
+    // touched only by the sampler thread (and the pool threads during a tick) while it runs
+    std::vector<CardState> cards;
+    WorkStealingPool pool;
+    std::vector<WorkStealingPool::Task> fullTasks, temperatureTasks;
+
+    // accessed only with std::atomic_load/atomic_store
+    GPUSnapshotPtr latestSnapshot;
+
+    std::atomic<quint64> sequence;
+    std::atomic<int> interval;
+    std::atomic<int> mode;
+    std::vector<std::atomic<bool>> minMaxResetRequested;  // one per card, resized only while the thread is stopped
+    std::atomic<bool> notificationPending;
+
+    void createTasks();
+    void sample();
+    void publish();
+    void applyClocks(CardState &card);
+    void applyTemperature(CardState &card);
+    void applyGpuUsage(CardState &card);
+    void applyFanSpeed(CardState &card);
+    void applyPowerCap(CardState &card);
+};
+
+#endif // SAMPLERTHREAD_H
@@ -0,0 +1,85 @@
+#include "seriesDecimator.h"
+
+static inline QPointF pointOf(const TimeSeriesStore &store, int index, float value, qint64 timeOrigin) {
+    return QPointF((store.timestamp(index) - timeOrigin) / 1000.0, value);
+}
+
+// minimum and maximum of a bucket in time order, samples of a rollup have both
+static inline void appendBucket(const TimeSeriesStore &store, ValueID id, int minIndex, int maxIndex, qint64 timeOrigin,
+                                QVector<QPointF> *points) {
+    const QPointF min = pointOf(store, minIndex, store.minimum(id, minIndex), timeOrigin),
+            max = pointOf(store, maxIndex, store.maximum(id, maxIndex), timeOrigin);
+
+    if (maxIndex < minIndex) {
+        points->append(max);
+        points->append(min);
+        return;
+    }
+
+    points->append(min);
+
+    if (max != min)
+        points->append(max);
+}
+
+int SeriesDecimator::minMax(const TimeSeriesStore &store, ValueID id, int from, qint64 start, qint64 end, int columns,
+                             qint64 timeOrigin, QVector<QPointF> *points) {
+    points->clear();
+
+    const int count = store.count();
+    from = qMax(0, from);
+
+    // sample before the window, only the entry point of the line (a raw sample takes 1 mS, a rollup its bucket)
+    if (from < count && store.timestamp(from) + qMax(1, store.bucketMsec()) <= start) {
+        if (store.hasValue(id, from))
+            points->append(pointOf(store, from, store.value(id, from), timeOrigin));
+
+        ++from;
+    }
+
+    const int entryPoints = points->count();
+
+    if (count - from <= 2 * columns || end <= start || columns <= 0) {
+        points->reserve(entryPoints + (store.isRollup() ? 2 : 1) * (count - from));
+
+        for (int i = from; i < count; ++i) {
+            if (store.hasValue(id, i))
+                appendBucket(store, id, i, i, timeOrigin, points);
+        }
+
+        return entryPoints;
+    }
+
+    points->reserve(entryPoints + 2 * columns);
+
+    const qint64 duration = end - start;
+    int column = -1, minIndex = -1, maxIndex = -1;
+
+    for (int i = from; i < count; ++i) {
+        if (!store.hasValue(id, i))
+            continue;
+
+        const int sampleColumn = static_cast<int>(qBound(static_cast<qint64>(0), (store.timestamp(i) - start) * columns / duration,
+                                                         static_cast<qint64>(columns - 1)));
+
+        if (sampleColumn != column) {
+            if (column != -1)
+                appendBucket(store, id, minIndex, maxIndex, timeOrigin, points);
+
+            column = sampleColumn;
+            minIndex = maxIndex = i;
+            continue;
+        }
+
+        if (store.minimum(id, i) < store.minimum(id, minIndex))
+            minIndex = i;
+
+        if (store.maximum(id, i) > store.maximum(id, maxIndex))
+            maxIndex = i;
+    }
+
+    if (column != -1)
+        appendBucket(store, id, minIndex, maxIndex, timeOrigin, points);
+
+    return entryPoints;
+}
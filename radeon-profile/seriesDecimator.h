@@ -0,0 +1,38 @@
+#ifndef SERIESDECIMATOR_H
+#define SERIESDECIMATOR_H
+
+#include "timeSeriesStore.h"
+
+#include <QVector>
+#include <QPointF>
+
+/**
+ * @brief The SeriesDecimator class makes plot points from a window of TimeSeriesStore, with no more points
+ * than the plot can show. Samples are split into buckets by pixel column and every bucket gives its
+ * minimum and maximum, in time order, so peaks (e.g. a temperature spike) are never lost and the
+ * minimum and maximum of the points are the same as those of the samples.
+ * From a rollup, minimums and maximums of buckets are used, so peaks survive the rollup as well.
+ */
+class SeriesDecimator
+{
+public:
+    /**
+     * @brief Make points of id from samples [from, count) of store, at most two per pixel column.
+     * If there are no more samples than two per column, every sample becomes a point (two for a rollup bucket).
+     * A sample (or a whole rollup bucket) before start only leads the line in from the left edge: it is the first
+     * point, with its value, and is not part of the minimum and maximum of the first column.
+     * @param store History the samples are taken from.
+     * @param id Value the points are made of, samples without it are skipped.
+     * @param from Index of the first sample, the one before start or the first one in the window.
+     * @param start Timestamp at the left edge of the plot.
+     * @param end Timestamp at the right edge of the plot.
+     * @param columns Width of the plot area, in pixels.
+     * @param timeOrigin Timestamp at x = 0, x of points is in seconds.
+     * @param points Filled with the points, in time order.
+     * @return Number of points before start at the beginning of points, 0 or 1.
+     */
+    static int minMax(const TimeSeriesStore &store, ValueID id, int from, qint64 start, qint64 end, int columns,
+                       qint64 timeOrigin, QVector<QPointF> *points);
+};
+
+#endif // SERIESDECIMATOR_H
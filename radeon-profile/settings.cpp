@@ -40,7 +40,8 @@ void radeon_profile::saveConfig() {
         settings.setValue("aleternateRowColors",ui->cb_alternateRow->isChecked());
 
         settings.setValue("graphOffset", ui->cb_plotsRightGap->isChecked());
-        settings.setValue("graphRange",ui->slider_timeRange->value());
+        settings.setValue("graphRange", timeRangeFromSlider(ui->slider_timeRange->value()));
+        settings.setValue("historyFileSize", device.getHistoryFileSize());
         settings.setValue("showLegend",ui->cb_showLegends->isChecked());
         settings.setValue("plotsBackgroundColor", ui->frame_plotsBackground->palette().background().color().name());
         settings.setValue("setCommonPlotsBg", ui->cb_overridePlotsBg->isChecked());
@@ -130,6 +131,7 @@ void radeon_profile::saveExecProfiles(QXmlStreamWriter &xml) {
         xml.writeAttribute("envSettings", ui->list_execProfiles->topLevelItem(i)->text(ENV_SETTINGS));
         xml.writeAttribute("logFile",  ui->list_execProfiles->topLevelItem(i)->text(LOG_FILE));
         xml.writeAttribute("logFileDateAppend", ui->list_execProfiles->topLevelItem(i)->text(LOG_FILE_DATE_APPEND));
+        xml.writeAttribute("logCardIndex", QString::number(ui->list_execProfiles->topLevelItem(i)->data(LOG_FILE, Qt::UserRole).toInt()));
         xml.writeEndElement();
     }
 
@@ -223,6 +225,7 @@ void radeon_profile::savePlotSchemas(QXmlStreamWriter &xml) {
         xml.writeAttribute("name", k);
         xml.writeAttribute("enabled", QString::number(pds.enabled));
         xml.writeAttribute("background", pds.background.name());
+        xml.writeAttribute("cardIndex", QString::number(pds.cardIndex));
 
         writePlotAxisSchemaToXml(xml, "left", pds.left);
         writePlotAxisSchemaToXml(xml, "right", pds.right);
@@ -246,6 +249,7 @@ void radeon_profile::saveTopbarItemsSchemas(QXmlStreamWriter &xml) {
         xml.writeAttribute("secondaryValueId", QString::number(tis.secondaryValueId));
         xml.writeAttribute("secondaryColor", tis.secondaryColor.name());
         xml.writeAttribute("pieMaxValue", QString::number(tis.pieMaxValue));
+        xml.writeAttribute("cardIndex", QString::number(tis.cardIndex));
 
         xml.writeEndElement();
     }
@@ -277,7 +281,9 @@ void radeon_profile::loadConfig() {
         ui->stack_fanModes->setCurrentIndex(settings.value("fanMode",0).toInt());
 
     ui->cb_plotsRightGap->setChecked(settings.value("graphOffset",true).toBool());
-    ui->slider_timeRange->setValue(settings.value("graphRange",600).toInt());
+    ui->slider_timeRange->setValue(sliderFromTimeRange(settings.value("graphRange",600).toInt()));
+    plotManager.setTimeRange(timeRangeFromSlider(ui->slider_timeRange->value()));
+    device.setHistoryFile(getConfigPath(), settings.value("historyFileSize", HISTORY_FILE_DEFAULT_SIZE).toInt());
     ui->cb_showLegends->setChecked(settings.value("showLegend",false).toBool());
     ui->cb_execSysEnv->setChecked(settings.value("appendSysEnv",true).toBool());
     ui->cb_eventsTracking->setChecked(settings.value("eventsTracking", false).toBool());
@@ -324,7 +330,7 @@ void radeon_profile::loadConfig() {
                          desktopSize.height() / 2); // Height
     }
 
-    timer->setInterval(ui->spin_timerInterval->value() * 1000);
+    device.setSamplingInterval(ui->spin_timerInterval->value() * 1000);
 
     if (ui->cb_stats->isChecked())
         ui->tw_systemInfo->setTabEnabled(3,true);
@@ -427,6 +433,10 @@ void radeon_profile::loadPlotSchemas(QXmlStreamReader &xml) {
     pds.enabled = xml.attributes().value("enabled").toInt();
     pds.background = QColor(xml.attributes().value("background").toString());
 
+    // configs without the attribute follow the selected card
+    if (xml.attributes().hasAttribute("cardIndex"))
+        pds.cardIndex = xml.attributes().value("cardIndex").toInt();
+
     while (xml.readNext()) {
         if (xml.name().toString() == "axis") {
 
@@ -470,6 +480,9 @@ void radeon_profile::loadTopbarItemsSchemas(const QXmlStreamReader &xml) {
         tis.setSecondaryValueId(static_cast<ValueID>(xml.attributes().value("secondaryValueId").toInt()));
     }
 
+    if (xml.attributes().hasAttribute("cardIndex"))
+        tis.setCardIndex(xml.attributes().value("cardIndex").toInt());
+
     topbarManager.addSchema(tis);
 }
 
@@ -482,6 +495,7 @@ void radeon_profile::loadExecProfile(const QXmlStreamReader &xml) {
     item->setText(ENV_SETTINGS, xml.attributes().value("envSettings").toString());
     item->setText(LOG_FILE, xml.attributes().value("logFile").toString());
     item->setText(LOG_FILE_DATE_APPEND, xml.attributes().value("logFileDateAppend").toString());
+    item->setData(LOG_FILE, Qt::UserRole, xml.attributes().hasAttribute("logCardIndex") ? xml.attributes().value("logCardIndex").toInt() : -1);
 
     ui->list_execProfiles->addTopLevelItem(item);
 }
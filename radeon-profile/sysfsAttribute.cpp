@@ -0,0 +1,110 @@
+#include "sysfsAttribute.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <atomic>
+#include <cerrno>
+#include <unistd.h> // pread(), close()
+#include <fcntl.h> // open()
+
+static std::atomic<int> artificialLatency(0);
+
+SysfsAttribute::SysfsAttribute(const QString &filePath) :
+    path(filePath),
+    localPath(QFile::encodeName(filePath)),
+    fd(-1) { }
+
+SysfsAttribute::~SysfsAttribute() {
+    close();
+}
+
+bool SysfsAttribute::open() {
+    if (path.isEmpty())
+        return false;
+
+    // not logged, some files (like debugfs pm_info without root) are expected to fail on every refresh
+    fd = ::open(localPath.constData(), O_RDONLY | O_CLOEXEC);
+    return fd >= 0;
+}
+
+void SysfsAttribute::close() {
+    if (fd >= 0)
+        ::close(fd);
+
+    fd = -1;
+}
+
+int SysfsAttribute::read(char *buffer, int size) {
+    QMutexLocker locker(&mutex);
+
+    if (fd < 0 && !open())
+        return -1;
+
+    if (artificialLatency > 0)
+        usleep(artificialLatency);
+
+    ssize_t length = pread(fd, buffer, size - 1, 0);
+
+    // device was removed and bound again (driver reload, hwmon re-registration),
+    // the old descriptor is dead, so open the file again and retry once
+    if (length < 0 && (errno == ENODEV || errno == EBADF)) {
+        close();
+        if (!open())
+            return -1;
+
+        length = pread(fd, buffer, size - 1, 0);
+    }
+
+    if (length < 0)
+        return -1;
+
+    while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == ' ' || buffer[length - 1] == '\t'))
+        --length;
+
+    buffer[length] = '\0';
+    return length;
+}
+
+void SysfsAttribute::setArtificialLatency(int usec) {
+    artificialLatency = qMax(0, usec);
+}
+
+bool SysfsAttribute::parseInt(const char *buffer, int length, long long *data) {
+    int i = 0;
+    while (i < length && (buffer[i] == ' ' || buffer[i] == '\t' || buffer[i] == '\n'))
+        ++i;
+
+    bool negative = false;
+    if (i < length && (buffer[i] == '-' || buffer[i] == '+'))
+        negative = buffer[i++] == '-';
+
+    if (i == length || buffer[i] < '0' || buffer[i] > '9')
+        return false;
+
+    long long value = 0;
+    for (; i < length && buffer[i] >= '0' && buffer[i] <= '9'; ++i)
+        value = value * 10 + (buffer[i] - '0');
+
+    *data = negative ? -value : value;
+    return true;
+}
+
+bool SysfsAttribute::readInt(long long *data) {
+    char buffer[SYSFS_ATTRIBUTE_BUFFER_SIZE];
+    int length = read(buffer, sizeof(buffer));
+
+    if (length <= 0)
+        return false;
+
+    return parseInt(buffer, length, data);
+}
+
+QString SysfsAttribute::readString() {
+    char buffer[SYSFS_ATTRIBUTE_BUFFER_SIZE];
+    int length = read(buffer, sizeof(buffer));
+
+    if (length < 0)
+        return "-1";
+
+    return QString::fromLatin1(buffer, length).trimmed();
+}
@@ -0,0 +1,77 @@
+#ifndef SYSFSATTRIBUTE_H
+#define SYSFSATTRIBUTE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+#define SYSFS_ATTRIBUTE_BUFFER_SIZE 64
+
+/**
+ * @brief The SysfsAttribute class keeps a sysfs attribute open and re-reads it with pread().
+ * Sysfs regenerates the content of an attribute on every read from offset 0, so the file descriptor
+ * can be kept for the whole life of the object instead of open/read/close on every refresh.
+ */
+class SysfsAttribute
+{
+public:
+    /**
+     * @brief Create the attribute, file is opened on first read.
+     * @param filePath Full path to the sysfs file.
+     */
+    explicit SysfsAttribute(const QString &filePath);
+    ~SysfsAttribute();
+
+    /**
+     * @brief Read the raw content of the attribute, trailing whitespace is stripped. Thread safe.
+     * @param buffer Memory area to store the data, always null terminated on success.
+     * @param size Size of the memory area.
+     * @return Number of bytes stored in buffer, -1 on failure.
+     */
+    int read(char *buffer, int size);
+
+    /**
+     * @brief Read the attribute and parse it as integer, without building any QString.
+     * @param data On success is filled with the value.
+     * @return Success.
+     */
+    bool readInt(long long *data);
+
+    /**
+     * @brief Read the attribute as string (for attributes like power_dpm_state).
+     * @return Content of the attribute, "-1" on failure.
+     */
+    QString readString();
+
+    const QString& getPath() const {
+        return path;
+    }
+
+    /**
+     * @brief Parse integer from the beginning of buffer, leading whitespace is skipped.
+     * @return Success (false if there are no digits).
+     */
+    static bool parseInt(const char *buffer, int length, long long *data);
+
+    /**
+     * @brief Delay every read, to simulate slow attributes (like hwmon of some chips) in benchmarks.
+     * @param usec Delay in microseconds, 0 to disable.
+     */
+    static void setArtificialLatency(int usec);
+
+private:
+    QString path;
+    QByteArray localPath;
+    int fd;
+
+    // the sampler pool and the gui thread can read one attribute at once, a reopen replaces fd
+    QMutex mutex;
+
+    SysfsAttribute(const SysfsAttribute &) = delete;
+    SysfsAttribute& operator=(const SysfsAttribute &) = delete;
+
+    bool open();
+    void close();
+};
+
+#endif // SYSFSATTRIBUTE_H
@@ -0,0 +1,43 @@
+#include "sysfsEnumerator.h"
+#include "globalStuff.h"
+
+#include <QFile>
+#include <dirent.h> // opendir(), readdir(), closedir()
+
+QStringList SysfsEnumerator::entries(const QString &dirPath, const QRegularExpression &filter) {
+    QStringList names;
+
+    DIR *dir = opendir(QFile::encodeName(dirPath).constData());
+    if (dir == nullptr)
+        return names;
+
+    const bool filtered = !filter.pattern().isEmpty();
+
+    for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        const QString name = QFile::decodeName(entry->d_name);
+
+        if (name == "." || name == "..")
+            continue;
+
+        if (filtered && !filter.match(name).hasMatch())
+            continue;
+
+        names.append(name);
+    }
+
+    closedir(dir);
+
+    // same order as 'ls' used to give
+    names.sort();
+    return names;
+}
+
+QStringList SysfsEnumerator::drmCards() {
+    static const QRegularExpression rxCard("^card\\d+$");
+    return entries(globalStuff::systemPath("/sys/class/drm/"), rxCard);
+}
+
+QStringList SysfsEnumerator::hwmonDevices() {
+    static const QRegularExpression rxHwmon("^hwmon\\d+$");
+    return entries(globalStuff::systemPath("/sys/class/hwmon/"), rxHwmon);
+}
@@ -0,0 +1,34 @@
+#ifndef SYSFSENUMERATOR_H
+#define SYSFSENUMERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QRegularExpression>
+
+/**
+ * @brief The SysfsEnumerator class lists sysfs directories directly with opendir()/readdir(),
+ * instead of running 'ls' in a subprocess for every directory.
+ */
+class SysfsEnumerator
+{
+public:
+    /**
+     * @brief List entries of a directory, '.' and '..' are skipped.
+     * @param dirPath Directory to scan.
+     * @param filter Only names matching the expression are returned, all if the expression is empty.
+     * @return Sorted names (not full paths), empty list if directory can't be opened.
+     */
+    static QStringList entries(const QString &dirPath, const QRegularExpression &filter = QRegularExpression());
+
+    /**
+     * @brief DRM cards (card0, card1...), without connectors like card0-DP-1.
+     */
+    static QStringList drmCards();
+
+    /**
+     * @brief Hwmon devices registered in the system (hwmon0, hwmon1...).
+     */
+    static QStringList hwmonDevices();
+};
+
+#endif // SYSFSENUMERATOR_H
@@ -77,11 +77,12 @@ void radeon_profile::on_btn_ok_clicked()
         }
     }
 
-    int modIndex = -1;
+    int modIndex = -1, logCardIndex = -1;
 
     if (ui->list_execProfiles->selectedItems().count() != 0) {
         if (ui->list_execProfiles->currentItem()->text(PROFILE_NAME) == ui->txt_profileName->text()) {
             modIndex = ui->list_execProfiles->indexOfTopLevelItem(ui->list_execProfiles->currentItem());
+            logCardIndex = ui->list_execProfiles->currentItem()->data(LOG_FILE, Qt::UserRole).toInt();
             delete ui->list_execProfiles->currentItem();
         }
     }
@@ -93,6 +94,7 @@ void radeon_profile::on_btn_ok_clicked()
     item->setText(ENV_SETTINGS,ui->txt_summary->text());
     item->setText(LOG_FILE,ui->txt_logFile->text());
     item->setText(LOG_FILE_DATE_APPEND,((ui->cb_appendDateTime->isChecked()) ? "1" : "0"));
+    item->setData(LOG_FILE, Qt::UserRole, logCardIndex);
 
     if (modIndex == -1)
         ui->list_execProfiles->addTopLevelItem(item);
@@ -282,6 +284,7 @@ void radeon_profile::on_btn_runExecProfile_clicked()
     //  check if there will be log
     if (!item->text(LOG_FILE).isEmpty()) {
         exe->logEnabled = true;
+        exe->logCardIndex = item->data(LOG_FILE, Qt::UserRole).toInt();
         exe->setLogFilename(item->text(LOG_FILE) +
                             ((item->text(LOG_FILE_DATE_APPEND) == "1") ? QDateTime::currentDateTime().toString("_yyyy-MM-dd_hh-mm-ss") : ""));
         exe->appendToLog("Profile: " +item->text(PROFILE_NAME) +"; App: " + item->text(BINARY) + "; Params: " + item->text(BINARY_PARAMS) + "; Env: " + item->text(ENV_SETTINGS));
@@ -0,0 +1,312 @@
+#include "mockDaemon.h"
+#include "daemonComm.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <cstring>
+#include <time.h> // clock_gettime()
+
+MockDaemon::MockDaemon(Protocol daemonProtocol, QObject *parent) : QObject(parent),
+    client(nullptr),
+    protocol(daemonProtocol),
+    framed(false),
+    format(DaemonSharedMem::PAYLOAD_TEXT) {
+    connect(&server, SIGNAL(newConnection()), this, SLOT(acceptClient()));
+}
+
+MockDaemon::~MockDaemon() {
+    server.close();
+}
+
+bool MockDaemon::listen() {
+    static int instances = 0;
+    const QString name = QString("rp-mock-daemon-%1-%2").arg(QCoreApplication::applicationPid()).arg(++instances);
+
+    QLocalServer::removeServer(name);
+    return server.listen(name);
+}
+
+void MockDaemon::failRequest(quint32 requestId, int status, int failedIndex) {
+    failures.insert(requestId, qMakePair(status, failedIndex));
+}
+
+static qint64 monotonicTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void MockDaemon::publish(const QByteArray &pmInfo) {
+    if (!sharedMem.isAttached())
+        return;
+
+    DaemonSharedMem::write(sharedMem.data(), sharedMem.size(), pmInfo.constData(), pmInfo.size(), monotonicTime());
+    notifyDataReady();
+}
+
+bool MockDaemon::publish(DaemonClocksRecord record) {
+    if (!sharedMem.isAttached() || format != DaemonSharedMem::PAYLOAD_CLOCKS_RECORD)
+        return false;
+
+    record.timestamp = monotonicTime();
+
+    DaemonSharedMem::write(sharedMem.data(), sharedMem.size(), reinterpret_cast<const char *>(&record), sizeof(record),
+                           record.timestamp, DaemonSharedMem::PAYLOAD_CLOCKS_RECORD);
+    notifyDataReady();
+    return true;
+}
+
+void MockDaemon::notifyDataReady() {
+    if (framed)
+        sendFrame(DaemonCommand::DATA_READY, 0, QByteArray());
+    else
+        sendLegacy(QString(DAEMON_DATA_READY) + SEPARATOR);
+}
+
+void MockDaemon::requestConfirmation() {
+    if (framed)
+        sendFrame(DaemonCommand::ALIVE, 0, QByteArray());
+    else
+        sendLegacy("7#1#");
+}
+
+void MockDaemon::disconnectClient() {
+    if (client != nullptr)
+        client->disconnectFromServer();
+}
+
+void MockDaemon::acceptClient() {
+    QLocalSocket *next = server.nextPendingConnection();
+    if (next == nullptr)
+        return;
+
+    // one client at a time, as the daemon
+    if (client != nullptr)
+        client->deleteLater();
+
+    client = next;
+    framed = false;
+    buffer.clear();
+
+    connect(client, SIGNAL(readyRead()), this, SLOT(receive()));
+}
+
+void MockDaemon::receive() {
+    buffer.append(client->readAll());
+
+    if (!framed && protocol == FRAMED && buffer.startsWith(DAEMON_PROTOCOL_HELLO)) {
+        buffer.remove(0, static_cast<int>(strlen(DAEMON_PROTOCOL_HELLO)));
+        sendLegacy(DAEMON_PROTOCOL_HELLO);
+        framed = true;
+    }
+
+    if (framed)
+        receiveFrames();
+    else
+        receiveLegacy();
+}
+
+// number of arguments of legacy instructions, -1 for unknown tokens (skipped, as the hello by old daemons)
+static int legacyArguments(const QString &token, DaemonCommand::MessageType *type) {
+    if (token.length() != 1)
+        return -1;
+
+    switch (token.at(0).toLatin1()) {
+        case DAEMON_SIGNAL_CONFIG:
+            *type = DaemonCommand::CONFIG;
+            return 2;
+        case DAEMON_SIGNAL_READ_CLOCKS:
+            *type = DaemonCommand::READ_CLOCKS;
+            return 0;
+        case DAEMON_SIGNAL_SET_VALUE:
+            *type = DaemonCommand::SET_VALUE;
+            return 2;
+        case DAEMON_SIGNAL_TIMER_ON:
+            *type = DaemonCommand::TIMER_ON;
+            return 1;
+        case DAEMON_SIGNAL_TIMER_OFF:
+            *type = DaemonCommand::TIMER_OFF;
+            return 0;
+        case DAEMON_SHAREDMEM_KEY:
+        case DAEMON_SHAREDMEM_FORMAT:
+            *type = DaemonCommand::SHAREDMEM_KEY;
+            return 1;
+        case DAEMON_ALIVE:
+            *type = DaemonCommand::ALIVE;
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+void MockDaemon::receiveLegacy() {
+    // only tokens followed by a separator are complete
+    const int end = buffer.lastIndexOf(SEPARATOR);
+    if (end == -1)
+        return;
+
+    const QStringList tokens = QString::fromLatin1(buffer.left(end)).split(SEPARATOR);
+    int i = 0, consumed = 0;
+
+    while (i < tokens.count()) {
+        DaemonCommand::MessageType type;
+        const int argumentCount = legacyArguments(tokens.at(i), &type);
+
+        if (argumentCount == -1) {
+            consumed += tokens.at(i++).length() + 1;
+            continue;
+        }
+
+        // the rest of the instruction comes in the next read
+        if (i + argumentCount >= tokens.count())
+            break;
+
+        QStringList arguments = tokens.mid(i + 1, argumentCount);
+        const bool formatToken = tokens.at(i).at(0) == DAEMON_SHAREDMEM_FORMAT;
+
+        if (type == DaemonCommand::SET_VALUE)
+            arguments = QStringList() << arguments.at(1) << arguments.at(0);
+        else if (type == DaemonCommand::TIMER_ON)
+            arguments = QStringList() << QString::number(qRound(arguments.at(0).toDouble() * 1000));
+        else if (type == DaemonCommand::SHAREDMEM_KEY && !formatToken)
+            arguments << QString::number(DaemonSharedMem::PAYLOAD_TEXT);
+
+        for (int j = 0; j <= argumentCount; ++j)
+            consumed += tokens.at(i + j).length() + 1;
+
+        i += argumentCount + 1;
+
+        // "9#" changes the format of the key sent before it, unknown formats are ignored as by the daemon
+        if (formatToken) {
+            if (arguments.at(0) == DAEMON_FORMAT_CLOCKS_RECORD && !instructions.isEmpty()
+                    && instructions.last().type == DaemonCommand::SHAREDMEM_KEY) {
+                format = DaemonSharedMem::PAYLOAD_CLOCKS_RECORD;
+                instructions.last().arguments[1] = QString::number(format);
+            }
+
+            continue;
+        }
+
+        record(type, arguments, 0);
+    }
+
+    buffer.remove(0, consumed);
+}
+
+void MockDaemon::receiveFrames() {
+    quint8 type;
+    quint32 requestId;
+    QByteArray payload;
+
+    while (DaemonCommand::takeFrame(&buffer, &type, &requestId, &payload)) {
+        QDataStream stream(payload);
+        stream.setVersion(QDataStream::Qt_5_7);
+
+        if (type == DaemonCommand::BATCH) {
+            quint32 count;
+            stream >> count;
+
+            for (quint32 i = 0; i < count; ++i) {
+                quint8 instructionType;
+                stream >> instructionType;
+                decodeInstruction(instructionType, stream, requestId);
+            }
+        } else
+            decodeInstruction(type, stream, requestId);
+
+        const QPair<int, int> failure = failures.take(requestId);
+
+        QByteArray status;
+        QDataStream statusStream(&status, QIODevice::WriteOnly);
+        statusStream.setVersion(QDataStream::Qt_5_7);
+        statusStream << qint32(failure.first) << qint32(failure.first == 0 ? -1 : failure.second);
+
+        sendFrame(DaemonCommand::STATUS, requestId, status);
+    }
+}
+
+void MockDaemon::decodeInstruction(quint8 type, QDataStream &stream, quint32 requestId) {
+    QStringList arguments;
+
+    switch (type) {
+        case DaemonCommand::CONFIG:
+        case DaemonCommand::SET_VALUE: {
+            QString first, second;
+            stream >> first >> second;
+            arguments << first << second;
+            break;
+        }
+        case DaemonCommand::TIMER_ON: {
+            quint32 msec;
+            stream >> msec;
+            arguments << QString::number(msec);
+            break;
+        }
+        case DaemonCommand::SHAREDMEM_KEY: {
+            QString key;
+            quint8 format;
+            stream >> key >> format;
+            arguments << key << QString::number(format);
+            break;
+        }
+        case DaemonCommand::ALIVE: {
+            bool confirmationRequired;
+            stream >> confirmationRequired;
+            arguments << QString::number(confirmationRequired);
+            break;
+        }
+        default:
+            break;
+    }
+
+    record(static_cast<DaemonCommand::MessageType>(type), arguments, requestId);
+}
+
+void MockDaemon::record(DaemonCommand::MessageType type, const QStringList &arguments, quint32 requestId) {
+    // the client creates the block, the daemon attaches to it
+    if (type == DaemonCommand::SHAREDMEM_KEY) {
+        sharedMem.detach();
+        sharedMem.setKey(arguments.at(0));
+        format = static_cast<DaemonSharedMem::PayloadFormat>(arguments.at(1).toInt());
+
+        if (!sharedMem.attach())
+            qWarning() << "Mock daemon can't attach to the shared memory" << arguments.at(0);
+    }
+
+    Instruction instruction;
+    instruction.type = type;
+    instruction.arguments = arguments;
+    instruction.requestId = requestId;
+
+    instructions.append(instruction);
+    emit instructionReceived();
+}
+
+void MockDaemon::sendLegacy(const QString &message) {
+    if (client == nullptr)
+        return;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_7);
+    stream << message;
+
+    client->write(data);
+}
+
+void MockDaemon::sendFrame(quint8 type, quint32 requestId, const QByteArray &payload) {
+    if (client == nullptr)
+        return;
+
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_7);
+
+    // length of what follows it: version, type, request id, payload
+    stream << quint32(2 * sizeof(quint8) + sizeof(quint32) + payload.size()) << quint8(DAEMON_PROTOCOL_VERSION)
+           << type << requestId;
+
+    client->write(frame + payload);
+}
@@ -0,0 +1,132 @@
+#ifndef MOCKDAEMON_H
+#define MOCKDAEMON_H
+
+#include "daemonCommand.h"
+#include "daemonSharedMem.h"
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+
+/**
+ * @brief The MockDaemon class is a radeon-profile-daemon on a QLocalServer for tests of DaemonComm,
+ * it records the instructions it gets and answers as the real daemon does.
+ * A LEGACY daemon knows only the '#' separated text and ignores the hello, so the client stays with it.
+ * A FRAMED daemon answers the hello and then replies to every frame with STATUS.
+ * As the daemon, it attaches to the shared memory of the key it gets and writes pm_info there, or the clocks record
+ * if the client asked for it ("9#record#" after the key or the format in the SHAREDMEM_KEY frame), see publish().
+ */
+class MockDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Protocol {
+        LEGACY,
+        FRAMED
+    };
+
+    struct Instruction {
+        DaemonCommand::MessageType type;
+        QStringList arguments;  // as text, in the order of DaemonCommand (SET_VALUE is file, value, SHAREDMEM_KEY is key, format)
+        quint32 requestId;  // 0 for legacy
+    };
+
+    explicit MockDaemon(Protocol daemonProtocol, QObject *parent = 0);
+    ~MockDaemon();
+
+    /**
+     * @brief Listen on a server name unique to the process, see serverName().
+     * @return Success.
+     */
+    bool listen();
+
+    QString serverName() const {
+        return server.serverName();
+    }
+
+    bool isClientConnected() const {
+        return client != nullptr && client->state() == QLocalSocket::ConnectedState;
+    }
+
+    // hello was answered, the client sends frames
+    bool isFramed() const {
+        return framed;
+    }
+
+    const QVector<Instruction>& received() const {
+        return instructions;
+    }
+
+    void clearReceived() {
+        instructions.clear();
+    }
+
+    /**
+     * @brief Reply to the request with an error instead of success, as if its instruction failed.
+     * @param requestId Id of the request.
+     * @param status errno of the failed instruction.
+     * @param failedIndex Index of the failed instruction in the request.
+     */
+    void failRequest(quint32 requestId, int status, int failedIndex);
+
+    bool isSharedMemoryAttached() const {
+        return sharedMem.isAttached();
+    }
+
+    // format of the shared memory payload the client asked for
+    DaemonSharedMem::PayloadFormat requestedFormat() const {
+        return format;
+    }
+
+    /**
+     * @brief Write pm_info to the shared memory as a daemon read of it and tell the client, "8#" or a DATA_READY frame.
+     * Written as text whatever the client asked for, as by daemons which can't parse pm_info.
+     * @param pmInfo Content of pm_info.
+     */
+    void publish(const QByteArray &pmInfo);
+
+    /**
+     * @brief Write clocks parsed from pm_info to the shared memory and tell the client, as publish() of the text.
+     * @param record Clocks, its timestamp is set to now.
+     * @return False if the client didn't ask for records or the shared memory isn't attached, nothing is written then.
+     */
+    bool publish(DaemonClocksRecord record);
+
+    // ask the client to confirm the connection, "7#1#" or an ALIVE frame
+    void requestConfirmation();
+
+    void disconnectClient();
+
+signals:
+    void instructionReceived();
+
+private slots:
+    void acceptClient();
+    void receive();
+
+private:
+    QLocalServer server;
+    QLocalSocket *client;
+    Protocol protocol;
+    bool framed;
+    QByteArray buffer;
+    QVector<Instruction> instructions;
+    QHash<quint32, QPair<int, int> > failures;
+    QSharedMemory sharedMem;
+    DaemonSharedMem::PayloadFormat format;
+
+    void receiveLegacy();
+    void receiveFrames();
+    void decodeInstruction(quint8 type, QDataStream &stream, quint32 requestId);
+    void record(DaemonCommand::MessageType type, const QStringList &arguments, quint32 requestId);
+    void notifyDataReady();
+    void sendLegacy(const QString &message);
+    void sendFrame(quint8 type, quint32 requestId, const QByteArray &payload);
+};
+
+#endif // MOCKDAEMON_H
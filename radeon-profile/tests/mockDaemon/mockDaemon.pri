@@ -0,0 +1,8 @@
+# in-process radeon-profile-daemon for tests of the daemon protocols, needs daemonCommand.cpp
+QT += network
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/mockDaemon.cpp
+
+HEADERS += $$PWD/mockDaemon.h
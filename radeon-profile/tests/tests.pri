@@ -0,0 +1,14 @@
+# common settings of the unit tests, sources of the app are taken from ..
+
+QT += testlib
+QT -= gui
+
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -std=c++11
+
+# RPValue counts the values it formats, see RPValue::formatCount()
+DEFINES += RP_FORMAT_COUNTER
+
+INCLUDEPATH += $$PWD/..
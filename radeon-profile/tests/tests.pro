@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# unit tests, run: qmake && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += tst_pmInfoParser \
+    tst_busySampler \
+    tst_ioctlHandler \
+    tst_gpu \
+    tst_daemonSharedMem \
+    tst_daemonComm \
+    tst_timeSeriesStore \
+    tst_seriesDecimator \
+    tst_historyFile \
+    tst_samplerThread \
+    tst_hwmonSensor
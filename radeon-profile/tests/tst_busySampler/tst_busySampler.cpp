@@ -0,0 +1,110 @@
+#include "busySampler.h"
+
+#include <QtTest>
+#include <atomic>
+
+// 1000 Hz over 100 mS, ring of 100 samples
+#define TEST_FREQUENCY 1000
+#define TEST_WINDOW 100
+#define TEST_RING_SIZE 100
+
+/**
+ * @brief Tests of BusySampler with a probe replaying a known duty cycle instead of the radeon status register.
+ */
+class BusySamplerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // active every "period"-th sample, so any full window has exactly 100 / period % busy
+    static BusySampler::Probe dutyCycleProbe(std::atomic<int> *calls, int period) {
+        return [calls, period](bool *active) {
+            *active = (calls->fetch_add(1) % period) == period - 1;
+            return true;
+        };
+    }
+
+private slots:
+    void dutyCycle_data() {
+        QTest::addColumn<int>("period");
+        QTest::addColumn<float>("usage");
+
+        QTest::newRow("idle") << 1000000 << 0.0f;
+        QTest::newRow("25%") << 4 << 25.0f;
+        QTest::newRow("50%") << 2 << 50.0f;
+        QTest::newRow("full") << 1 << 100.0f;
+    }
+
+    void dutyCycle() {
+        QFETCH(int, period);
+        QFETCH(float, usage);
+
+        std::atomic<int> calls(0);
+        BusySampler sampler(dutyCycleProbe(&calls, period), TEST_FREQUENCY, TEST_WINDOW);
+
+        float value;
+        QVERIFY(!sampler.getUsage(&value));
+
+        sampler.start();
+
+        // window is published after the sample, one more call means the ring is full
+        QTRY_VERIFY(calls > TEST_RING_SIZE + 1);
+        QVERIFY(sampler.getUsage(&value));
+        QVERIFY2(qAbs(value - usage) < 0.01f, qPrintable(QString::number(value)));
+
+        sampler.stop();
+    }
+
+    void stopDropsSamplesAndPolling() {
+        std::atomic<int> calls(0);
+        BusySampler sampler(dutyCycleProbe(&calls, 2), TEST_FREQUENCY, TEST_WINDOW);
+
+        sampler.start();
+        QTRY_VERIFY(calls > 10);
+
+        sampler.stop();
+        const int callsAtStop = calls;
+
+        float value;
+        QVERIFY(!sampler.getUsage(&value));
+
+        QTest::qWait(50);
+        QCOMPARE(calls.load(), callsAtStop);
+    }
+
+    void restart() {
+        std::atomic<int> calls(0);
+        BusySampler sampler(dutyCycleProbe(&calls, 4), TEST_FREQUENCY, TEST_WINDOW);
+
+        sampler.start();
+        QTRY_VERIFY(calls > 10);
+        sampler.stop();
+
+        const int callsAtStop = calls;
+        sampler.start();
+        QTRY_VERIFY(calls > callsAtStop + TEST_RING_SIZE + 1);
+
+        float value;
+        QVERIFY(sampler.getUsage(&value));
+        QCOMPARE(value, 25.0f);
+
+        sampler.stop();
+    }
+
+    void probeFailure() {
+        std::atomic<int> calls(0);
+        BusySampler sampler([&calls](bool *active) {
+            *active = true;
+            return calls.fetch_add(1) < 20;
+        }, TEST_FREQUENCY, TEST_WINDOW);
+
+        sampler.start();
+        QTRY_VERIFY(sampler.isFinished());
+
+        float value;
+        QVERIFY(!sampler.getUsage(&value));
+    }
+};
+
+QTEST_GUILESS_MAIN(BusySamplerTest)
+#include "tst_busySampler.moc"
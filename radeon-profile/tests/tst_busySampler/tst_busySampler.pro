@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_busySampler
+
+SOURCES += tst_busySampler.cpp \
+    ../../busySampler.cpp
+
+HEADERS += ../../busySampler.h
@@ -0,0 +1,160 @@
+#include "daemonComm.h"
+#include "mockDaemon.h"
+
+#include <QtTest>
+#include <cerrno>
+
+Q_DECLARE_METATYPE(MockDaemon::Protocol)
+
+/**
+ * @brief Tests of DaemonComm against MockDaemon, with the framed protocol and with an old daemon.
+ */
+class DaemonCommTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct Reply {
+        quint32 requestId;
+        int status;
+    };
+
+private slots:
+    void oldDaemonFallback() {
+        MockDaemon daemon(MockDaemon::LEGACY);
+        QVERIFY(daemon.listen());
+
+        DaemonComm comm;
+        QVector<Reply> replies;
+        connect(&comm, &DaemonComm::commandFinished, [&replies](quint32 requestId, int status) {
+            replies.append({ requestId, status });
+        });
+
+        comm.connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(comm.isConnected());
+        QTRY_VERIFY(daemon.isClientConnected());
+
+        const quint32 requestId = comm.sendCommand(DaemonCommand().config("pm_info", "/sys/kernel/debug/dri/0/amdgpu_pm_info")
+                                                   .setValue("/sys/class/drm/card0/device/power_dpm_state", "battery")
+                                                   .readClocks());
+        QCOMPARE(requestId, 0u);
+
+        QTRY_COMPARE(daemon.received().count(), 3);
+        QVERIFY(!comm.isFramed());
+        QVERIFY(!daemon.isFramed());
+
+        const QVector<MockDaemon::Instruction> &received = daemon.received();
+        QCOMPARE(received.at(0).type, DaemonCommand::CONFIG);
+        QCOMPARE(received.at(0).arguments, QStringList() << "pm_info" << "/sys/kernel/debug/dri/0/amdgpu_pm_info");
+        QCOMPARE(received.at(1).type, DaemonCommand::SET_VALUE);
+        QCOMPARE(received.at(1).arguments, QStringList() << "/sys/class/drm/card0/device/power_dpm_state" << "battery");
+        QCOMPARE(received.at(2).type, DaemonCommand::READ_CLOCKS);
+
+        // an old daemon doesn't reply
+        QTest::qWait(100);
+        QVERIFY(replies.isEmpty());
+    }
+
+    void framedHandshake() {
+        MockDaemon daemon(MockDaemon::FRAMED);
+        QVERIFY(daemon.listen());
+
+        DaemonComm comm;
+        comm.connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(comm.isFramed());
+        QVERIFY(daemon.isFramed());
+
+        // the hello is not an instruction
+        QVERIFY(daemon.received().isEmpty());
+    }
+
+    void requestIdMatching() {
+        MockDaemon daemon(MockDaemon::FRAMED);
+        QVERIFY(daemon.listen());
+
+        DaemonComm comm;
+        QVector<Reply> replies;
+        connect(&comm, &DaemonComm::commandFinished, [&replies](quint32 requestId, int status) {
+            replies.append({ requestId, status });
+        });
+
+        comm.connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(comm.isFramed());
+
+        const quint32 first = comm.sendCommand(DaemonCommand().setValue("/sys/class/drm/card0/device/power_dpm_state", "battery"));
+        const quint32 second = comm.sendCommand(DaemonCommand().setValue("/sys/class/drm/card0/device/hwmon/hwmon0/pwm1_enable", "1")
+                                                .setValue("/sys/class/drm/card0/device/hwmon/hwmon0/pwm1", "128"));
+        const quint32 third = comm.sendCommand(DaemonCommand().readClocks());
+
+        QVERIFY(first != 0);
+        QVERIFY(second != first && second != 0);
+        QVERIFY(third != second && third != first && third != 0);
+
+        // the second instruction of the batch fails
+        daemon.failRequest(second, EACCES, 1);
+
+        QTRY_COMPARE(replies.count(), 3);
+        QCOMPARE(replies.at(0).requestId, first);
+        QCOMPARE(replies.at(0).status, 0);
+        QCOMPARE(replies.at(1).requestId, second);
+        QCOMPARE(replies.at(1).status, EACCES);
+        QCOMPARE(replies.at(2).requestId, third);
+        QCOMPARE(replies.at(2).status, 0);
+
+        const QVector<MockDaemon::Instruction> &received = daemon.received();
+        QCOMPARE(received.count(), 4);
+        QCOMPARE(received.at(0).requestId, first);
+        QCOMPARE(received.at(1).requestId, second);
+        QCOMPARE(received.at(1).arguments, QStringList() << "/sys/class/drm/card0/device/hwmon/hwmon0/pwm1_enable" << "1");
+        QCOMPARE(received.at(2).requestId, second);
+        QCOMPARE(received.at(2).arguments, QStringList() << "/sys/class/drm/card0/device/hwmon/hwmon0/pwm1" << "128");
+        QCOMPARE(received.at(3).type, DaemonCommand::READ_CLOCKS);
+        QCOMPARE(received.at(3).requestId, third);
+    }
+
+    void connectionConfirmation_data() {
+        QTest::addColumn<MockDaemon::Protocol>("protocol");
+
+        QTest::newRow("legacy") << MockDaemon::LEGACY;
+        QTest::newRow("framed") << MockDaemon::FRAMED;
+    }
+
+    void connectionConfirmation() {
+        QFETCH(MockDaemon::Protocol, protocol);
+
+        MockDaemon daemon(protocol);
+        QVERIFY(daemon.listen());
+
+        DaemonComm comm;
+        comm.connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(daemon.isClientConnected());
+
+        if (protocol == MockDaemon::FRAMED)
+            QTRY_VERIFY(comm.isFramed());
+
+        daemon.requestConfirmation();
+
+        QTRY_COMPARE(daemon.received().count(), 1);
+        QCOMPARE(daemon.received().at(0).type, DaemonCommand::ALIVE);
+        QCOMPARE(daemon.received().at(0).arguments, QStringList() << "1");
+    }
+
+    void reconnectStartsLegacy() {
+        MockDaemon daemon(MockDaemon::FRAMED);
+        QVERIFY(daemon.listen());
+
+        DaemonComm comm;
+        comm.connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(comm.isFramed());
+
+        daemon.disconnectClient();
+        QTRY_VERIFY(!comm.isConnected());
+        QVERIFY(!comm.isFramed());
+
+        comm.connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(comm.isFramed());
+    }
+};
+
+QTEST_GUILESS_MAIN(DaemonCommTest)
+#include "tst_daemonComm.moc"
@@ -0,0 +1,13 @@
+include(../tests.pri)
+include(../mockDaemon/mockDaemon.pri)
+
+TARGET = tst_daemonComm
+
+SOURCES += tst_daemonComm.cpp \
+    ../../daemonComm.cpp \
+    ../../daemonCommand.cpp \
+    ../../daemonSharedMem.cpp
+
+HEADERS += ../../daemonComm.h \
+    ../../daemonCommand.h \
+    ../../daemonSharedMem.h
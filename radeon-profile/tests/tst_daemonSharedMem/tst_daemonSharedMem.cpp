@@ -0,0 +1,164 @@
+#include "daemonSharedMem.h"
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <cstring>
+#include <sys/mman.h> // mmap()
+#include <sys/wait.h> // waitpid()
+#include <unistd.h> // fork()
+
+// as SHARED_MEM_SIZE in dxorg.h
+#define BLOCK_SIZE 4096
+#define STRESS_DURATION 1000
+
+/**
+ * @brief Tests of the seqlock shared memory block, the stress test writes from a forked process
+ * as the daemon does and checks that no read is torn.
+ */
+class DaemonSharedMemTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // the payload of write n is derived from n only, so the reader can check a copy against its timestamp
+    static int payloadLength(qint64 n) {
+        return 1 + static_cast<int>(n % 4000);
+    }
+
+    static char payloadByte(qint64 n, int i) {
+        return 'A' + static_cast<char>((n + i) % 26);
+    }
+
+    static void fillPayload(qint64 n, char *data) {
+        const int length = payloadLength(n);
+        for (int i = 0; i < length; ++i)
+            data[i] = payloadByte(n, i);
+    }
+
+    static bool isConsistent(qint64 n, const char *data, int length) {
+        if (length != payloadLength(n))
+            return false;
+
+        for (int i = 0; i < length; ++i) {
+            if (data[i] != payloadByte(n, i))
+                return false;
+        }
+
+        return true;
+    }
+
+private slots:
+    void emptyBlock() {
+        char block[BLOCK_SIZE] = {}, buffer[BLOCK_SIZE];
+        qint64 timestamp;
+        DaemonSharedMem::PayloadFormat format;
+
+        QVERIFY(!DaemonSharedMem::hasHeader(block));
+        QCOMPARE(DaemonSharedMem::read(block, sizeof(block), buffer, sizeof(buffer), &timestamp, &format), -1);
+    }
+
+    void writeAndRead() {
+        char block[BLOCK_SIZE] = {}, buffer[BLOCK_SIZE];
+        qint64 timestamp;
+        DaemonSharedMem::PayloadFormat format;
+
+        const char text[] = "power level 0    sclk: 30000 mclk: 15000\n";
+        DaemonSharedMem::write(block, sizeof(block), text, sizeof(text) - 1, 42);
+
+        QVERIFY(DaemonSharedMem::hasHeader(block));
+        QCOMPARE(DaemonSharedMem::read(block, sizeof(block), buffer, sizeof(buffer), &timestamp, &format),
+                 static_cast<int>(sizeof(text) - 2));
+        QCOMPARE(QString(buffer), QString("power level 0    sclk: 30000 mclk: 15000"));
+        QCOMPARE(timestamp, 42LL);
+        QCOMPARE(format, DaemonSharedMem::PAYLOAD_TEXT);
+
+        // cut to the buffer, still terminated
+        char small[8];
+        QCOMPARE(DaemonSharedMem::read(block, sizeof(block), small, sizeof(small), &timestamp, &format), 7);
+        QCOMPARE(QString(small), QString("power l"));
+    }
+
+    // a header with a length past the block comes from a broken writer, nothing of it is used
+    void lengthPastBlock_data() {
+        QTest::addColumn<quint32>("length");
+
+        QTest::newRow("one past the block") << static_cast<quint32>(BLOCK_SIZE - sizeof(DaemonSharedMemHeader) + 1);
+        QTest::newRow("negative as int") << 0x80000010u;
+        QTest::newRow("max") << 0xffffffffu;
+    }
+
+    void lengthPastBlock() {
+        QFETCH(quint32, length);
+
+        char block[BLOCK_SIZE] = {}, buffer[BLOCK_SIZE];
+        qint64 timestamp;
+        DaemonSharedMem::PayloadFormat format;
+
+        DaemonSharedMem::write(block, sizeof(block), "sclk: 30000", 11, 1);
+        reinterpret_cast<DaemonSharedMemHeader*>(block)->length.store(length);
+
+        QCOMPARE(DaemonSharedMem::read(block, sizeof(block), buffer, sizeof(buffer), &timestamp, &format), -1);
+    }
+
+    void tornReads() {
+        // the block and a stop flag, shared with the writer process
+        void *mapping = mmap(nullptr, BLOCK_SIZE + sizeof(std::atomic<int>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        QVERIFY(mapping != MAP_FAILED);
+
+        memset(mapping, 0, BLOCK_SIZE);
+        char *block = static_cast<char*>(mapping);
+        std::atomic<int> *stop = new (block + BLOCK_SIZE) std::atomic<int>(0);
+
+        const pid_t writer = fork();
+        QVERIFY(writer >= 0);
+
+        if (writer == 0) {
+            char data[BLOCK_SIZE];
+            for (qint64 n = 1; !stop->load(); ++n) {
+                fillPayload(n, data);
+                DaemonSharedMem::write(block, BLOCK_SIZE, data, payloadLength(n), n);
+            }
+
+            _exit(0);
+        }
+
+        int reads = 0, torn = 0;
+        qint64 last = 0;
+        bool ordered = true;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        while (timer.elapsed() < STRESS_DURATION) {
+            char buffer[BLOCK_SIZE];
+            qint64 n;
+            DaemonSharedMem::PayloadFormat format;
+
+            const int length = DaemonSharedMem::read(block, BLOCK_SIZE, buffer, sizeof(buffer), &n, &format);
+            if (length == -1)
+                continue;
+
+            ++reads;
+            if (!isConsistent(n, buffer, length))
+                ++torn;
+
+            ordered &= n >= last;
+            last = n;
+        }
+
+        stop->store(1);
+
+        int status;
+        QCOMPARE(waitpid(writer, &status, 0), writer);
+        munmap(mapping, BLOCK_SIZE + sizeof(std::atomic<int>));
+
+        QVERIFY(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        QVERIFY(reads > 0);
+        QVERIFY2(last > 1, "the writer made no progress");
+        QCOMPARE(torn, 0);
+        QVERIFY(ordered);
+    }
+};
+
+QTEST_GUILESS_MAIN(DaemonSharedMemTest)
+#include "tst_daemonSharedMem.moc"
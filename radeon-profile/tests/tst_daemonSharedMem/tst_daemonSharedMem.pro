@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_daemonSharedMem
+
+SOURCES += tst_daemonSharedMem.cpp \
+    ../../daemonSharedMem.cpp
+
+HEADERS += ../../daemonSharedMem.h
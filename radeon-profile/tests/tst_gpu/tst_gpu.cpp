@@ -0,0 +1,542 @@
+#include "gpu.h"
+#include "ioctlBackend.h"
+#include "daemonComm.h"
+#include "mockDaemon.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+#include <cerrno>
+#include <thread>
+
+Q_DECLARE_METATYPE(MockDaemon::Protocol)
+
+/**
+ * @brief Tests of gpu with two cards, on the sysfs tree in data/root (amdgpu cards with temperature only).
+ * No /dev/dri there, so without the daemon handlers are configured right away and only read sysfs,
+ * with daemon data (from MockDaemon) the clocks of the card the daemon reads come from the shared memory,
+ * as pm_info text or as the record the daemon parsed. Card 0 has a fan (pwm1), writes to it go to the daemon when
+ * one is connected.
+ * Trees of single real cards are in data/radeonDpm (radeon, DPM, clocks in debugfs pm_info) and data/vega20
+ * (amdgpu, clocks in debugfs pm_info, OC table with OD_VDDC_CURVE, fan, power cap).
+ */
+class GpuTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // every ioctl fails, even if the host has a card
+    ReplayIoctlBackend noIoctl;
+
+    // handlers probe attributes by opening them for writing, which truncates regular files,
+    // so every test runs on a fresh copy of data/root
+    QTemporaryDir root;
+    QString data;
+
+    static bool copyTree(const QString &from, const QString &to) {
+        if (!QDir().mkpath(to))
+            return false;
+
+        for (const QString &entry : QDir(from).entryList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot)) {
+            const QString source = from + "/" + entry, target = to + "/" + entry;
+
+            if (QFileInfo(source).isDir() ? !copyTree(source, target) : !QFile::copy(source, target))
+                return false;
+        }
+
+        return true;
+    }
+
+    static float temperature(const GPUDataContainer &data) {
+        return data.value(ValueID::TEMPERATURE_CURRENT).value;
+    }
+
+    // tests of a whole card tree run on it instead of data/root
+    bool useTree(const QString &name) {
+        const QString tree = QFINDTESTDATA("data/" + name);
+
+        return !tree.isEmpty() && QDir(root.filePath("root")).removeRecursively() && copyTree(tree, root.filePath("root"));
+    }
+
+    static bool writeFile(const QString &path, const QByteArray &content) {
+        QFile f(path);
+        return f.open(QIODevice::WriteOnly) && f.write(content) == content.size();
+    }
+
+    // at least one tick of the sampler thread, read as the gui does it
+    static bool sampleOnce(gpu &device) {
+        QSignalSpy spy(&device, SIGNAL(dataReady()));
+        device.setSamplingInterval(20);
+        device.startSampling();
+
+        const bool ticked = spy.wait();
+        device.stopSampling();
+
+        return ticked && device.readLatestSnapshot();
+    }
+
+    static QByteArray pmInfo() {
+        return "GFX Clocks and Power:\n\t1750 MHz (MCLK)\n\t1340 MHz (SCLK)\n\t1050 mV (VDDGFX)\n";
+    }
+
+public:
+    GpuTest() : noIoctl(QDir::tempPath() + "/rp-no-such-recording.ioctl") { }
+
+private slots:
+    void initTestCase() {
+        data = QFINDTESTDATA("data/root");
+        QVERIFY(!data.isEmpty());
+        QVERIFY(root.isValid());
+
+        globalStuff::setSystemRoot(root.filePath("root"));
+        IoctlBackend::setDefaultBackend(&noIoctl);
+    }
+
+    void init() {
+        QVERIFY(QDir(root.filePath("root")).removeRecursively());
+        QVERIFY(copyTree(data, root.filePath("root")));
+    }
+
+    void cleanupTestCase() {
+        IoctlBackend::setDefaultBackend(nullptr);
+        globalStuff::setSystemRoot(QString());
+    }
+
+    void allCardsMonitored() {
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        QVERIFY(!device.isInitializationPending());
+
+        QCOMPARE(device.gpuList.count(), 2);
+        QCOMPARE(device.cardsData.count(), 2);
+        QCOMPARE(device.cardsHistory.count(), 2);
+
+        QCOMPARE(temperature(device.cardData(0)), 45.0f);
+        QCOMPARE(temperature(device.cardData(1)), 61.0f);
+        QCOMPARE(temperature(device.gpuData), 45.0f);
+    }
+
+    void radeonDpmTree() {
+        QVERIFY(useTree("radeonDpm"));
+
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        QVERIFY(device.readLatestSnapshot());
+
+        QCOMPARE(device.gpuList.count(), 1);
+        QCOMPARE(device.gpuList.at(0).module, DriverModule::RADEON);
+
+        const DriverFeatures &features = device.getDriverFeatures();
+        QCOMPARE(features.currentPowerMethod, PowerMethod::DPM);
+        QCOMPARE(features.clocksDataSource, ClocksDataSource::PM_FILE);
+        QCOMPARE(features.currentTemperatureSensor, TemperatureSensor::CARD_HWMON);
+        QVERIFY(features.isFanControlAvailable);
+        QVERIFY(!features.isOcTableAvailable);
+        QVERIFY(!features.isPowerCapAvailable);
+        QCOMPARE(device.getGpuConstParams().temp1_crit, 120);
+        QCOMPARE(device.getGpuConstParams().pwmMaxSpeed, 255);
+
+        QCOMPARE(device.gpuData.value(ValueID::CLK_CORE).value, 300.0f);
+        QCOMPARE(device.gpuData.value(ValueID::VOLT_MEM).value, 850.0f);
+        QCOMPARE(device.gpuData.value(ValueID::POWER_LEVEL).value, 0.0f);
+        QCOMPARE(temperature(device.gpuData), 48.0f);
+        QVERIFY(qAbs(device.gpuData.value(ValueID::FAN_SPEED_PERCENT).value - 25.1f) < 0.1f);
+
+        // card under load
+        const QString device0 = globalStuff::systemPath("/sys/class/drm/card0/device/");
+        QVERIFY(writeFile(globalStuff::systemPath("/sys/kernel/debug/dri/0/radeon_pm_info"),
+                          "uvd    vclk: 0 dclk: 0\npower level 2    sclk: 91550 mclk: 125000 vddc: 1175 vddci: 1000\n"));
+        QVERIFY(writeFile(device0 + "hwmon/hwmon0/temp1_input", "63000\n"));
+        QVERIFY(writeFile(device0 + "hwmon/hwmon0/pwm1", "128\n"));
+
+        QVERIFY(sampleOnce(device));
+
+        QCOMPARE(device.gpuData.value(ValueID::CLK_CORE).value, 915.0f);
+        QCOMPARE(device.gpuData.value(ValueID::CLK_MEM).value, 1250.0f);
+        QCOMPARE(device.gpuData.value(ValueID::VOLT_CORE).value, 1175.0f);
+        QCOMPARE(device.gpuData.value(ValueID::POWER_LEVEL).value, 2.0f);
+        QCOMPARE(temperature(device.gpuData), 63.0f);
+        QCOMPARE(device.gpuData.value(ValueID::TEMPERATURE_MIN).value, 48.0f);
+        QVERIFY(qAbs(device.gpuData.value(ValueID::FAN_SPEED_PERCENT).value - 50.2f) < 0.1f);
+        QVERIFY(device.cardsHistory.at(0).tier(TimeSeriesHistory::RAW).count() >= 2);
+    }
+
+    void vega20Tree() {
+        QVERIFY(useTree("vega20"));
+
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        QVERIFY(device.readLatestSnapshot());
+
+        QCOMPARE(device.gpuList.count(), 1);
+        QCOMPARE(device.gpuList.at(0).module, DriverModule::AMDGPU);
+
+        const DriverFeatures &features = device.getDriverFeatures();
+        QCOMPARE(features.currentPowerMethod, PowerMethod::DPM);
+        QCOMPARE(features.clocksDataSource, ClocksDataSource::PM_FILE);
+        QCOMPARE(features.currentTemperatureSensor, TemperatureSensor::CARD_HWMON);
+        QVERIFY(features.isFanControlAvailable);
+        QVERIFY(features.isPowerCapAvailable);
+        QCOMPARE(features.sclkTable, QStringList() << "0: 808Mhz" << "1: 1350Mhz" << "2: 1801Mhz");
+        QCOMPARE(features.mclkTable.count(), 2);
+
+        // Vega20 has one voltage curve instead of a table per state
+        QVERIFY(features.isOcTableAvailable);
+        QVERIFY(features.isVDDCCurveAvailable);
+        QCOMPARE(features.currentStatesTables.count(), 1);
+
+        const FVTable curve = features.currentStatesTables.value(OD_VDDC_CURVE);
+        QCOMPARE(curve.count(), 3);
+        QCOMPARE(curve.value(1).frequency, 1304u);
+        QCOMPARE(curve.value(1).voltage, 827u);
+        QCOMPARE(features.ocRages.value(OD_SCLK).min, 808u);
+        QCOMPARE(features.ocRages.value(OD_SCLK).max, 1801u);
+        QCOMPARE(features.ocRages.value(OD_MCLK).max, 1001u);
+        QCOMPARE(features.ocRages.value("VDDC_CURVE_VOLT[2]").max, 1218u);
+
+        const GPUConstParams &params = device.getGpuConstParams();
+        QCOMPARE(params.temp1_crit, 94);
+        QCOMPARE(params.power1_cap_max, 300);
+
+        QCOMPARE(device.gpuData.value(ValueID::CLK_CORE).value, 1340.0f);
+        QCOMPARE(device.gpuData.value(ValueID::CLK_MEM).value, 1750.0f);
+        QCOMPARE(device.gpuData.value(ValueID::GPU_USAGE_PERCENT).value, 37.0f);
+        QCOMPARE(device.gpuData.value(ValueID::FAN_SPEED_RPM).value, 1480.0f);
+        QCOMPARE(device.gpuData.value(ValueID::POWER_CAP_SELECTED).value, 250.0f);
+        QCOMPARE(device.gpuData.value(ValueID::POWER_CAP_AVERAGE).value, 45.0f);
+        QCOMPARE(temperature(device.gpuData), 52.0f);
+
+        // card going idle
+        const QString hwmon = globalStuff::systemPath("/sys/class/drm/card0/device/hwmon/hwmon2/");
+        QVERIFY(writeFile(globalStuff::systemPath("/sys/kernel/debug/dri/0/amdgpu_pm_info"),
+                          "GFX Clocks and Power:\n\t351 MHz (MCLK)\n\t808 MHz (SCLK)\n\t737 mV (VDDGFX)\n"));
+        QVERIFY(writeFile(globalStuff::systemPath("/sys/class/drm/card0/device/gpu_busy_percent"), "0\n"));
+        QVERIFY(writeFile(hwmon + "temp1_input", "41000\n"));
+        QVERIFY(writeFile(hwmon + "fan1_input", "0\n"));
+        QVERIFY(writeFile(hwmon + "power1_average", "9000000\n"));
+
+        QVERIFY(sampleOnce(device));
+
+        QCOMPARE(device.gpuData.value(ValueID::CLK_CORE).value, 808.0f);
+        QCOMPARE(device.gpuData.value(ValueID::CLK_MEM).value, 351.0f);
+        QCOMPARE(device.gpuData.value(ValueID::GPU_USAGE_PERCENT).value, 0.0f);
+        QCOMPARE(device.gpuData.value(ValueID::FAN_SPEED_RPM).value, 0.0f);
+        QCOMPARE(device.gpuData.value(ValueID::POWER_CAP_AVERAGE).value, 9.0f);
+        QCOMPARE(temperature(device.gpuData), 41.0f);
+        QCOMPARE(device.gpuData.value(ValueID::TEMPERATURE_MAX).value, 52.0f);
+        QVERIFY(device.cardsHistory.at(0).tier(TimeSeriesHistory::RAW).count() >= 2);
+    }
+
+    // changing the card must not take the snapshot, it would be missing in the history of all cards
+    void changeGpuKeepsSnapshot() {
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+
+        device.changeGpu(1);
+        QCOMPARE(device.currentGpuIndex, 1);
+        QCOMPARE(temperature(device.gpuData), 61.0f);
+
+        QVERIFY(device.readLatestSnapshot());
+        QCOMPARE(device.cardsHistory.at(0).tier(TimeSeriesHistory::RAW).count(), 1);
+        QCOMPARE(device.cardsHistory.at(1).tier(TimeSeriesHistory::RAW).count(), 1);
+        QCOMPARE(temperature(device.gpuData), 61.0f);
+
+        QVERIFY(!device.readLatestSnapshot());
+
+        device.changeGpu(0);
+        QCOMPARE(temperature(device.gpuData), 45.0f);
+        QCOMPARE(device.cardsHistory.at(0).tier(TimeSeriesHistory::RAW).count(), 1);
+    }
+
+    void changeGpuWhileSampling() {
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        QVERIFY(device.readLatestSnapshot());
+
+        QSignalSpy spy(&device, SIGNAL(dataReady()));
+        device.setSamplingInterval(20);
+        device.startSampling();
+
+        QVERIFY(spy.wait());
+        device.changeGpu(1);
+        QVERIFY(device.readLatestSnapshot());
+
+        QVERIFY(spy.wait());
+        device.stopSampling();
+        QVERIFY(device.readLatestSnapshot());
+
+        QCOMPARE(device.cardsHistory.at(0).tier(TimeSeriesHistory::RAW).count(), 3);
+        QCOMPARE(device.cardsHistory.at(1).tier(TimeSeriesHistory::RAW).count(), 3);
+        QCOMPARE(temperature(device.gpuData), 61.0f);
+        QCOMPARE(temperature(device.cardData(0)), 45.0f);
+    }
+
+    // with the window hidden only the temperature is read, the other values aren't samples and stay out of history
+    void hiddenWindowHistory() {
+        gpu device;
+        device.setHistoryFile(root.filePath("history"), 1);
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        QVERIFY(device.readLatestSnapshot());
+        QVERIFY(device.cardData(0).contains(ValueID::FAN_SPEED_PERCENT));
+
+        QSignalSpy spy(&device, SIGNAL(dataReady()));
+        device.setSamplingMode(SamplerThread::TEMPERATURE_ONLY);
+        device.setSamplingInterval(20);
+        device.startSampling();
+
+        QVERIFY(spy.wait());
+        device.stopSampling();
+        QVERIFY(device.readLatestSnapshot());
+
+        const TimeSeriesStore &raw = device.cardsHistory.at(0).tier(TimeSeriesHistory::RAW);
+        QCOMPARE(raw.count(), 2);
+        QVERIFY(raw.hasValue(ValueID::FAN_SPEED_PERCENT, 0));
+        QVERIFY(raw.hasValue(ValueID::TEMPERATURE_CURRENT, 1));
+        QCOMPARE(raw.value(ValueID::TEMPERATURE_CURRENT, 1), 45.0f);
+        QVERIFY(!raw.hasValue(ValueID::FAN_SPEED_PERCENT, 1));
+
+        // the last full values are still shown
+        QVERIFY(device.cardData(0).contains(ValueID::FAN_SPEED_PERCENT));
+
+        // and the file has the same samples
+        gpu restarted;
+        restarted.setHistoryFile(root.filePath("history"), 1);
+        QVERIFY(restarted.initialize(dXorg::InitializationConfig()));
+
+        const TimeSeriesStore &loaded = restarted.cardsHistory.at(0).tier(TimeSeriesHistory::RAW);
+        QCOMPARE(loaded.count(), 2);
+        QVERIFY(loaded.hasValue(ValueID::FAN_SPEED_PERCENT, 0));
+        QVERIFY(!loaded.hasValue(ValueID::FAN_SPEED_PERCENT, 1));
+    }
+
+    // while the window is hidden the sampler and gpu don't make strings of values, only the ui does that
+    void hiddenWindowFormatsNothing() {
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        QVERIFY(device.readLatestSnapshot());
+
+        const quint64 formatted = RPValue::formatCount();
+
+        QSignalSpy spy(&device, SIGNAL(dataReady()));
+        device.setSamplingInterval(20);
+        device.setSamplingMode(SamplerThread::IDLE);
+        device.startSampling();
+
+        QVERIFY(spy.wait());
+        device.readLatestSnapshot();
+
+        device.setSamplingMode(SamplerThread::TEMPERATURE_ONLY);
+        QVERIFY(spy.wait());
+        device.stopSampling();
+        QVERIFY(device.readLatestSnapshot());
+
+        QCOMPARE(RPValue::formatCount() - formatted, quint64(0));
+
+        // the counter works
+        QCOMPARE(device.gpuData.value(ValueID::TEMPERATURE_CURRENT).strValue(), QString::fromUtf8("45\u00B0C"));
+        QCOMPARE(RPValue::formatCount() - formatted, quint64(1));
+    }
+
+    // initialize() doesn't block on the daemon, the first data is waited for in the event loop
+    void firstDaemonDataWait() {
+        MockDaemon daemon(MockDaemon::LEGACY);
+        QVERIFY(daemon.listen());
+
+        DaemonComm::instance().connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(daemon.isClientConnected());
+
+        gpu device;
+        QSignalSpy initialized(&device, SIGNAL(initialized()));
+
+        QVERIFY(device.initialize(dXorg::InitializationConfig(false, true, true)));
+        QVERIFY(device.isInitializationPending());
+
+        QTRY_VERIFY(daemon.isSharedMemoryAttached());
+        QCOMPARE(daemon.received().at(0).type, DaemonCommand::CONFIG);
+        QCOMPARE(daemon.received().at(0).arguments.at(1), globalStuff::systemPath("/sys/kernel/debug/dri/0/amdgpu_pm_info"));
+
+        // polled meanwhile, but nothing is there yet
+        QTest::qWait(DAEMON_DATA_POLL_INTERVAL * 3);
+        QVERIFY(device.isInitializationPending());
+        QCOMPARE(initialized.count(), 0);
+
+        daemon.publish(pmInfo());
+
+        // well before DAEMON_DATA_TIMEOUT
+        QTRY_COMPARE_WITH_TIMEOUT(initialized.count(), 1, 1000);
+        QVERIFY(!device.isInitializationPending());
+
+        QCOMPARE(device.cardData(0).value(ValueID::CLK_CORE).value, 1340.0f);
+        QCOMPARE(device.cardData(0).value(ValueID::CLK_MEM).value, 1750.0f);
+
+        // the daemon reads one card only
+        QVERIFY(!device.cardData(1).contains(ValueID::CLK_CORE));
+
+        DaemonComm::instance().disconnectDaemon();
+    }
+
+    void firstDaemonDataTimeout() {
+        MockDaemon daemon(MockDaemon::LEGACY);
+        QVERIFY(daemon.listen());
+
+        DaemonComm::instance().connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(daemon.isClientConnected());
+
+        gpu device;
+        QSignalSpy initialized(&device, SIGNAL(initialized()));
+
+        QVERIFY(device.initialize(dXorg::InitializationConfig(false, true, true)));
+        QVERIFY(device.isInitializationPending());
+
+        // initialized without the clocks
+        QTRY_COMPARE_WITH_TIMEOUT(initialized.count(), 1, DAEMON_DATA_TIMEOUT * 2);
+        QVERIFY(!device.cardData(0).contains(ValueID::CLK_CORE));
+        QCOMPARE(temperature(device.cardData(0)), 45.0f);
+
+        DaemonComm::instance().disconnectDaemon();
+    }
+
+    void daemonClocksRecord_data() {
+        QTest::addColumn<MockDaemon::Protocol>("protocol");
+
+        QTest::newRow("legacy") << MockDaemon::LEGACY;
+        QTest::newRow("framed") << MockDaemon::FRAMED;
+    }
+
+    // the client asks for records, a daemon which parses pm_info writes one instead of the text
+    void daemonClocksRecord() {
+        QFETCH(MockDaemon::Protocol, protocol);
+
+        MockDaemon daemon(protocol);
+        QVERIFY(daemon.listen());
+
+        DaemonComm::instance().connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(daemon.isClientConnected());
+
+        if (protocol == MockDaemon::FRAMED)
+            QTRY_VERIFY(DaemonComm::instance().isFramed());
+
+        gpu device;
+        QSignalSpy initialized(&device, SIGNAL(initialized()));
+
+        QVERIFY(device.initialize(dXorg::InitializationConfig(false, true, true)));
+        QTRY_VERIFY(daemon.isSharedMemoryAttached());
+        QCOMPARE(daemon.requestedFormat(), DaemonSharedMem::PAYLOAD_CLOCKS_RECORD);
+
+        DaemonClocksRecord record = {};
+        record.sclk = 1200;
+        record.mclk = 1600;
+        record.vclk = -1;
+        record.dclk = -1;
+        record.vddc = 900;
+        record.vddci = -1;
+        record.powerLevel = 2;
+
+        QVERIFY(daemon.publish(record));
+
+        QTRY_COMPARE_WITH_TIMEOUT(initialized.count(), 1, 1000);
+        QCOMPARE(device.cardData(0).value(ValueID::CLK_CORE).value, 1200.0f);
+        QCOMPARE(device.cardData(0).value(ValueID::CLK_MEM).value, 1600.0f);
+        QCOMPARE(device.cardData(0).value(ValueID::VOLT_CORE).value, 900.0f);
+
+        DaemonComm::instance().disconnectDaemon();
+    }
+
+    // values set within WRITE_COALESCE_WINDOW go in one frame, a path set again keeps its place with the latest value
+    void coalescedWrites() {
+        MockDaemon daemon(MockDaemon::FRAMED);
+        QVERIFY(daemon.listen());
+
+        DaemonComm::instance().connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(DaemonComm::instance().isFramed());
+
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        daemon.clearReceived();
+
+        device.setPwmValue(50);
+        device.setPwmManualControl(true);
+        device.setPwmValue(60);
+
+        QTRY_COMPARE(daemon.received().count(), 2);
+        QTest::qWait(WRITE_COALESCE_WINDOW * 4);
+        QCOMPARE(daemon.received().count(), 2);
+
+        const QVector<MockDaemon::Instruction> &received = daemon.received();
+        QCOMPARE(received.at(0).arguments, QStringList() << device.getDriverFiles().hwmonAttributes.pwm1 << "153");
+        QCOMPARE(received.at(1).arguments, QStringList() << device.getDriverFiles().hwmonAttributes.pwm1_enable << "1");
+        QCOMPARE(received.at(0).requestId, received.at(1).requestId);
+
+        DaemonComm::instance().disconnectDaemon();
+    }
+
+    // the same pwm is skipped, unless the daemon failed to write it
+    void failedWriteNotDeduplicated() {
+        MockDaemon daemon(MockDaemon::FRAMED);
+        QVERIFY(daemon.listen());
+
+        DaemonComm::instance().connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(DaemonComm::instance().isFramed());
+
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        daemon.clearReceived();
+
+        QSignalSpy finished(&DaemonComm::instance(), SIGNAL(commandFinished(quint32,int)));
+
+        device.setPwmValue(50);
+        QTRY_COMPARE(daemon.received().count(), 1);
+        QTRY_COMPARE(finished.count(), 1);
+
+        device.setPwmValue(50);
+        QTest::qWait(WRITE_COALESCE_WINDOW * 4);
+        QCOMPARE(daemon.received().count(), 1);
+
+        daemon.failRequest(daemon.received().last().requestId + 1, EIO, 0);
+        device.setPwmValue(60);
+        QTRY_COMPARE(daemon.received().count(), 2);
+        QTRY_COMPARE(finished.count(), 2);
+
+        device.setPwmValue(60);
+        QTRY_COMPARE(daemon.received().count(), 3);
+        QCOMPARE(daemon.received().last().arguments.at(1), QString("153"));
+
+        DaemonComm::instance().disconnectDaemon();
+    }
+
+    // the fan controller may set pwm from another thread, the flush still happens in the one of gpu
+    void writeFromOtherThread() {
+        MockDaemon daemon(MockDaemon::FRAMED);
+        QVERIFY(daemon.listen());
+
+        DaemonComm::instance().connectToDaemon(daemon.serverName());
+        QTRY_VERIFY(DaemonComm::instance().isFramed());
+
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+        daemon.clearReceived();
+
+        std::thread worker([&device]() {
+            device.setPwmValue(50);
+        });
+        worker.join();
+
+        QTRY_COMPARE(daemon.received().count(), 1);
+        QCOMPARE(daemon.received().at(0).arguments.at(1), QString("127"));
+
+        DaemonComm::instance().disconnectDaemon();
+    }
+
+    void changeGpuOutOfRange() {
+        gpu device;
+        QVERIFY(device.initialize(dXorg::InitializationConfig()));
+
+        device.changeGpu(2);
+        device.changeGpu(-1);
+        QCOMPARE(device.currentGpuIndex, 0);
+        QCOMPARE(temperature(device.gpuData), 45.0f);
+    }
+};
+
+QTEST_GUILESS_MAIN(GpuTest)
+#include "tst_gpu.moc"
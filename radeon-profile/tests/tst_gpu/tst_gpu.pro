@@ -0,0 +1,46 @@
+include(../tests.pri)
+include(../mockDaemon/mockDaemon.pri)
+
+TARGET = tst_gpu
+
+# dxorg.h uses QTreeWidgetItem, gpu.h QtConcurrent
+QT += gui widgets network concurrent
+
+SOURCES += tst_gpu.cpp \
+    ../../gpu.cpp \
+    ../../dxorg.cpp \
+    ../../daemonComm.cpp \
+    ../../daemonCommand.cpp \
+    ../../daemonSharedMem.cpp \
+    ../../ioctlHandler.cpp \
+    ../../ioctlBackend.cpp \
+    ../../busySampler.cpp \
+    ../../ioctl_radeon.cpp \
+    ../../ioctl_amdgpu.cpp \
+    ../../sysfsAttribute.cpp \
+    ../../sysfsEnumerator.cpp \
+    ../../pmInfoParser.cpp \
+    ../../samplerThread.cpp \
+    ../../workStealingPool.cpp \
+    ../../timeSeriesStore.cpp \
+    ../../historyFile.cpp
+
+HEADERS += ../../gpu.h \
+    ../../dxorg.h \
+    ../../globalStuff.h \
+    ../../daemonComm.h \
+    ../../daemonCommand.h \
+    ../../daemonSharedMem.h \
+    ../../ioctlHandler.h \
+    ../../ioctlBackend.h \
+    ../../busySampler.h \
+    ../../sysfsAttribute.h \
+    ../../sysfsEnumerator.h \
+    ../../pmInfoParser.h \
+    ../../samplerThread.h \
+    ../../workStealingPool.h \
+    ../../timeSeriesStore.h \
+    ../../historyFile.h
+
+# gpu.cpp reads connectors with Xrandr
+LIBS += -lXrandr -lX11
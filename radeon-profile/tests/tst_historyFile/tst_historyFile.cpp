@@ -0,0 +1,213 @@
+#include "historyFile.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <cstddef> // offsetof()
+
+/**
+ * @brief Tests of HistoryFile in a temporary directory: what is left after a restart, and after a crash
+ * which cut the file off or left a record half written. Timestamps are seconds in mS, from 1 s.
+ */
+class HistoryFileTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir directory;
+
+    static GPUDataContainer sample(float temperature) {
+        GPUDataContainer data;
+        data.insert(ValueID::TEMPERATURE_CURRENT, RPValue(ValueUnit::CELSIUS, temperature));
+        return data;
+    }
+
+    // records in a file of 1 MiB
+    static int capacity() {
+        return (1048576 - sizeof(HistoryFileHeader)) / sizeof(HistoryRecord);
+    }
+
+    static qint64 offsetOf(int record) {
+        return sizeof(HistoryFileHeader) + static_cast<qint64>(record) * sizeof(HistoryRecord);
+    }
+
+    QString write(const QString &name, int records) {
+        const QString path = directory.filePath(name);
+
+        HistoryFile file;
+        if (!file.open(path, 1))
+            return QString();
+
+        for (int i = 1; i <= records; ++i)
+            file.append(i * 1000, sample(i));
+
+        return path;
+    }
+
+    // raw samples of the loaded history, in order
+    static QVector<qint64> timestampsOf(const TimeSeriesHistory &history) {
+        QVector<qint64> timestamps;
+        const TimeSeriesStore &raw = history.tier(TimeSeriesHistory::RAW);
+
+        for (int i = 0; i < raw.count(); ++i)
+            timestamps.append(raw.timestamp(i));
+
+        return timestamps;
+    }
+
+    static QVector<qint64> range(int first, int last) {
+        QVector<qint64> timestamps;
+
+        for (int i = first; i <= last; ++i)
+            timestamps.append(i * 1000);
+
+        return timestamps;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(directory.isValid());
+    }
+
+    void reopen() {
+        const QString path = write("reopen", 100);
+        QVERIFY(!path.isEmpty());
+
+        HistoryFile file;
+        QVERIFY(file.open(path, 1));
+
+        TimeSeriesHistory history;
+        QCOMPARE(file.load(&history), 100);
+        QCOMPARE(timestampsOf(history), range(1, 100));
+        QCOMPARE(history.tier(TimeSeriesHistory::RAW).value(ValueID::TEMPERATURE_CURRENT, 41), 42.0f);
+    }
+
+    // cut off in the middle of the last record, the records before it are kept and appending goes on after them
+    void truncatedFile() {
+        const QString path = write("truncated", 100);
+        QVERIFY(!path.isEmpty());
+
+        {
+            QFile f(path);
+            QVERIFY(f.open(QIODevice::ReadWrite));
+            QVERIFY(f.resize(offsetOf(99) + sizeof(HistoryRecord) / 2));
+        }
+
+        HistoryFile file;
+        QVERIFY(file.open(path, 1));
+        QCOMPARE(QFileInfo(path).size(), offsetOf(capacity()));
+
+        TimeSeriesHistory history;
+        QCOMPARE(file.load(&history), 99);
+        QCOMPARE(timestampsOf(history), range(1, 99));
+
+        file.append(101000, sample(101));
+        file.close();
+
+        QVERIFY(file.open(path, 1));
+        TimeSeriesHistory reloaded;
+        QCOMPARE(file.load(&reloaded), 100);
+        QCOMPARE(timestampsOf(reloaded).last(), 101000LL);
+        QCOMPARE(timestampsOf(reloaded).at(98), 99000LL);
+    }
+
+    // a record with a wrong checksum (written partially) is skipped, the others load in order
+    void badChecksum() {
+        const QString path = write("checksum", 100);
+        QVERIFY(!path.isEmpty());
+
+        {
+            QFile f(path);
+            QVERIFY(f.open(QIODevice::ReadWrite));
+
+            const float corrupted = -1;
+            QVERIFY(f.seek(offsetOf(49) + offsetof(HistoryRecord, values) + ValueID::TEMPERATURE_CURRENT * sizeof(float)));
+            QCOMPARE(f.write(reinterpret_cast<const char*>(&corrupted), sizeof(corrupted)), static_cast<qint64>(sizeof(corrupted)));
+        }
+
+        HistoryFile file;
+        QVERIFY(file.open(path, 1));
+
+        TimeSeriesHistory history;
+        QCOMPARE(file.load(&history), 99);
+
+        QVector<qint64> expected = range(1, 100);
+        expected.remove(49);
+        QCOMPARE(timestampsOf(history), expected);
+    }
+
+    // the newest record of a full file is broken, the next append overwrites it and the oldest ones stay
+    void badNewestRecordWrapped() {
+        const int capacity = this->capacity();
+        const QString path = write("wrapped", capacity + 10);
+        QVERIFY(!path.isEmpty());
+
+        // record capacity + 10 is in slot 9
+        {
+            QFile f(path);
+            QVERIFY(f.open(QIODevice::ReadWrite));
+            QVERIFY(f.seek(offsetOf(9) + offsetof(HistoryRecord, checksum)));
+            QCOMPARE(f.write("\0\0\0\0", 4), 4LL);
+        }
+
+        HistoryFile file;
+        QVERIFY(file.open(path, 1));
+
+        TimeSeriesHistory history;
+        QCOMPARE(file.load(&history), capacity - 1);
+        QCOMPARE(history.lastTimestamp(), static_cast<qint64>(capacity + 9) * 1000);
+
+        file.append(static_cast<qint64>(capacity + 11) * 1000, sample(0));
+        file.close();
+
+        QVERIFY(file.open(path, 1));
+        TimeSeriesHistory reloaded;
+        QCOMPARE(file.load(&reloaded), capacity);
+        QCOMPARE(reloaded.lastTimestamp(), static_cast<qint64>(capacity + 11) * 1000);
+    }
+
+    // values left out of a sample aren't in its record
+    void sampledIdsOnly() {
+        const QString path = directory.filePath("ids");
+        GPUDataContainer data = sample(50);
+        data.insert(ValueID::CLK_CORE, RPValue(ValueUnit::MEGAHERTZ, 1340));
+
+        {
+            HistoryFile file;
+            QVERIFY(file.open(path, 1));
+            file.append(1000, data);
+            file.append(2000, data, 1u << ValueID::TEMPERATURE_CURRENT);
+        }
+
+        HistoryFile file;
+        QVERIFY(file.open(path, 1));
+
+        TimeSeriesHistory history;
+        QCOMPARE(file.load(&history), 2);
+
+        const TimeSeriesStore &raw = history.tier(TimeSeriesHistory::RAW);
+        QVERIFY(raw.hasValue(ValueID::CLK_CORE, 0));
+        QVERIFY(raw.hasValue(ValueID::TEMPERATURE_CURRENT, 1));
+        QVERIFY(!raw.hasValue(ValueID::CLK_CORE, 1));
+    }
+
+    // a file of another layout is started anew
+    void otherLayout() {
+        const QString path = write("layout", 10);
+        QVERIFY(!path.isEmpty());
+
+        {
+            QFile f(path);
+            QVERIFY(f.open(QIODevice::ReadWrite));
+            QCOMPARE(f.write("XXXX", 4), 4LL);
+        }
+
+        HistoryFile file;
+        QVERIFY(file.open(path, 1));
+
+        TimeSeriesHistory history;
+        QCOMPARE(file.load(&history), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(HistoryFileTest)
+#include "tst_historyFile.moc"
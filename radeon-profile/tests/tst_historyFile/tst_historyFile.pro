@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_historyFile
+
+SOURCES += tst_historyFile.cpp \
+    ../../historyFile.cpp \
+    ../../timeSeriesStore.cpp
+
+HEADERS += ../../historyFile.h \
+    ../../timeSeriesStore.h
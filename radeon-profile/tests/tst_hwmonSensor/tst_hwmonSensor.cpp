@@ -0,0 +1,99 @@
+#include "dxorg.h"
+#include "ioctlBackend.h"
+
+#include <QtTest>
+#include <QDir>
+
+/**
+ * @brief Tests of the temperature sensor lookup of dXorg on the sysfs tree in data/root.
+ * Cards have no hwmon dir of their own, so the temperature is looked up in /sys/class/hwmon, where there are:
+ * hwmon0 k10temp, labels in the hwmon dir
+ * hwmon1 amdgpu of card1, labels in the hwmon dir
+ * hwmon2 amdgpu of card0, attributes and labels in the device subdir (older kernels)
+ * hwmon3 nct6775 motherboard chip, attributes and labels in the device subdir
+ * No label is VGA_TEMP, for the motherboard chip it is set in sensors.conf only, 'sensors' in data/bin prints
+ * the output of lm_sensors with that config.
+ * Nothing in the tree is opened for writing (no power method files), so it is used in place.
+ */
+class HwmonSensorTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // every ioctl fails, even if the host has a card
+    ReplayIoctlBackend noIoctl;
+    QByteArray path;
+
+    static GPUSysInfo sysInfo(const QString &card, const QString &module) {
+        GPUSysInfo info;
+        info.sysName = card;
+        info.driverModuleString = module;
+        info.module = (module == "radeon") ? DriverModule::RADEON : DriverModule::AMDGPU;
+
+        return info;
+    }
+
+    static QString hwmonPath(const QString &file) {
+        return globalStuff::systemPath("/sys/class/hwmon/") + file;
+    }
+
+public:
+    HwmonSensorTest() : noIoctl(QDir::tempPath() + "/rp-no-such-recording.ioctl") { }
+
+private slots:
+    void initTestCase() {
+        const QString root = QFINDTESTDATA("data/root"), bin = QFINDTESTDATA("data/bin");
+        QVERIFY(!root.isEmpty());
+        QVERIFY(!bin.isEmpty());
+
+        globalStuff::setSystemRoot(root);
+        IoctlBackend::setDefaultBackend(&noIoctl);
+
+        // the fake sensors comes first
+        path = qgetenv("PATH");
+        qputenv("PATH", QFile::encodeName(bin) + ":" + path);
+    }
+
+    void cleanupTestCase() {
+        qputenv("PATH", path);
+        IoctlBackend::setDefaultBackend(nullptr);
+        globalStuff::setSystemRoot(QString());
+    }
+
+    // hwmon chip named after the driver, of the card's own device when there are more of them
+    void pciSensor_data() {
+        QTest::addColumn<QString>("card");
+        QTest::addColumn<QString>("input");
+        QTest::addColumn<float>("temperature");
+
+        QTest::newRow("attributes in device subdir") << "card0" << hwmonPath("hwmon2/device/temp1_input") << 45.0f;
+        QTest::newRow("attributes in hwmon dir") << "card1" << hwmonPath("hwmon1/temp1_input") << 61.0f;
+    }
+
+    void pciSensor() {
+        QFETCH(QString, card);
+        QFETCH(QString, input);
+        QFETCH(float, temperature);
+
+        dXorg handler(sysInfo(card, "amdgpu"), dXorg::InitializationConfig());
+        handler.finishConfiguration();
+
+        QCOMPARE(handler.features.currentTemperatureSensor, TemperatureSensor::PCI_SENSOR);
+        QCOMPARE(handler.driverFiles.hwmonAttributes.temp1, input);
+        QCOMPARE(handler.getTemperature(), temperature);
+    }
+
+    // no radeon chip, the VGA_TEMP label from sensors points to temp2 of the motherboard chip
+    void mbSensor() {
+        dXorg handler(sysInfo("card0", "radeon"), dXorg::InitializationConfig());
+        handler.finishConfiguration();
+
+        QCOMPARE(handler.features.currentTemperatureSensor, TemperatureSensor::MB_SENSOR);
+        QCOMPARE(handler.driverFiles.hwmonAttributes.temp1, hwmonPath("hwmon3/device/temp2_input"));
+        QCOMPARE(handler.getTemperature(), 52.0f);
+    }
+};
+
+QTEST_GUILESS_MAIN(HwmonSensorTest)
+
+#include "tst_hwmonSensor.moc"
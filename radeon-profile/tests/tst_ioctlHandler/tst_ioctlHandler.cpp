@@ -0,0 +1,81 @@
+#include "ioctlHandler.h"
+#include "ioctlBackend.h"
+
+#include <QtTest>
+#include <QDir>
+
+/**
+ * @brief Tests of ioctlHandler::sampleAll() on ReplayIoctlBackend, no /dev/dri needed.
+ *
+ * data/amdgpu_sensors.ioctl is in the format RecordingIoctlBackend saves ("code query parameter result", hex,
+ * values little endian): DRM_IOCTL_AMDGPU_INFO answers for the sclk, mclk, temperature, load and vddgfx sensors
+ * and the VRAM usage query. Average power, vddnb and the stable pstate clocks are not in it,
+ * so they fail with EINVAL as on a kernel without them.
+ */
+class IoctlHandlerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void amdgpuSampleAll() {
+#ifdef NO_IOCTL
+        QSKIP("built with NO_IOCTL");
+#endif
+        ReplayIoctlBackend backend(QFINDTESTDATA("data/amdgpu_sensors.ioctl"));
+        QVERIFY(backend.isLoaded());
+
+        amdgpuIoctlHandler handler(0, &backend);
+        QVERIFY(handler.isValid());
+
+        const IoctlBackend::Statistics start = backend.statistics();
+
+        SensorSnapshot snapshot;
+        QVERIFY(handler.sampleAll(&snapshot));
+
+        QVERIFY(snapshot.timestamp > 0);
+        QCOMPARE(snapshot.coreClock, 1340);
+        QCOMPARE(snapshot.memoryClock, 1750);
+        QCOMPARE(snapshot.temperature, 52000);
+        QCOMPARE(snapshot.gpuUsage, 37.0f);
+        QCOMPARE(snapshot.vddgfx, 1050);
+        QCOMPARE(snapshot.vramUsage, 536870912L);
+
+        // not recorded, left unknown
+        QCOMPARE(snapshot.averagePower, -1);
+        QCOMPARE(snapshot.vddnb, -1);
+        QCOMPARE(snapshot.stableCoreClock, -1);
+        QCOMPARE(snapshot.stableMemoryClock, -1);
+
+        const IoctlBackend::Statistics first = backend.statistics();
+        const quint64 firstCalls = first.calls - start.calls, firstFailures = first.failures - start.failures;
+        QVERIFY(firstFailures > 0);
+
+        // sensors that failed with EINVAL are not queried again
+        SensorSnapshot next;
+        QVERIFY(handler.sampleAll(&next));
+
+        const IoctlBackend::Statistics second = backend.statistics();
+        QCOMPARE(second.failures, first.failures);
+        QCOMPARE(second.calls - first.calls, firstCalls - firstFailures);
+
+        QVERIFY(next.timestamp >= snapshot.timestamp);
+        QCOMPARE(next.coreClock, 1340);
+        QCOMPARE(next.averagePower, -1);
+    }
+
+    void missingRecording() {
+        ReplayIoctlBackend backend(QDir::tempPath() + "/rp-no-such-recording.ioctl");
+        QVERIFY(!backend.isLoaded());
+
+        amdgpuIoctlHandler handler(0, &backend);
+        QVERIFY(!handler.isValid());
+
+        SensorSnapshot snapshot;
+        QVERIFY(!handler.sampleAll(&snapshot));
+        QCOMPARE(snapshot.coreClock, -1);
+        QCOMPARE(snapshot.vramUsage, -1L);
+    }
+};
+
+QTEST_GUILESS_MAIN(IoctlHandlerTest)
+#include "tst_ioctlHandler.moc"
@@ -0,0 +1,14 @@
+include(../tests.pri)
+
+TARGET = tst_ioctlHandler
+
+SOURCES += tst_ioctlHandler.cpp \
+    ../../ioctlHandler.cpp \
+    ../../ioctlBackend.cpp \
+    ../../busySampler.cpp \
+    ../../ioctl_radeon.cpp \
+    ../../ioctl_amdgpu.cpp
+
+HEADERS += ../../ioctlHandler.h \
+    ../../ioctlBackend.h \
+    ../../busySampler.h
@@ -0,0 +1,138 @@
+#include "pmInfoParser.h"
+
+#include <QtTest>
+#include <QFile>
+#include <QMap>
+#include <cstring>
+
+/**
+ * @brief Golden-file tests of PmInfoParser, every data/<name>.pm_info is a captured pm_info,
+ * data/<name>.expected holds the driver module, detected layout and clocks it has to give.
+ *
+ * Pinned differences from the regular expressions used before:
+ * radeon clocks (10 kHz) are divided by 100 in integers, the same value the float division gave
+ * after it was stored in the int fields of GPUClocks, and the power level is read with all its digits
+ * ("power level 12" was 1 with "power\slevel\s\d").
+ */
+class PmInfoParserTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QMap<QString, QString> readExpected(const QString &path) {
+        QMap<QString, QString> values;
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
+            return values;
+
+        for (const QString &line : QString(f.readAll()).split('\n', QString::SkipEmptyParts)) {
+            const int eq = line.indexOf('=');
+            if (eq > 0)
+                values.insert(line.left(eq), line.mid(eq + 1));
+        }
+
+        return values;
+    }
+
+    static PmInfoParser::Layout layoutFromName(const QString &name) {
+        if (name == "RADEON_DPM")
+            return PmInfoParser::RADEON_DPM;
+        if (name == "AMDGPU_BRACKETS")
+            return PmInfoParser::AMDGPU_BRACKETS;
+        if (name == "AMDGPU_SUFFIX")
+            return PmInfoParser::AMDGPU_SUFFIX;
+
+        return PmInfoParser::LAYOUT_UNKNOWN;
+    }
+
+private slots:
+    void goldenFiles_data() {
+        QTest::addColumn<QString>("sample");
+
+        QTest::newRow("radeon idle") << "radeon_idle";
+        QTest::newRow("radeon uvd, fractional MHz") << "radeon_uvd";
+        QTest::newRow("radeon two digit power level") << "radeon_level12";
+        QTest::newRow("amdgpu in radeon format") << "amdgpu_dpm";
+        QTest::newRow("amdgpu brackets") << "amdgpu_brackets";
+        QTest::newRow("amdgpu suffix") << "amdgpu_suffix";
+
+        // whole dumps, one of every layout, parsed by rp-bench as well
+        QTest::newRow("captured radeon") << "radeon_pitcairn";
+        QTest::newRow("captured amdgpu brackets") << "amdgpu_tonga";
+        QTest::newRow("captured amdgpu suffix") << "amdgpu_polaris";
+    }
+
+    void goldenFiles() {
+        QFETCH(QString, sample);
+
+        const QString pmInfoPath = QFINDTESTDATA("data/" + sample + ".pm_info"),
+                expectedPath = QFINDTESTDATA("data/" + sample + ".expected");
+
+        QVERIFY2(!pmInfoPath.isEmpty() && !expectedPath.isEmpty(), qPrintable("missing data of " + sample));
+
+        QFile f(pmInfoPath);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        const QByteArray data = f.readAll();
+
+        const QMap<QString, QString> expected = readExpected(expectedPath);
+        const DriverModule module = expected.value("module") == "radeon" ? DriverModule::RADEON : DriverModule::AMDGPU;
+
+        const PmInfoParser::Layout layout = PmInfoParser::detectLayout(module, data.constData(), data.size());
+        QCOMPARE(layout, layoutFromName(expected.value("layout")));
+
+        const GPUClocks clocks = PmInfoParser::parse(layout, data.constData(), data.size());
+        QCOMPARE(clocks.powerLevel, expected.value("powerLevel").toInt());
+        QCOMPARE(clocks.coreClk, expected.value("coreClk").toInt());
+        QCOMPARE(clocks.memClk, expected.value("memClk").toInt());
+        QCOMPARE(clocks.uvdCClk, expected.value("uvdCClk").toInt());
+        QCOMPARE(clocks.uvdDClk, expected.value("uvdDClk").toInt());
+        QCOMPARE(clocks.coreVolt, expected.value("coreVolt").toInt());
+        QCOMPARE(clocks.memVolt, expected.value("memVolt").toInt());
+    }
+
+    void unknownLayout() {
+        const char data[] = "GPU Load: 0 %\n";
+
+        QCOMPARE(PmInfoParser::detectLayout(DriverModule::RADEON, data, sizeof(data) - 1), PmInfoParser::LAYOUT_UNKNOWN);
+        QCOMPARE(PmInfoParser::detectLayout(DriverModule::AMDGPU, data, sizeof(data) - 1), PmInfoParser::LAYOUT_UNKNOWN);
+        QCOMPARE(PmInfoParser::parse(PmInfoParser::LAYOUT_UNKNOWN, data, sizeof(data) - 1).coreClk, -1);
+    }
+
+    // nothing past length is read, a value cut off by the buffer end is taken as it is
+    void lengthIsRespected() {
+        const char data[] = "power level 0    sclk: 30000 mclk: 15000";
+
+        const GPUClocks cut = PmInfoParser::parse(PmInfoParser::RADEON_DPM, data, static_cast<int>(strlen("power level 0    sclk: 300")));
+        QCOMPARE(cut.coreClk, 3);
+        QCOMPARE(cut.memClk, -1);
+
+        const GPUClocks beforeValue = PmInfoParser::parse(PmInfoParser::RADEON_DPM, data, static_cast<int>(strlen("power level 0    sclk:")));
+        QCOMPARE(beforeValue.coreClk, -1);
+    }
+
+    void record() {
+        DaemonClocksRecord record = {};
+        record.sclk = 1340;
+        record.mclk = 1750;
+        record.vclk = -1;
+        record.dclk = -1;
+        record.vddc = 1050;
+        record.vddci = -1;
+        record.powerLevel = 3;
+
+        char data[sizeof(record)];
+        memcpy(data, &record, sizeof(record));
+
+        const GPUClocks clocks = PmInfoParser::parseRecord(data, sizeof(data));
+        QCOMPARE(clocks.coreClk, 1340);
+        QCOMPARE(clocks.memClk, 1750);
+        QCOMPARE(clocks.uvdCClk, -1);
+        QCOMPARE(clocks.coreVolt, 1050);
+        QCOMPARE(clocks.powerLevel, 3);
+
+        QCOMPARE(PmInfoParser::parseRecord(data, sizeof(data) - 1).coreClk, -1);
+    }
+};
+
+QTEST_GUILESS_MAIN(PmInfoParserTest)
+#include "tst_pmInfoParser.moc"
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+TARGET = tst_pmInfoParser
+
+SOURCES += tst_pmInfoParser.cpp \
+    ../../pmInfoParser.cpp
+
+HEADERS += ../../pmInfoParser.h \
+    ../../daemonSharedMem.h
@@ -0,0 +1,198 @@
+#include "samplerThread.h"
+#include "ioctlBackend.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+#include <atomic>
+#include <thread>
+
+// ticks of the stress test
+#define STRESS_TICKS 2000
+
+// temperature of counter 0 in °C, 0 in temp1_input is an invalid value for the handler
+#define BASE_TEMPERATURE 30
+
+/**
+ * @brief Tests of SamplerThread on the sysfs tree in data/root (two amdgpu cards, temperature and gpu_busy_percent).
+ * Before every tick the test writes one counter to the files of both cards, so every value of a snapshot
+ * and its sequence number are derived from the same counter and a torn snapshot shows as a mismatch.
+ */
+class SamplerThreadTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // every ioctl fails, even if the host has a card
+    ReplayIoctlBackend noIoctl;
+
+    // handlers probe attributes by opening them for writing, which truncates regular files,
+    // so the tests run on a copy of data/root
+    QTemporaryDir root;
+
+    QVector<dXorg*> handlers;
+    QVector<GPUDataContainer> initialData;
+
+    static bool copyTree(const QString &from, const QString &to) {
+        if (!QDir().mkpath(to))
+            return false;
+
+        for (const QString &entry : QDir(from).entryList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot)) {
+            const QString source = from + "/" + entry, target = to + "/" + entry;
+
+            if (QFileInfo(source).isDir() ? !copyTree(source, target) : !QFile::copy(source, target))
+                return false;
+        }
+
+        return true;
+    }
+
+    // same file is rewritten in place, so the handler's open attribute reads the new value
+    static bool writeValue(const QString &path, int value) {
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly))
+            return false;
+
+        return f.write(QByteArray::number(value) + "\n") > 0;
+    }
+
+    bool writeCounter(int counter) {
+        bool success = true;
+
+        for (const dXorg *handler : handlers) {
+            success &= writeValue(handler->driverFiles.hwmonAttributes.temp1, (BASE_TEMPERATURE + counter) * 1000);
+            success &= writeValue(handler->driverFiles.sysFs.gpu_busy_percent, counter % 100);
+        }
+
+        return success;
+    }
+
+    // the initial snapshot is counter 0, tick n publishes sequence n + 1 with counter n
+    static bool isConsistent(const GPUSnapshot &snapshot) {
+        const int counter = snapshot.sequence - 1;
+
+        for (const GPUCardSample &card : snapshot.cards) {
+            const GPUDataContainer &data = card.data;
+
+            if (data.value(ValueID::TEMPERATURE_CURRENT).value != BASE_TEMPERATURE + counter
+                    || data.value(ValueID::TEMPERATURE_BEFORE_CURRENT).value != BASE_TEMPERATURE + qMax(0, counter - 1)
+                    || data.value(ValueID::TEMPERATURE_MAX).value != BASE_TEMPERATURE + counter
+                    || data.value(ValueID::TEMPERATURE_MIN).value != BASE_TEMPERATURE
+                    || data.value(ValueID::GPU_USAGE_PERCENT).value != counter % 100
+                    || card.sampledIds != data.presentIds().mask)
+                return false;
+        }
+
+        return true;
+    }
+
+public:
+    SamplerThreadTest() : noIoctl(QDir::tempPath() + "/rp-no-such-recording.ioctl") { }
+
+private slots:
+    void initTestCase() {
+        const QString data = QFINDTESTDATA("data/root");
+        QVERIFY(!data.isEmpty());
+        QVERIFY(root.isValid());
+        QVERIFY(copyTree(data, root.filePath("root")));
+
+        globalStuff::setSystemRoot(root.filePath("root"));
+        IoctlBackend::setDefaultBackend(&noIoctl);
+
+        for (const QString &card : { QString("card0"), QString("card1") }) {
+            GPUSysInfo info;
+            info.sysName = card;
+            info.driverModuleString = "amdgpu";
+            info.module = DriverModule::AMDGPU;
+
+            dXorg *handler = new dXorg(info, dXorg::InitializationConfig());
+            handler->finishConfiguration();
+            handlers.append(handler);
+
+            QVERIFY(!handler->driverFiles.hwmonAttributes.temp1.isEmpty());
+            QVERIFY(!handler->driverFiles.sysFs.gpu_busy_percent.isEmpty());
+
+            GPUDataContainer values;
+            values.insert(ValueID::TEMPERATURE_CURRENT, RPValue(ValueUnit::CELSIUS, BASE_TEMPERATURE));
+            values.insert(ValueID::TEMPERATURE_BEFORE_CURRENT, RPValue(ValueUnit::CELSIUS, BASE_TEMPERATURE));
+            values.insert(ValueID::TEMPERATURE_MIN, RPValue(ValueUnit::CELSIUS, BASE_TEMPERATURE));
+            values.insert(ValueID::TEMPERATURE_MAX, RPValue(ValueUnit::CELSIUS, BASE_TEMPERATURE));
+            values.insert(ValueID::GPU_USAGE_PERCENT, RPValue(ValueUnit::PERCENT, 0));
+            initialData.append(values);
+        }
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(handlers);
+        handlers.clear();
+
+        IoctlBackend::setDefaultBackend(nullptr);
+        globalStuff::setSystemRoot(QString());
+    }
+
+    void init() {
+        QVERIFY(writeCounter(0));
+    }
+
+    // a fast producer publishes while a slow reader holds snapshots, every one it gets is whole and stays unchanged
+    void noTornSnapshots() {
+        SamplerThread sampler;
+        sampler.setDriverHandlers(handlers, initialData);
+
+        std::atomic<bool> producerFailed(false), producerDone(false);
+
+        std::thread producer([this, &sampler, &producerFailed, &producerDone]() {
+            for (int counter = 1; counter <= STRESS_TICKS; ++counter) {
+                if (!writeCounter(counter)) {
+                    producerFailed = true;
+                    break;
+                }
+
+                sampler.sampleOnce();
+            }
+
+            producerDone = true;
+        });
+
+        quint64 lastSequence = 0;
+        int snapshotsRead = 0, tornSnapshots = 0, reorderedSnapshots = 0;
+
+        while (!producerDone) {
+            const GPUSnapshotPtr snapshot = sampler.takeLatestSnapshot();
+
+            if (snapshot == nullptr || snapshot->cards.count() != handlers.count()) {
+                ++tornSnapshots;
+                continue;
+            }
+
+            if (snapshot->sequence < lastSequence)
+                ++reorderedSnapshots;
+
+            lastSequence = snapshot->sequence;
+
+            // held while the producer publishes newer ones, must not change under the reader
+            const bool consistent = isConsistent(*snapshot);
+            QThread::msleep(1);
+
+            if (!consistent || snapshot->sequence != lastSequence || !isConsistent(*snapshot))
+                ++tornSnapshots;
+
+            ++snapshotsRead;
+        }
+
+        producer.join();
+
+        QVERIFY(!producerFailed);
+        QCOMPARE(tornSnapshots, 0);
+        QCOMPARE(reorderedSnapshots, 0);
+        QVERIFY(snapshotsRead > 1);
+
+        const GPUSnapshotPtr last = sampler.takeLatestSnapshot();
+        QCOMPARE(last->sequence, quint64(STRESS_TICKS + 1));
+        QVERIFY(isConsistent(*last));
+    }
+};
+
+QTEST_GUILESS_MAIN(SamplerThreadTest)
+
+#include "tst_samplerThread.moc"
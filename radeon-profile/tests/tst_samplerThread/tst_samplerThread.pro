@@ -0,0 +1,36 @@
+include(../tests.pri)
+
+TARGET = tst_samplerThread
+
+# dxorg.h uses QTreeWidgetItem, daemonComm QLocalSocket
+QT += gui widgets network
+
+SOURCES += tst_samplerThread.cpp \
+    ../../samplerThread.cpp \
+    ../../workStealingPool.cpp \
+    ../../dxorg.cpp \
+    ../../daemonComm.cpp \
+    ../../daemonCommand.cpp \
+    ../../daemonSharedMem.cpp \
+    ../../ioctlHandler.cpp \
+    ../../ioctlBackend.cpp \
+    ../../busySampler.cpp \
+    ../../ioctl_radeon.cpp \
+    ../../ioctl_amdgpu.cpp \
+    ../../sysfsAttribute.cpp \
+    ../../sysfsEnumerator.cpp \
+    ../../pmInfoParser.cpp
+
+HEADERS += ../../samplerThread.h \
+    ../../workStealingPool.h \
+    ../../dxorg.h \
+    ../../globalStuff.h \
+    ../../daemonComm.h \
+    ../../daemonCommand.h \
+    ../../daemonSharedMem.h \
+    ../../ioctlHandler.h \
+    ../../ioctlBackend.h \
+    ../../busySampler.h \
+    ../../sysfsAttribute.h \
+    ../../sysfsEnumerator.h \
+    ../../pmInfoParser.h
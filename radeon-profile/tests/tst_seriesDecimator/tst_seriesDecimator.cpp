@@ -0,0 +1,168 @@
+#include "seriesDecimator.h"
+
+#include <QtTest>
+
+/**
+ * @brief Tests of SeriesDecimator::minMax() on generated samples, timestamps are mS from 0 and x of points is in seconds.
+ */
+class SeriesDecimatorTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void append(TimeSeriesStore *store, qint64 timestamp, float temperature) {
+        GPUDataContainer data;
+        data.insert(ValueID::TEMPERATURE_CURRENT, RPValue(ValueUnit::CELSIUS, temperature));
+        store->append(timestamp, data);
+    }
+
+    // deterministic noise between 30 and 90
+    static float noise(quint32 *state) {
+        *state = *state * 1103515245u + 12345u;
+        return 30 + (*state >> 16) % 61;
+    }
+
+    static int columnOf(qint64 timestamp, qint64 start, qint64 end, int columns) {
+        return static_cast<int>(qBound(static_cast<qint64>(0), (timestamp - start) * columns / (end - start), static_cast<qint64>(columns - 1)));
+    }
+
+private slots:
+    // every pixel column keeps minimum and maximum of its samples, with no more than two points
+    void extremaPreserved() {
+        TimeSeriesStore store(20000);
+        quint32 state = 1;
+
+        for (int i = 0; i < 10000; ++i)
+            append(&store, i * 100, noise(&state));
+
+        const qint64 start = 0, end = 1000000;
+        const int columns = 200;
+
+        QVector<float> expectedMin(columns, 1000), expectedMax(columns, -1000);
+        for (int i = 0; i < store.count(); ++i) {
+            const int column = columnOf(store.timestamp(i), start, end, columns);
+            expectedMin[column] = qMin(expectedMin.at(column), store.value(ValueID::TEMPERATURE_CURRENT, i));
+            expectedMax[column] = qMax(expectedMax.at(column), store.value(ValueID::TEMPERATURE_CURRENT, i));
+        }
+
+        QVector<QPointF> points;
+        SeriesDecimator::minMax(store, ValueID::TEMPERATURE_CURRENT, 0, start, end, columns, 0, &points);
+        QVERIFY(points.count() <= 2 * columns);
+
+        QVector<float> pointMin(columns, 1000), pointMax(columns, -1000);
+        QVector<int> pointCount(columns, 0);
+        for (int i = 0; i < points.count(); ++i) {
+            if (i > 0)
+                QVERIFY(points.at(i).x() >= points.at(i - 1).x());
+
+            const int column = columnOf(qRound64(points.at(i).x() * 1000), start, end, columns);
+            pointMin[column] = qMin(pointMin.at(column), static_cast<float>(points.at(i).y()));
+            pointMax[column] = qMax(pointMax.at(column), static_cast<float>(points.at(i).y()));
+            ++pointCount[column];
+        }
+
+        for (int column = 0; column < columns; ++column) {
+            QVERIFY(pointCount.at(column) <= 2);
+            QCOMPARE(pointMin.at(column), expectedMin.at(column));
+            QCOMPARE(pointMax.at(column), expectedMax.at(column));
+        }
+    }
+
+    // a one sample spike is a point at its own time
+    void spikeKept() {
+        TimeSeriesStore store(20000);
+
+        for (int i = 0; i < 10000; ++i)
+            append(&store, i * 100, i == 6543 ? 95 : 40);
+
+        QVector<QPointF> points;
+        SeriesDecimator::minMax(store, ValueID::TEMPERATURE_CURRENT, 0, 0, 1000000, 100, 0, &points);
+
+        QVERIFY(points.contains(QPointF(654.3, 95)));
+    }
+
+    // decimated buckets of a rollup keep the extremes of the samples rolled up
+    void rollupExtremaPreserved() {
+        TimeSeriesStore store(1000, 10000);
+        quint32 state = 7;
+        float min = 1000, max = -1000;
+
+        for (int i = 0; i < 100000; ++i) {
+            const float value = noise(&state);
+            min = qMin(min, value);
+            max = qMax(max, value);
+            append(&store, i * 100, value);
+        }
+
+        // closes the last bucket
+        append(&store, 10000000, 60);
+
+        QVector<QPointF> points;
+        SeriesDecimator::minMax(store, ValueID::TEMPERATURE_CURRENT, 0, 0, 10000000, 50, 0, &points);
+        QVERIFY(points.count() <= 2 * 50);
+
+        float pointMin = 1000, pointMax = -1000;
+        for (const QPointF &p : points) {
+            pointMin = qMin(pointMin, static_cast<float>(p.y()));
+            pointMax = qMax(pointMax, static_cast<float>(p.y()));
+        }
+
+        QCOMPARE(pointMin, min);
+        QCOMPARE(pointMax, max);
+    }
+
+    void preWindowSample_data() {
+        QTest::addColumn<int>("columns");
+
+        QTest::newRow("decimated") << 10;
+        QTest::newRow("every sample") << 1000;
+    }
+
+    // the sample before the window leads the line in, its value isn't in the first column
+    void preWindowSample() {
+        QFETCH(int, columns);
+
+        TimeSeriesStore store(1000);
+
+        for (int i = 0; i < 200; ++i)
+            append(&store, i * 1000, i == 10 ? 99 : 40 + i % 3);
+
+        const qint64 start = 10500, end = 199000;
+        const int from = store.indexAfter(start) - 1;
+        QCOMPARE(store.timestamp(from), 10000LL);
+
+        QVector<QPointF> points;
+        QCOMPARE(SeriesDecimator::minMax(store, ValueID::TEMPERATURE_CURRENT, from, start, end, columns, 0, &points), 1);
+
+        QCOMPARE(points.first(), QPointF(10, 99));
+
+        for (int i = 1; i < points.count(); ++i) {
+            QVERIFY(points.at(i).x() > start / 1000.0);
+            QVERIFY(points.at(i).y() < 99);
+        }
+
+        // first column starts with the first sample in the window
+        QCOMPARE(points.at(1).x(), 11.0);
+    }
+
+    // a rollup bucket which started before the window but reaches into it is a part of the first column
+    void bucketAcrossWindowStart() {
+        TimeSeriesStore store(100, 10000);
+
+        for (int i = 0; i < 600; ++i)
+            append(&store, i * 1000, i == 25 ? 99 : 40);
+
+        const qint64 start = 21000;
+        const int from = store.indexAfter(start) - 1;
+        QCOMPARE(store.timestamp(from), 20000LL);
+
+        QVector<QPointF> points;
+        QCOMPARE(SeriesDecimator::minMax(store, ValueID::TEMPERATURE_CURRENT, from, start, 600000, 5, 0, &points), 0);
+
+        QCOMPARE(points.at(0), QPointF(20, 40));
+        QCOMPARE(points.at(1), QPointF(20, 99));
+    }
+};
+
+QTEST_GUILESS_MAIN(SeriesDecimatorTest)
+#include "tst_seriesDecimator.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_seriesDecimator
+
+SOURCES += tst_seriesDecimator.cpp \
+    ../../seriesDecimator.cpp \
+    ../../timeSeriesStore.cpp
+
+HEADERS += ../../seriesDecimator.h \
+    ../../timeSeriesStore.h
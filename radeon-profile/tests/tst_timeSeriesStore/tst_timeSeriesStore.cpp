@@ -0,0 +1,180 @@
+#include "timeSeriesStore.h"
+
+#include <QtTest>
+
+/**
+ * @brief Tests of TimeSeriesStore and TimeSeriesHistory on generated samples, timestamps are mS from 0.
+ */
+class TimeSeriesStoreTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static GPUDataContainer sample(float temperature) {
+        GPUDataContainer data;
+        data.insert(ValueID::TEMPERATURE_CURRENT, RPValue(ValueUnit::CELSIUS, temperature));
+        return data;
+    }
+
+private slots:
+    // buffers are allocated with the first sample of a value, a full store overwrites the oldest samples
+    void memoryBound() {
+        TimeSeriesStore store(100);
+        QCOMPARE(store.memoryUsage(), 100 * (sizeof(qint64) + sizeof(quint32)));
+
+        store.append(0, sample(0));
+        const size_t allocated = store.memoryUsage();
+        QCOMPARE(allocated, 100 * (sizeof(qint64) + sizeof(quint32) + sizeof(float)));
+
+        for (int i = 1; i < 1000; ++i) {
+            store.append(i * 1000, sample(i));
+            QCOMPARE(store.memoryUsage(), allocated);
+        }
+
+        QCOMPARE(store.count(), 100);
+        QCOMPARE(store.timestamp(0), 900000LL);
+        QCOMPARE(store.lastTimestamp(), 999000LL);
+        QCOMPARE(store.indexAfter(949500), 50);
+
+        // order is kept across the wrap
+        for (int i = 0; i < store.count(); ++i)
+            QCOMPARE(store.value(ValueID::TEMPERATURE_CURRENT, i), static_cast<float>(900 + i));
+
+        // a value which comes later gets its buffer once, samples before it don't have it
+        GPUDataContainer withClock = sample(1000);
+        withClock.insert(ValueID::CLK_CORE, RPValue(ValueUnit::MEGAHERTZ, 1340));
+
+        for (int i = 1000; i < 1300; ++i) {
+            store.append(i * 1000, withClock);
+            QCOMPARE(store.memoryUsage(), allocated + 100 * sizeof(float));
+        }
+
+        QVERIFY(store.hasValue(ValueID::CLK_CORE, 0));
+        store.append(1300000, sample(0));
+        QVERIFY(!store.hasValue(ValueID::CLK_CORE, store.count() - 1));
+        QCOMPARE(store.memoryUsage(), allocated + 100 * sizeof(float));
+    }
+
+    // every tier stops growing when it is full, however long the history runs
+    void historyMemoryBound() {
+        TimeSeriesHistory history;
+
+        size_t full = 0;
+        for (int t = 0; t < TimeSeriesHistory::TIER_COUNT; ++t) {
+            const TimeSeriesStore &store = history.tier(static_cast<TimeSeriesHistory::Tier>(t));
+            full += store.capacity() * (sizeof(qint64) + sizeof(quint32) + (store.isRollup() ? 3 : 1) * sizeof(float));
+        }
+
+        // one sample a minute, so every sample closes a bucket of both rollups
+        const int samples = HISTORY_ROLLUP_1MIN_CAPACITY + 100;
+
+        for (int i = 0; i < samples; ++i)
+            history.append(static_cast<qint64>(i) * 60000, sample(i % 100));
+
+        QCOMPARE(history.memoryUsage(), full);
+
+        for (int i = samples; i < samples + 1000; ++i)
+            history.append(static_cast<qint64>(i) * 60000, sample(i % 100));
+
+        QCOMPARE(history.memoryUsage(), full);
+
+        for (int t = 0; t < TimeSeriesHistory::TIER_COUNT; ++t) {
+            const TimeSeriesStore &store = history.tier(static_cast<TimeSeriesHistory::Tier>(t));
+            QCOMPARE(store.count(), store.capacity());
+        }
+    }
+
+    // rollups keep average, minimum and maximum of the samples of every bucket, values missing in some samples
+    // are averaged over the samples which have them
+    void tierAggregation() {
+        TimeSeriesHistory history;
+        QVector<float> temperatures, clocks;
+
+        // 30 min at 1 s, clock only in odd seconds
+        for (int i = 0; i < 1800; ++i) {
+            const float temperature = 40 + (i * 7919) % 37 + 0.25f;
+            GPUDataContainer data = sample(temperature);
+            temperatures.append(temperature);
+
+            if (i % 2 == 1) {
+                data.insert(ValueID::CLK_CORE, RPValue(ValueUnit::MEGAHERTZ, 300 + i));
+                clocks.append(300 + i);
+            } else
+                clocks.append(-1);
+
+            history.append(static_cast<qint64>(i) * 1000, data);
+        }
+
+        const int bucketSeconds[] = { 10, 60 };
+        const TimeSeriesHistory::Tier tiers[] = { TimeSeriesHistory::ROLLUP_10S, TimeSeriesHistory::ROLLUP_1MIN };
+
+        for (int t = 0; t < 2; ++t) {
+            const TimeSeriesStore &store = history.tier(tiers[t]);
+            const int seconds = bucketSeconds[t];
+
+            // the last bucket is stored with the first sample of the next one
+            QCOMPARE(store.count(), 1800 / seconds - 1);
+
+            for (int b = 0; b < store.count(); ++b) {
+                QCOMPARE(store.timestamp(b), static_cast<qint64>(b) * seconds * 1000);
+
+                double temperatureSum = 0, clockSum = 0;
+                float temperatureMin = 1000, temperatureMax = -1000, clockMin = 10000, clockMax = -1;
+                int clockCount = 0;
+
+                for (int i = b * seconds; i < (b + 1) * seconds; ++i) {
+                    temperatureSum += temperatures.at(i);
+                    temperatureMin = qMin(temperatureMin, temperatures.at(i));
+                    temperatureMax = qMax(temperatureMax, temperatures.at(i));
+
+                    if (clocks.at(i) != -1) {
+                        clockSum += clocks.at(i);
+                        clockMin = qMin(clockMin, clocks.at(i));
+                        clockMax = qMax(clockMax, clocks.at(i));
+                        ++clockCount;
+                    }
+                }
+
+                QCOMPARE(store.value(ValueID::TEMPERATURE_CURRENT, b), static_cast<float>(temperatureSum / seconds));
+                QCOMPARE(store.minimum(ValueID::TEMPERATURE_CURRENT, b), temperatureMin);
+                QCOMPARE(store.maximum(ValueID::TEMPERATURE_CURRENT, b), temperatureMax);
+
+                QVERIFY(store.hasValue(ValueID::CLK_CORE, b));
+                QCOMPARE(store.value(ValueID::CLK_CORE, b), static_cast<float>(clockSum / clockCount));
+                QCOMPARE(store.minimum(ValueID::CLK_CORE, b), clockMin);
+                QCOMPARE(store.maximum(ValueID::CLK_CORE, b), clockMax);
+            }
+        }
+    }
+
+    // the raw tier holds HISTORY_RAW_DURATION at any interval, the newest samples survive a resize
+    void rawCapacityFollowsInterval() {
+        TimeSeriesHistory history;
+        QCOMPARE(history.tier(TimeSeriesHistory::RAW).capacity(), HISTORY_RAW_DURATION);
+
+        for (int i = 0; i < 5000; ++i)
+            history.append(static_cast<qint64>(i) * 1000, sample(i));
+
+        history.setSamplingInterval(100);
+        const TimeSeriesStore &raw = history.tier(TimeSeriesHistory::RAW);
+        QCOMPARE(raw.capacity(), HISTORY_RAW_DURATION * 10);
+        QCOMPARE(raw.count(), HISTORY_RAW_DURATION);
+        QCOMPARE(raw.timestamp(0), static_cast<qint64>(5000 - HISTORY_RAW_DURATION) * 1000);
+
+        history.append(5000000, sample(5000));
+        QCOMPARE(raw.lastTimestamp(), 5000000LL);
+
+        history.setSamplingInterval(5000);
+        QCOMPARE(raw.capacity(), HISTORY_RAW_DURATION / 5);
+        QCOMPARE(raw.count(), HISTORY_RAW_DURATION / 5);
+
+        for (int i = 0; i < raw.count(); ++i)
+            QCOMPARE(raw.value(ValueID::TEMPERATURE_CURRENT, i), static_cast<float>(5001 - HISTORY_RAW_DURATION / 5 + i));
+
+        history.setSamplingInterval(1);
+        QCOMPARE(raw.capacity(), HISTORY_RAW_MAX_CAPACITY);
+    }
+};
+
+QTEST_GUILESS_MAIN(TimeSeriesStoreTest)
+#include "tst_timeSeriesStore.moc"
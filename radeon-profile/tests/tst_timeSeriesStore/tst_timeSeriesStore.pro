@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_timeSeriesStore
+
+SOURCES += tst_timeSeriesStore.cpp \
+    ../../timeSeriesStore.cpp
+
+HEADERS += ../../timeSeriesStore.h
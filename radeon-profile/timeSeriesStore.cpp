@@ -0,0 +1,231 @@
+#include "timeSeriesStore.h"
+
+TimeSeriesStore::TimeSeriesStore(int capacity, int bucketMsec) :
+    cap(qMax(0, capacity)),
+    first(0),
+    size(0),
+    bucketLength(qMax(0, bucketMsec)),
+    timestamps(cap),
+    presence(cap),
+    bucketStart(-1),
+    bucketMask(0),
+    accumulators() {
+}
+
+int TimeSeriesStore::nextSlot() {
+    if (size < cap)
+        return physical(size++);
+
+    // full, the oldest sample is overwritten
+    const int slot = first;
+    first = physical(1);
+    return slot;
+}
+
+void TimeSeriesStore::append(qint64 timestamp, const GPUDataContainer &data, quint32 ids) {
+    float values[ValueID::VALUE_ID_COUNT];
+    quint32 presence = 0;
+
+    for (const ValueID id : GPUDataContainer::IdRange { data.presentIds().mask & ids }) {
+        values[id] = data.value(id).value;
+        presence |= 1u << id;
+    }
+
+    append(timestamp, presence, values);
+}
+
+void TimeSeriesStore::append(qint64 timestamp, quint32 presence, const float *values) {
+    if (cap == 0 || (size > 0 && timestamp < lastTimestamp()))
+        return;
+
+    if (isRollup()) {
+        accumulate(timestamp, presence, values);
+        return;
+    }
+
+    const int slot = nextSlot();
+
+    for (const ValueID id : GPUDataContainer::IdRange { presence }) {
+        if (this->values[id].empty())
+            this->values[id].resize(cap);
+
+        this->values[id][slot] = values[id];
+    }
+
+    timestamps[slot] = timestamp;
+    this->presence[slot] = presence;
+}
+
+void TimeSeriesStore::accumulate(qint64 timestamp, quint32 presence, const float *values) {
+    const qint64 bucket = timestamp - timestamp % bucketLength;
+
+    if (bucket < bucketStart)
+        return;
+
+    if (bucket != bucketStart) {
+        if (bucketStart != -1)
+            storeBucket();
+
+        bucketStart = bucket;
+        bucketMask = 0;
+    }
+
+    for (const ValueID id : GPUDataContainer::IdRange { presence }) {
+        const float value = values[id];
+        Accumulator &a = accumulators[id];
+
+        if (!(bucketMask & (1u << id))) {
+            a.sum = value;
+            a.min = a.max = value;
+            a.count = 1;
+            bucketMask |= 1u << id;
+            continue;
+        }
+
+        a.sum += value;
+        a.min = qMin(a.min, value);
+        a.max = qMax(a.max, value);
+        ++a.count;
+    }
+}
+
+void TimeSeriesStore::storeBucket() {
+    const int slot = nextSlot();
+
+    for (const ValueID id : GPUDataContainer::IdRange { bucketMask }) {
+        if (values[id].empty()) {
+            values[id].resize(cap);
+            minValues[id].resize(cap);
+            maxValues[id].resize(cap);
+        }
+
+        const Accumulator &a = accumulators[id];
+        values[id][slot] = a.sum / a.count;
+        minValues[id][slot] = a.min;
+        maxValues[id][slot] = a.max;
+    }
+
+    timestamps[slot] = bucketStart;
+    presence[slot] = bucketMask;
+}
+
+void TimeSeriesStore::clear() {
+    first = size = 0;
+    bucketStart = -1;
+    bucketMask = 0;
+}
+
+template <typename T>
+void TimeSeriesStore::resizeBuffer(std::vector<T> &buffer, int capacity, int skipped, int kept) const {
+    // not allocated yet, value never appended
+    if (buffer.empty())
+        return;
+
+    std::vector<T> resized(capacity);
+
+    for (int i = 0; i < kept; ++i)
+        resized[i] = buffer[physical(skipped + i)];
+
+    buffer.swap(resized);
+}
+
+void TimeSeriesStore::setCapacity(int capacity) {
+    capacity = qMax(0, capacity);
+
+    if (capacity == cap)
+        return;
+
+    const int kept = qMin(size, capacity), skipped = size - kept;
+
+    resizeBuffer(timestamps, capacity, skipped, kept);
+    resizeBuffer(presence, capacity, skipped, kept);
+
+    // were empty if the store had no capacity
+    timestamps.resize(capacity);
+    presence.resize(capacity);
+
+    for (int id = 0; id < ValueID::VALUE_ID_COUNT; ++id) {
+        resizeBuffer(values[id], capacity, skipped, kept);
+        resizeBuffer(minValues[id], capacity, skipped, kept);
+        resizeBuffer(maxValues[id], capacity, skipped, kept);
+    }
+
+    cap = capacity;
+    first = 0;
+    size = kept;
+}
+
+int TimeSeriesStore::indexAfter(qint64 timestamp) const {
+    // timestamps only grow, so binary search over the logical order
+    int low = 0, high = size;
+
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+
+        if (this->timestamp(middle) > timestamp)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+
+    return low;
+}
+
+size_t TimeSeriesStore::memoryUsage() const {
+    size_t bytes = timestamps.size() * sizeof(qint64) + presence.size() * sizeof(quint32);
+
+    for (int id = 0; id < ValueID::VALUE_ID_COUNT; ++id)
+        bytes += (values[id].size() + minValues[id].size() + maxValues[id].size()) * sizeof(float);
+
+    return bytes;
+}
+
+
+static int rawCapacity(int msec) {
+    return qBound(1, HISTORY_RAW_DURATION * 1000 / qMax(1, msec), HISTORY_RAW_MAX_CAPACITY);
+}
+
+TimeSeriesHistory::TimeSeriesHistory() {
+    tiers[RAW] = TimeSeriesStore(rawCapacity(1000));
+    tiers[ROLLUP_10S] = TimeSeriesStore(HISTORY_ROLLUP_10S_CAPACITY, 10000);
+    tiers[ROLLUP_1MIN] = TimeSeriesStore(HISTORY_ROLLUP_1MIN_CAPACITY, 60000);
+}
+
+void TimeSeriesHistory::append(qint64 timestamp, const GPUDataContainer &data, quint32 ids) {
+    for (TimeSeriesStore &t : tiers)
+        t.append(timestamp, data, ids);
+}
+
+void TimeSeriesHistory::append(qint64 timestamp, quint32 presence, const float *values) {
+    for (TimeSeriesStore &t : tiers)
+        t.append(timestamp, presence, values);
+}
+
+void TimeSeriesHistory::clear() {
+    for (TimeSeriesStore &t : tiers)
+        t.clear();
+}
+
+void TimeSeriesHistory::setSamplingInterval(int msec) {
+    tiers[RAW].setCapacity(rawCapacity(msec));
+}
+
+const TimeSeriesStore& TimeSeriesHistory::tierFor(qint64 start) const {
+    // coarser tiers start with a bucket before the first sample, so a tier which has not
+    // lost anything is the best one even if it doesn't reach start
+    for (const TimeSeriesStore &t : tiers) {
+        if (t.count() < t.capacity() || t.timestamp(0) <= start)
+            return t;
+    }
+
+    return tiers[TIER_COUNT - 1];
+}
+
+size_t TimeSeriesHistory::memoryUsage() const {
+    size_t bytes = 0;
+
+    for (const TimeSeriesStore &t : tiers)
+        bytes += t.memoryUsage();
+
+    return bytes;
+}
@@ -0,0 +1,207 @@
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+#include "globalStuff.h"
+
+#include <vector>
+
+// tiers of TimeSeriesHistory, raw is in samples, rollups in buckets
+#define HISTORY_RAW_DURATION 3600  // s, raw capacity follows the sampling interval
+#define HISTORY_RAW_MAX_CAPACITY 36000  // 1 hour at 100 mS, shorter intervals keep less
+#define HISTORY_ROLLUP_10S_CAPACITY 8640  // 24 hours
+#define HISTORY_ROLLUP_1MIN_CAPACITY 10080  // 7 days
+
+/**
+ * @brief The TimeSeriesStore class keeps history of values of one card, in fixed capacity ring buffers.
+ * Timestamps and presence masks of samples are stored once, every ValueID has its own buffer of floats,
+ * allocated with the first sample which has it, so memory is capacity * (timestamp + mask + 4 B per field),
+ * three times the floats for a rollup.
+ * When full, new samples overwrite the oldest ones, nothing is allocated or moved after that.
+ * Plots read from the store, so plots with the same values share one history instead of a copy each.
+ *
+ * A rollup store keeps one sample per time bucket with minimum, average and maximum of what was appended
+ * in it, computed on append. A bucket is stored when the first sample of the next one comes.
+ */
+class TimeSeriesStore
+{
+public:
+    /**
+     * @param capacity Number of samples (or buckets) kept.
+     * @param bucketMsec Length of a bucket in mS, 0 keeps every sample as it is.
+     */
+    explicit TimeSeriesStore(int capacity = 0, int bucketMsec = 0);
+
+    /**
+     * @brief Add sample of values in data.
+     * @param timestamp Time of the sample, in mS since epoch, samples older than the last one are ignored.
+     * @param ids Bit of every ValueID to take from data, the others are left out as if data didn't have them
+     * (values not read in the tick, see GPUCardSample::sampledIds).
+     */
+    void append(qint64 timestamp, const GPUDataContainer &data, quint32 ids = ~0u);
+
+    /**
+     * @brief Add sample from an array of all values (e.g. a record of HistoryFile).
+     * @param presence Bit of every ValueID which has its value in values.
+     * @param values Values indexed by ValueID, VALUE_ID_COUNT of them.
+     */
+    void append(qint64 timestamp, quint32 presence, const float *values);
+
+    void clear();
+
+    /**
+     * @brief Change the number of samples kept, the newest ones which fit are kept in order.
+     * @note Reallocates every buffer, not for the sampling path.
+     */
+    void setCapacity(int capacity);
+
+    int capacity() const {
+        return cap;
+    }
+
+    int count() const {
+        return size;
+    }
+
+    bool isEmpty() const {
+        return size == 0;
+    }
+
+    bool isRollup() const {
+        return bucketLength != 0;
+    }
+
+    // length of a bucket in mS, 0 if not a rollup
+    int bucketMsec() const {
+        return bucketLength;
+    }
+
+    /**
+     * @brief Timestamp of sample, index 0 is the oldest one kept. For a rollup it is the start of the bucket.
+     */
+    qint64 timestamp(int index) const {
+        return timestamps[physical(index)];
+    }
+
+    qint64 lastTimestamp() const {
+        return size == 0 ? 0 : timestamp(size - 1);
+    }
+
+    /**
+     * @brief Check if the sample has the value of id, cards don't have every value and can lose one (e.g. fan).
+     */
+    bool hasValue(ValueID id, int index) const {
+        return (presence[physical(index)] & (1u << id)) != 0;
+    }
+
+    /**
+     * @brief Value of id in sample (average of the bucket for a rollup), valid only if hasValue().
+     */
+    float value(ValueID id, int index) const {
+        return values[id][physical(index)];
+    }
+
+    float minimum(ValueID id, int index) const {
+        return isRollup() ? minValues[id][physical(index)] : value(id, index);
+    }
+
+    float maximum(ValueID id, int index) const {
+        return isRollup() ? maxValues[id][physical(index)] : value(id, index);
+    }
+
+    /**
+     * @brief Index of the first sample newer than timestamp, count() if there is none.
+     */
+    int indexAfter(qint64 timestamp) const;
+
+    /**
+     * @brief Bytes allocated for samples.
+     */
+    size_t memoryUsage() const;
+
+private:
+    int cap, first, size, bucketLength;
+
+    std::vector<qint64> timestamps;
+    std::vector<quint32> presence;
+    std::vector<float> values[ValueID::VALUE_ID_COUNT],
+        minValues[ValueID::VALUE_ID_COUNT], maxValues[ValueID::VALUE_ID_COUNT];
+
+    // bucket of a rollup being filled
+    struct Accumulator {
+        double sum;
+        float min, max;
+        int count;
+    };
+
+    qint64 bucketStart;
+    quint32 bucketMask;
+    Accumulator accumulators[ValueID::VALUE_ID_COUNT];
+
+    int physical(int index) const {
+        const int p = first + index;
+        return p >= cap ? p - cap : p;
+    }
+
+    int nextSlot();
+
+    // new buffer of capacity with samples [skipped, skipped + kept) of buffer at its beginning
+    template <typename T>
+    void resizeBuffer(std::vector<T> &buffer, int capacity, int skipped, int kept) const;
+
+    void accumulate(qint64 timestamp, quint32 presence, const float *values);
+    void storeBucket();
+};
+
+/**
+ * @brief The TimeSeriesHistory class keeps history of one card in tiers: raw samples for the recent time,
+ * 10 s and 1 min rollups for hours and days. Every append goes to all tiers, so a long time range
+ * is read from a coarse tier with about as many samples as a short one from the raw tier.
+ * The raw tier holds HISTORY_RAW_DURATION of samples at the sampling interval, see setSamplingInterval().
+ */
+class TimeSeriesHistory
+{
+public:
+    enum Tier {
+        RAW,
+        ROLLUP_10S,
+        ROLLUP_1MIN,
+        TIER_COUNT
+    };
+
+    TimeSeriesHistory();
+
+    void append(qint64 timestamp, const GPUDataContainer &data, quint32 ids = ~0u);
+    void append(qint64 timestamp, quint32 presence, const float *values);
+    void clear();
+
+    /**
+     * @brief Size the raw tier for HISTORY_RAW_DURATION of samples (HISTORY_RAW_MAX_CAPACITY at most).
+     * @param msec Sampling interval in mS, 1 s until it is set.
+     */
+    void setSamplingInterval(int msec);
+
+    const TimeSeriesStore& tier(Tier t) const {
+        return tiers[t];
+    }
+
+    bool isEmpty() const {
+        return tiers[RAW].isEmpty();
+    }
+
+    qint64 lastTimestamp() const {
+        return tiers[RAW].lastTimestamp();
+    }
+
+    /**
+     * @brief Find the finest tier which has samples back to start (or has not lost any yet).
+     * @param start Timestamp of the oldest sample needed.
+     */
+    const TimeSeriesStore& tierFor(qint64 start) const;
+
+    size_t memoryUsage() const;
+
+private:
+    TimeSeriesStore tiers[TIER_COUNT];
+};
+
+#endif // TIMESERIESSTORE_H
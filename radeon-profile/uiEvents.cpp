@@ -13,6 +13,7 @@
 #include <QMessageBox>
 #include <QMenu>
 #include <QFileDialog>
+#include <QtMath>
 
 bool closeFromTrayMenu;
 
@@ -56,8 +57,7 @@ void radeon_profile::setPowerLevelFromCombo() {
 }
 
 void radeon_profile::resetMinMax() {
-    device.gpuData[ValueID::TEMPERATURE_MIN].setValue(device.gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
-    device.gpuData[ValueID::TEMPERATURE_MAX].setValue(device.gpuData.value(ValueID::TEMPERATURE_CURRENT).value);
+    device.resetMinMax();
 }
 
 void radeon_profile::setPowerLevel(int level) {
@@ -84,12 +84,10 @@ void radeon_profile::changeEvent(QEvent *event)
 
 void radeon_profile::gpuChanged()
 {
-    timer->stop();
     device.changeGpu(ui->combo_gpus->currentIndex());
     setupUiEnabledFeatures(device.getDriverFeatures(), device.gpuData);
     mainTimerEvent();
     refreshBtnClicked();
-    timer->start();
 }
 
 void radeon_profile::iconActivated(QSystemTrayIcon::ActivationReason reason) {
@@ -122,15 +120,10 @@ void radeon_profile::closeEvent(QCloseEvent *e) {
     }
 
     // means app was initialized ok
-    if (timer != nullptr) {
-        timer->stop();
-        delete timer;
+    if (device.isInitialized())
+        device.finalize();
 
-        if (device.isInitialized())
-            device.finalize();
-
-        saveConfig();
-    }
+    saveConfig();
 
     QCoreApplication::processEvents(QEventLoop::AllEvents, 50); // Wait for the daemon to disable pwm
 
@@ -145,7 +138,7 @@ void radeon_profile::closeFromTray() {
 
 void radeon_profile::on_spin_timerInterval_valueChanged(double arg1)
 {
-    timer->setInterval(arg1*1000);
+    device.setSamplingInterval(arg1*1000);
 }
 
 void radeon_profile::refreshBtnClicked() {
@@ -259,7 +252,22 @@ void radeon_profile::on_btn_saveAll_clicked()
 
 void radeon_profile::on_slider_timeRange_valueChanged(int value)
 {
-    plotManager.setTimeRange(value);
+    const int seconds = timeRangeFromSlider(value);
+
+    plotManager.setTimeRange(seconds);
+    ui->slider_timeRange->setToolTip((seconds < 3600) ? QString::number(seconds / 60) + "m" : QString::number(seconds / 3600.0, 'f', 1) + "h");
+}
+
+int radeon_profile::timeRangeFromSlider(int position) {
+    return qRound(minPlotsTimeRange * qPow(static_cast<double>(maxPlotsTimeRange) / minPlotsTimeRange,
+                                           static_cast<double>(position) / plotsTimeRangeSteps));
+}
+
+int radeon_profile::sliderFromTimeRange(int seconds) {
+    seconds = qBound(minPlotsTimeRange, seconds, maxPlotsTimeRange);
+
+    return qRound(plotsTimeRangeSteps * qLn(static_cast<double>(seconds) / minPlotsTimeRange)
+                  / qLn(static_cast<double>(maxPlotsTimeRange) / minPlotsTimeRange));
 }
 
 void radeon_profile::on_cb_daemonData_clicked(bool checked)
@@ -281,7 +289,7 @@ void radeon_profile::on_cb_daemonData_clicked(bool checked)
 void radeon_profile::pauseRefresh(bool checked)
 {
     if (!checked) {
-        timer->start();
+        device.startSampling();
         return;
     }
 
@@ -295,7 +303,7 @@ void radeon_profile::pauseRefresh(bool checked)
     ui->btn_pwmAuto->click();
 
     if (checked)
-        timer->stop();
+        device.stopSampling();
 }
 
 void radeon_profile::on_btn_general_clicked()
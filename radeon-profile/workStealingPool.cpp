@@ -0,0 +1,126 @@
+#include "workStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int threadCount) :
+    batchId(0),
+    stopping(false),
+    remaining(0) {
+    for (int i = 0; i < threadCount; ++i)
+        workers.emplace_back(new Worker());
+
+    // all workers exist before any thread can try to steal
+    for (int i = 0; i < threadCount; ++i)
+        workers[i]->thread = std::thread(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        stopping = true;
+    }
+
+    batchStarted.notify_all();
+
+    for (auto &w : workers)
+        w->thread.join();
+}
+
+int WorkStealingPool::threadCount() const {
+    return workers.size();
+}
+
+void WorkStealingPool::run(std::vector<Task> &tasks) {
+    if (tasks.empty())
+        return;
+
+    if (workers.empty()) {
+        for (Task &t : tasks)
+            t();
+
+        return;
+    }
+
+    remaining = tasks.size();
+
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        Worker &w = *workers[i % workers.size()];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.queue.push_back(&tasks[i]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        ++batchId;
+    }
+
+    batchStarted.notify_all();
+
+    // the caller would only wait, so it steals as well
+    runTasks(-1);
+
+    std::unique_lock<std::mutex> lock(batchMutex);
+    batchFinished.wait(lock, [this]() { return remaining == 0; });
+}
+
+void WorkStealingPool::workerLoop(int index) {
+    unsigned long long seenBatch = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(batchMutex);
+            batchStarted.wait(lock, [this, seenBatch]() { return stopping || batchId != seenBatch; });
+
+            if (stopping)
+                return;
+
+            seenBatch = batchId;
+        }
+
+        runTasks(index);
+    }
+}
+
+void WorkStealingPool::runTasks(int index) {
+    Task *task;
+
+    while (takeTask(index, &task)) {
+        (*task)();
+
+        if (--remaining == 0) {
+            // under the mutex, so the notification can't fall between the check and the wait in run()
+            std::lock_guard<std::mutex> lock(batchMutex);
+            batchFinished.notify_all();
+        }
+    }
+}
+
+// own queue from the front, then the others from the back; index -1 has no own queue
+bool WorkStealingPool::takeTask(int index, Task **task) {
+    if (index >= 0) {
+        Worker &own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.queue.empty()) {
+            *task = own.queue.front();
+            own.queue.pop_front();
+            return true;
+        }
+    }
+
+    const int count = workers.size();
+    for (int i = 1; i <= count; ++i) {
+        const int victim = (index + i + count) % count;
+        if (victim == index)
+            continue;
+
+        Worker &w = *workers[victim];
+        std::lock_guard<std::mutex> lock(w.mutex);
+
+        if (!w.queue.empty()) {
+            *task = w.queue.back();
+            w.queue.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
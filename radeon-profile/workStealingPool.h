@@ -0,0 +1,61 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The WorkStealingPool class runs batches of short independent tasks on a small fixed set of threads.
+ * Tasks of a batch are dealt round-robin to per-thread queues, a thread with an empty queue steals from
+ * the back of the others, so one slow task (a slow sysfs read) doesn't hold the tasks queued behind it.
+ * run() is a barrier, it returns when every task of the batch has finished.
+ */
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @brief Start the threads.
+     * @param threadCount Number of threads, the thread calling run() works as well.
+     */
+    explicit WorkStealingPool(int threadCount);
+    ~WorkStealingPool();
+
+    /**
+     * @brief Run all tasks and wait until they are finished.
+     * @note Only from one thread at a time, tasks must not call run().
+     * @param tasks Tasks of the batch, must stay valid until return.
+     */
+    void run(std::vector<Task> &tasks);
+
+    int threadCount() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task*> queue;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex batchMutex;
+    std::condition_variable batchStarted, batchFinished;
+    unsigned long long batchId;
+    bool stopping;
+
+    std::atomic<int> remaining;
+
+    void workerLoop(int index);
+    bool takeTask(int index, Task **task);
+    void runTasks(int index);
+};
+
+#endif // WORKSTEALINGPOOL_H